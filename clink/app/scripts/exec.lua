@@ -65,14 +65,8 @@ end
 
 --------------------------------------------------------------------------------
 local function get_environment_paths()
-    local paths = (os.getenv("path") or ""):explode(";")
-
-    -- Append slashes.
-    for i = 1, #paths, 1 do
-        paths[i] = paths[i].."\\"
-    end
-
-    return paths
+    -- The directories are already parsed and have trailing slashes.
+    return os._getpathdirs()
 end
 
 --------------------------------------------------------------------------------
@@ -209,13 +203,40 @@ local function exec_matches(line_state, match_builder, chained, no_aliases)
 
     -- Search 'paths' for files ending in executable extensions (and/or
     -- registered file associations) and look for matches.
-    local suffices = (os.getenv("pathext") or ""):explode(";")
-    for _, suffix in ipairs(suffices) do
-        associations[suffix:lower()] = true
+    for _, suffix in ipairs(os._getpathexts()) do
+        associations[suffix] = true
     end
     local include_associations = settings.get("exec.associations")
-    for _, dir in ipairs(paths) do
-        added = add_files_by_association(dir.."*", false, include_associations) or added
+    local indexed
+    if #paths > 0 and not include_associations then
+        -- The executables index already holds the files in 'paths' whose
+        -- extensions are in %PATHEXT%, so the directories needn't be globbed.
+        indexed = os._getexecmatches({
+            hidden=settings.get("files.hidden") and rl.isvariabletrue("match-hidden-files"),
+            system=settings.get("files.system"),
+        })
+    end
+    if indexed then
+        local prefix = clink.lower(text)
+        local found_prefix = (prefix == "")
+        for _, m in ipairs(indexed) do
+            added = match_builder:addmatch(m) or added
+            if not found_prefix and clink.lower(m.match:sub(1, #prefix)) == prefix then
+                found_prefix = true
+            end
+        end
+        -- The index is rebuilt at most every couple of seconds, so it can
+        -- miss executables created since then.  When nothing in the index
+        -- matches the word being completed, probe the directories directly.
+        if not found_prefix then
+            for _, dir in ipairs(paths) do
+                added = add_files_by_association(dir..text.."*", false, include_associations) or added
+            end
+        end
+    else
+        for _, dir in ipairs(paths) do
+            added = add_files_by_association(dir.."*", false, include_associations) or added
+        end
     end
 
     -- Should we also consider the path referenced by 'text'?
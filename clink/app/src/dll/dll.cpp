@@ -8,6 +8,7 @@
 #include "utils/usage.h"
 
 #include <core/base.h>
+#include <core/exec_index.h>
 #include <core/globber.h>
 #include <core/log.h>
 #include <core/os.h>
@@ -73,6 +74,7 @@ static void shutdown_clink()
 
     shutdown_task_manager(true/*final*/);
     shutdown_recognizer();
+    exec_index::shutdown();
 
     if (logger* logger = logger::get())
         delete logger;
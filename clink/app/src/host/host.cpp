@@ -8,6 +8,9 @@
 #include <core/globber.h>
 #include <core/os.h>
 #include <core/cwd_restorer.h>
+#include <core/alias_snapshot.h>
+#include <core/env_snapshot.h>
+#include <core/exec_index.h>
 #include <core/path.h>
 #include <core/settings.h>
 #include <core/str.h>
@@ -737,7 +740,9 @@ bool host::edit_line(const char* prompt, const char* rprompt, str_base& out, boo
     }
 #endif
 
-    path::refresh_pathext();
+    env_snapshot::refresh();
+    exec_index::refresh();
+    alias_snapshot::refresh();
 
     os::cwd_restorer cwd;
 
@@ -3,6 +3,8 @@
 
 #include "pch.h"
 #include "host_lua.h"
+#include "script_image.h"
+#include "script_manifest.h"
 #include "utils/app_context.h"
 
 #include <core/globber.h>
@@ -23,6 +25,24 @@ extern "C" {
 #include <lua.h>
 }
 
+//------------------------------------------------------------------------------
+static setting_bool g_lua_defer_argmatchers(
+    "lua.defer_argmatchers",
+    "Load argmatcher scripts on demand",
+    "When enabled, scripts that only define argmatchers are not loaded at\n"
+    "startup; instead they are loaded the first time one of their commands is\n"
+    "used.  Clink learns which scripts qualify by watching what each script does\n"
+    "the first time it is loaded, and remembers that until the script changes.",
+    true);
+
+static setting_bool g_lua_cache_bytecode(
+    "lua.cache_bytecode",
+    "Cache compiled Lua scripts",
+    "When enabled, the compiled bytecode for each script is saved in an image\n"
+    "file in the state directory, so that new sessions can skip parsing scripts\n"
+    "that haven't changed.  The image is discarded whenever Clink is updated.",
+    true);
+
 //------------------------------------------------------------------------------
 namespace host_lua_callbacks {
 
@@ -86,6 +106,11 @@ host_lua::host_lua()
     lua_setglobal(state, "CLINK_EXE");
 }
 
+//------------------------------------------------------------------------------
+host_lua::~host_lua()
+{
+}
+
 //------------------------------------------------------------------------------
 host_lua::operator lua_state& ()
 {
@@ -153,6 +178,30 @@ bool host_lua::load_scripts(const char* paths)
     os::high_resolution_clock clock;
     unsigned num_loaded = 0;
     unsigned num_failed = 0;
+    unsigned num_deferred = 0;
+
+    // The manifest records what each script did the last time it was loaded,
+    // so that scripts which only define argmatchers can be deferred.
+    str<280> manifest_file;
+    script_manifest manifest;
+    const bool use_manifest = g_lua_defer_argmatchers.get();
+    if (use_manifest)
+    {
+        app_context::get()->get_state_dir(manifest_file);
+        path::append(manifest_file, "clink_script_manifest");
+        manifest.load(manifest_file.c_str());
+    }
+
+    // The image holds precompiled bytecode for scripts that haven't changed.
+    str<280> image_file;
+    std::unique_ptr<script_image> image;
+    if (g_lua_cache_bytecode.get())
+    {
+        image = std::make_unique<script_image>();
+        app_context::get()->get_state_dir(image_file);
+        path::append(image_file, "clink_script_image");
+        image->load(image_file.c_str());
+    }
 
     bool first = true;
 
@@ -199,19 +248,44 @@ bool host_lua::load_scripts(const char* paths)
         seen.emplace(out.c_str());
         seen_strings.emplace_back(std::move(out));
 
-        load_script(tmp.c_str(), num_loaded, num_failed);
+        load_script(tmp.c_str(), num_loaded, num_failed, num_deferred, use_manifest ? &manifest : nullptr, image.get());
+    }
+
+    if (use_manifest && manifest.is_dirty())
+        manifest.save(manifest_file.c_str());
+    if (image && image->is_dirty())
+        image->save(image_file.c_str());
+
+    // Deferred scripts are loaded through the same path as the others, and
+    // can still use the image's bytecode.
+    if (num_deferred)
+    {
+        lua_State* state = m_state.get_state();
+        save_stack_top ss(state);
+        lua_getglobal(state, "clink");
+        lua_pushliteral(state, "_load_deferred_script");
+        lua_pushlightuserdata(state, this);
+        lua_pushcclosure(state, &host_lua::load_deferred_script, 1);
+        lua_rawset(state, -3);
+        m_image = std::move(image);
+        m_image_file = image_file.c_str();
+    }
+    else
+    {
+        m_image.reset();
+        m_image_file.clear();
     }
 
     if (num_failed)
-        LOG("Loaded %u Lua scripts in %u ms (%u failed)", num_loaded, unsigned(clock.elapsed() * 1000), num_failed);
+        LOG("Loaded %u Lua scripts in %u ms (%u failed, %u deferred)", num_loaded, unsigned(clock.elapsed() * 1000), num_failed, num_deferred);
     else
-        LOG("Loaded %u Lua scripts in %u ms", num_loaded, unsigned(clock.elapsed() * 1000));
+        LOG("Loaded %u Lua scripts in %u ms (%u deferred)", num_loaded, unsigned(clock.elapsed() * 1000), num_deferred);
 
     return true;
 }
 
 //------------------------------------------------------------------------------
-void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num_failed)
+void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num_failed, unsigned& num_deferred, script_manifest* manifest, script_image* image)
 {
     str_moveable buffer;
     path::join(path, "*.lua", buffer);
@@ -219,7 +293,8 @@ void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num
     globber lua_globs(buffer.c_str());
     lua_globs.directories(false);
 
-    while (lua_globs.next(buffer))
+    globber::extrainfo info;
+    while (lua_globs.next(buffer, true, &info))
     {
         const char* s = path::get_name(buffer.c_str());
         if (stricmp(s, "clink.lua") == 0)
@@ -247,13 +322,154 @@ void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num
             continue;
 #endif
 
-        if (m_state.do_file(buffer.c_str()))
+        bool ok;
+        if (!manifest)
+        {
+            ok = run_script(buffer.c_str(), info, image);
+        }
+        else if (const script_manifest::entry* e = manifest->find(buffer.c_str(), info.modified, info.size))
+        {
+            if (e->is_deferrable())
+            {
+                if (image)
+                    image->keep(buffer.c_str(), info.modified, info.size);
+                defer_script(buffer.c_str(), e->names);
+                num_deferred++;
+                continue;
+            }
+            ok = run_script(buffer.c_str(), info, image);
+        }
+        else
+        {
+            str_moveable kinds;
+            std::vector<str_moveable> names;
+            ok = record_script(buffer.c_str(), info, image, kinds, names);
+            manifest->update(buffer.c_str(), info.modified, info.size, ok ? kinds.c_str() : "failed", std::move(names));
+        }
+
+        if (ok)
             num_loaded++;
         else
             num_failed++;
     }
 }
 
+//------------------------------------------------------------------------------
+// Runs a script, from its cached bytecode if the image has a current copy.
+// Otherwise the script is compiled from source and the image is updated.
+bool host_lua::run_script(const char* file, const globber::extrainfo& info, script_image* image)
+{
+    if (!image)
+        return m_state.do_file(file);
+
+    const char* chunk = nullptr;
+    uint32 chunk_len = 0;
+    image->find(file, info.modified, info.size, chunk, chunk_len);
+
+    std::vector<char> compiled;
+    const bool ok = m_state.do_file(file, chunk, chunk_len, &compiled);
+    if (!compiled.empty())
+        image->update(file, info.modified, info.size, std::move(compiled));
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// Loads a script while recording what it does.  Kinds receives a comma
+// separated list of what the script did besides registering argmatchers, and
+// names receives the commands it registered argmatchers for.
+bool host_lua::record_script(const char* file, const globber::extrainfo& info, script_image* image, str_base& kinds, std::vector<str_moveable>& names)
+{
+    lua_State* state = m_state.get_state();
+    save_stack_top ss(state);
+
+    kinds = "unknown";
+    names.clear();
+
+    if (!lua_state::push_named_function(state, "clink._begin_script_record") ||
+        m_state.pcall(0, 0) != 0)
+        return run_script(file, info, image);
+
+    const bool ok = run_script(file, info, image);
+
+    if (!lua_state::push_named_function(state, "clink._end_script_record") ||
+        m_state.pcall(0, 2) != 0)
+        return ok;
+
+    if (lua_isstring(state, -2))
+        kinds = lua_tostring(state, -2);
+
+    if (lua_istable(state, -1))
+    {
+        const int32 count = int32(lua_rawlen(state, -1));
+        for (int32 i = 1; i <= count; ++i)
+        {
+            lua_rawgeti(state, -1, i);
+            if (const char* name = lua_tostring(state, -1))
+                names.emplace_back(name);
+            lua_pop(state, 1);
+        }
+    }
+
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+void host_lua::defer_script(const char* file, const std::vector<str_moveable>& names)
+{
+    lua_State* state = m_state.get_state();
+    save_stack_top ss(state);
+
+    if (!lua_state::push_named_function(state, "clink._defer_script"))
+        return;
+
+    lua_pushstring(state, file);
+    for (const auto& name : names)
+        lua_pushlstring(state, name.c_str(), name.length());
+
+    m_state.pcall(1 + int32(names.size()), 0);
+}
+
+//------------------------------------------------------------------------------
+// Replaces clink._load_deferred_script, so deferred scripts are loaded like
+// scripts at startup, including using the image's bytecode.
+int32 host_lua::load_deferred_script(lua_State* L)
+{
+    const char* file = checkstring(L, 1);
+    if (!file)
+        return 0;
+
+    host_lua* self = static_cast<host_lua*>(lua_touserdata(L, lua_upvalueindex(1)));
+
+    const char* chunk = nullptr;
+    uint32 chunk_len = 0;
+    script_image* image = nullptr;
+    globber::extrainfo info;
+    if (self && self->m_image)
+    {
+        // The image is keyed by the file's current timestamp and size.
+        str<280> tmp;
+        globber file_glob(file);
+        file_glob.directories(false);
+        if (file_glob.next(tmp, true, &info))
+        {
+            image = self->m_image.get();
+            image->find(file, info.modified, info.size, chunk, chunk_len);
+        }
+    }
+
+    std::vector<char> compiled;
+    lua_pushboolean(L, lua_state::do_file(L, file, chunk, chunk_len, image ? &compiled : nullptr));
+
+    // The image was already saved at startup, so save it again to include
+    // the newly compiled script.
+    if (!compiled.empty())
+    {
+        image->update(file, info.modified, info.size, std::move(compiled));
+        image->save(self->m_image_file.c_str());
+    }
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 bool host_lua::is_script_path_changed() const
 {
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <core/globber.h>
 #include <core/str.h>
 #include <lua/lua_match_generator.h>
 #include <lua/lua_hinter.h>
@@ -10,12 +11,18 @@
 #include <lua/lua_input_idle.h>
 #include <lua/lua_state.h>
 #include <functional>
+#include <memory>
+#include <vector>
+
+class script_image;
+class script_manifest;
 
 //------------------------------------------------------------------------------
 class host_lua
 {
 public:
                         host_lua();
+                        ~host_lua();
                         operator lua_state& ();
                         operator match_generator& ();
                         operator hinter& ();
@@ -45,12 +52,18 @@ public:
 
 private:
     bool                load_scripts(const char* paths);
-    void                load_script(const char* path, unsigned& num_loaded, unsigned& num_failed);
+    void                load_script(const char* path, unsigned& num_loaded, unsigned& num_failed, unsigned& num_deferred, script_manifest* manifest, script_image* image);
+    bool                run_script(const char* file, const globber::extrainfo& info, script_image* image);
+    bool                record_script(const char* file, const globber::extrainfo& info, script_image* image, str_base& kinds, std::vector<str_moveable>& names);
+    void                defer_script(const char* file, const std::vector<str_moveable>& names);
+    static int32        load_deferred_script(lua_State* L);
     lua_state           m_state;
     lua_match_generator m_generator;
     lua_hinter          m_hinter;
     lua_word_classifier m_classifier;
     lua_input_idle      m_idle;
     str<>               m_prev_script_path;
+    std::unique_ptr<script_image> m_image;  // Kept for deferred scripts.
+    str_moveable        m_image_file;
     bool                m_loaded_scripts = false;
 };
@@ -0,0 +1,259 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "script_image.h"
+#include "version.h"
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/path.h>
+
+//------------------------------------------------------------------------------
+// Bytecode is only valid for the exact build that produced it, so the header
+// includes the full version (which includes the commit) and the architecture.
+static const char c_header[] = "clink_script_image 2 " CLINK_VERSION_STR " " AS_STR(ARCHITECTURE_NAME);
+
+//------------------------------------------------------------------------------
+// Each entry is:  name length, name, modified low, modified high, size, chunk
+// length, chunk hash, chunk.  Numbers are in native byte order, since the
+// image is only valid for the build that wrote it anyway.
+class image_reader
+{
+public:
+                    image_reader(const char* data, size_t len) : m_ptr(data), m_end(data + len) {}
+    bool            at_end() const { return m_ptr >= m_end; }
+    bool            read(void* out, size_t len);
+    const char*     skip(size_t len);
+
+private:
+    const char*     m_ptr;
+    const char*     m_end;
+};
+
+//------------------------------------------------------------------------------
+// FNV-1a.  Lua doesn't verify bytecode, so a chunk that was damaged on disk
+// must never reach the loader.
+static uint32 hash_chunk(const char* chunk, uint32 len)
+{
+    uint32 hash = 0x811c9dc5;
+    for (uint32 i = 0; i < len; ++i)
+    {
+        hash ^= uint8(chunk[i]);
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+bool image_reader::read(void* out, size_t len)
+{
+    const char* p = skip(len);
+    if (!p)
+        return false;
+    memcpy(out, p, len);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+const char* image_reader::skip(size_t len)
+{
+    if (size_t(m_end - m_ptr) < len)
+        return nullptr;
+    const char* p = m_ptr;
+    m_ptr += len;
+    return p;
+}
+
+
+
+//------------------------------------------------------------------------------
+bool script_image::load(const char* file)
+{
+    m_entries.clear();
+    m_index.clear();
+    m_buffer.clear();
+    m_dirty = false;
+
+    FILE* in = fopen(file, "rb");
+    if (!in)
+        return false;
+
+    fseek(in, 0, SEEK_END);
+    const long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    if (size < long(sizeof(c_header)))
+    {
+        fclose(in);
+        return false;
+    }
+
+    m_buffer.resize(size_t(size));
+    const size_t read = fread(m_buffer.data(), 1, m_buffer.size(), in);
+    fclose(in);
+
+    if (read != m_buffer.size() || memcmp(m_buffer.data(), c_header, sizeof(c_header)) != 0)
+    {
+        m_buffer.clear();
+        return false;
+    }
+
+    // Entries point into the buffer, so chunks aren't copied again.
+    image_reader reader(m_buffer.data() + sizeof(c_header), m_buffer.size() - sizeof(c_header));
+    while (!reader.at_end())
+    {
+        uint32 name_len;
+        const char* name;
+        FILETIME modified;
+        uint64 file_size;
+        uint32 chunk_len;
+        uint32 chunk_hash;
+        const char* chunk;
+        if (!reader.read(&name_len, sizeof(name_len)) ||
+            !(name = reader.skip(name_len)) ||
+            !reader.read(&modified.dwLowDateTime, sizeof(modified.dwLowDateTime)) ||
+            !reader.read(&modified.dwHighDateTime, sizeof(modified.dwHighDateTime)) ||
+            !reader.read(&file_size, sizeof(file_size)) ||
+            !reader.read(&chunk_len, sizeof(chunk_len)) ||
+            !reader.read(&chunk_hash, sizeof(chunk_hash)) ||
+            !(chunk = reader.skip(chunk_len)) ||
+            hash_chunk(chunk, chunk_len) != chunk_hash)
+        {
+            // A truncated or damaged image is discarded entirely.
+            m_entries.clear();
+            m_index.clear();
+            m_buffer.clear();
+            return false;
+        }
+
+        str<280> tmp;
+        tmp.concat(name, name_len);
+
+        entry* e = add(tmp.c_str());
+        e->modified = modified;
+        e->size = file_size;
+        e->chunk = chunk;
+        e->chunk_len = chunk_len;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool script_image::save(const char* file)
+{
+    str<280> dir;
+    path::get_directory(file, dir);
+
+    str_moveable tmp;
+    FILE* out = os::create_temp_file(&tmp, "image", ".tmp", os::binary, dir.c_str());
+    if (!out)
+        return false;
+
+    // Entries for scripts that weren't loaded are dropped.
+    fwrite(c_header, sizeof(c_header), 1, out);
+    for (const auto& e : m_entries)
+    {
+        if (!e->used || !e->chunk_len)
+            continue;
+
+        const uint32 name_len = e->file.length();
+        fwrite(&name_len, sizeof(name_len), 1, out);
+        fwrite(e->file.c_str(), name_len, 1, out);
+        fwrite(&e->modified.dwLowDateTime, sizeof(e->modified.dwLowDateTime), 1, out);
+        fwrite(&e->modified.dwHighDateTime, sizeof(e->modified.dwHighDateTime), 1, out);
+        fwrite(&e->size, sizeof(e->size), 1, out);
+        const uint32 chunk_hash = hash_chunk(e->chunk, e->chunk_len);
+        fwrite(&e->chunk_len, sizeof(e->chunk_len), 1, out);
+        fwrite(&chunk_hash, sizeof(chunk_hash), 1, out);
+        fwrite(e->chunk, e->chunk_len, 1, out);
+    }
+
+    const bool ok = !ferror(out);
+    fclose(out);
+
+    // Another session may be saving at the same time; whichever finishes
+    // last wins, which is fine for a cache.
+    if (ok)
+    {
+        os::unlink(file);
+        if (os::move(tmp.c_str(), file))
+        {
+            m_dirty = false;
+            return true;
+        }
+    }
+
+    os::unlink(tmp.c_str());
+    return false;
+}
+
+//------------------------------------------------------------------------------
+bool script_image::find(const char* file, const FILETIME& modified, uint64 size, const char*& chunk, uint32& chunk_len)
+{
+    const auto iter = m_index.find(file);
+    if (iter == m_index.end())
+        return false;
+
+    entry* e = iter->second;
+    if (CompareFileTime(&e->modified, &modified) != 0 || e->size != size || !e->chunk_len)
+        return false;
+
+    e->used = true;
+    chunk = e->chunk;
+    chunk_len = e->chunk_len;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void script_image::update(const char* file, const FILETIME& modified, uint64 size, std::vector<char>&& chunk)
+{
+    entry* e = add(file);
+    e->modified = modified;
+    e->size = size;
+    e->compiled = std::move(chunk);
+    e->chunk = e->compiled.data();
+    e->chunk_len = uint32(e->compiled.size());
+    e->used = true;
+    m_dirty = true;
+}
+
+//------------------------------------------------------------------------------
+// Keeps the entry for a script that wasn't run (e.g. because it was deferred),
+// so that saving doesn't drop it.
+void script_image::keep(const char* file, const FILETIME& modified, uint64 size)
+{
+    const char* chunk;
+    uint32 chunk_len;
+    find(file, modified, size, chunk, chunk_len);
+}
+
+//------------------------------------------------------------------------------
+bool script_image::is_dirty() const
+{
+    if (m_dirty)
+        return true;
+
+    for (const auto& e : m_entries)
+    {
+        if (!e->used)
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+script_image::entry* script_image::add(const char* file)
+{
+    const auto iter = m_index.find(file);
+    if (iter != m_index.end())
+        return iter->second;
+
+    auto e = std::make_unique<entry>();
+    e->file = file;
+    entry* ret = e.get();
+    m_index.emplace(ret->file.c_str(), ret);
+    m_entries.emplace_back(std::move(e));
+    return ret;
+}
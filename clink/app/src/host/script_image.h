@@ -0,0 +1,49 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+#include <core/str_unordered_set.h>
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Binary image of precompiled bytecode for Lua scripts, keyed by file name and
+// validated by the file's last write time and size.  The whole image is
+// invalidated by any change to the Clink build, or if any chunk doesn't match
+// its hash.  Chunks are read into memory
+// once, and are only turned into Lua functions as their scripts get loaded.
+class script_image
+{
+public:
+                            script_image() = default;
+                            script_image(const script_image&) = delete;
+
+    bool                    load(const char* file);
+    bool                    save(const char* file);
+    bool                    find(const char* file, const FILETIME& modified, uint64 size, const char*& chunk, uint32& chunk_len);
+    void                    update(const char* file, const FILETIME& modified, uint64 size, std::vector<char>&& chunk);
+    void                    keep(const char* file, const FILETIME& modified, uint64 size);
+    bool                    is_dirty() const;
+
+private:
+    struct entry
+    {
+        str_moveable        file;
+        FILETIME            modified = {};
+        uint64              size = 0;
+        const char*         chunk = nullptr; // Points into m_buffer or compiled.
+        uint32              chunk_len = 0;
+        std::vector<char>   compiled;
+        bool                used = false;
+    };
+
+    entry*                  add(const char* file);
+
+    std::vector<char>       m_buffer;
+    std::vector<std::unique_ptr<entry>> m_entries;
+    str_unordered_map<entry*> m_index;  // Keys point into m_entries.
+    bool                    m_dirty = false;
+};
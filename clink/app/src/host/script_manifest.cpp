@@ -0,0 +1,224 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "script_manifest.h"
+#include "version.h"
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/path.h>
+
+//------------------------------------------------------------------------------
+// The header includes the Clink version, since what counts as deferrable can
+// change between versions.
+static const char c_header[] = "clink_script_manifest 1 " CLINK_VERSION_STR;
+
+//------------------------------------------------------------------------------
+// Splits off the next tab separated field; returns nullptr at end of line.
+static char* next_field(char*& p)
+{
+    if (!p)
+        return nullptr;
+
+    char* field = p;
+    char* tab = strchr(p, '\t');
+    if (tab)
+    {
+        *tab = '\0';
+        p = tab + 1;
+    }
+    else
+    {
+        p = nullptr;
+    }
+    return field;
+}
+
+
+
+//------------------------------------------------------------------------------
+bool script_manifest::load(const char* file)
+{
+    m_entries.clear();
+    m_index.clear();
+    m_dirty = false;
+
+    FILE* in = fopen(file, "rb");
+    if (!in)
+        return false;
+
+    fseek(in, 0, SEEK_END);
+    const long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    str_moveable buffer;
+    if (size <= 0 || !buffer.reserve(uint32(size)))
+    {
+        fclose(in);
+        return false;
+    }
+
+    char* data = buffer.data();
+    const size_t read = fread(data, 1, size_t(size), in);
+    fclose(in);
+    data[read] = '\0';
+
+    bool header = true;
+    for (char* line = data; line && *line;)
+    {
+        char* eol = strchr(line, '\n');
+        if (eol)
+        {
+            *eol = '\0';
+            if (eol > line && eol[-1] == '\r')
+                eol[-1] = '\0';
+        }
+
+        if (header)
+        {
+            if (strcmp(line, c_header) != 0)
+                return false;
+            header = false;
+        }
+        else
+        {
+            char* p = line;
+            const char* modified = next_field(p);
+            const char* size = next_field(p);
+            const char* kinds = next_field(p);
+            const char* name = next_field(p);
+            if (name && *name)
+            {
+                entry* e = add(name);
+                const uint64 ft = _strtoui64(modified, nullptr, 16);
+                e->modified.dwLowDateTime = DWORD(ft);
+                e->modified.dwHighDateTime = DWORD(ft >> 32);
+                e->size = _strtoui64(size, nullptr, 10);
+                e->kinds = strcmp(kinds, "-") ? kinds : "";
+                while (const char* command = next_field(p))
+                    e->names.emplace_back(command);
+            }
+        }
+
+        line = eol ? eol + 1 : nullptr;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool script_manifest::save(const char* file)
+{
+    str<280> dir;
+    path::get_directory(file, dir);
+
+    str_moveable tmp;
+    FILE* out = os::create_temp_file(&tmp, "manifest", ".tmp", os::binary, dir.c_str());
+    if (!out)
+        return false;
+
+    // Entries for scripts that weren't seen during the load are dropped.
+    str<> line;
+    line.format("%s\n", c_header);
+    fwrite(line.c_str(), line.length(), 1, out);
+    for (const auto& e : m_entries)
+    {
+        if (!e->used)
+            continue;
+
+        const uint64 ft = (uint64(e->modified.dwHighDateTime) << 32) | e->modified.dwLowDateTime;
+        line.format("%016llx\t%llu\t%s\t%s", ft, e->size, e->kinds.empty() ? "-" : e->kinds.c_str(), e->file.c_str());
+        for (const auto& name : e->names)
+            line << "\t" << name.c_str();
+        line << "\n";
+        fwrite(line.c_str(), line.length(), 1, out);
+    }
+
+    const bool ok = !ferror(out);
+    fclose(out);
+
+    // Another session may be saving at the same time; whichever finishes
+    // last wins, which is fine for a cache.
+    if (ok)
+    {
+        os::unlink(file);
+        if (os::move(tmp.c_str(), file))
+        {
+            m_dirty = false;
+            return true;
+        }
+    }
+
+    os::unlink(tmp.c_str());
+    return false;
+}
+
+//------------------------------------------------------------------------------
+const script_manifest::entry* script_manifest::find(const char* file, const FILETIME& modified, uint64 size)
+{
+    const auto iter = m_index.find(file);
+    if (iter == m_index.end())
+        return nullptr;
+
+    entry* e = iter->second;
+    if (CompareFileTime(&e->modified, &modified) != 0 || e->size != size)
+        return nullptr;
+
+    e->used = true;
+    return e;
+}
+
+//------------------------------------------------------------------------------
+void script_manifest::update(const char* file, const FILETIME& modified, uint64 size, const char* kinds, std::vector<str_moveable>&& names)
+{
+    // A command name containing a tab can't be saved; don't defer the script.
+    for (const auto& name : names)
+    {
+        if (strchr(name.c_str(), '\t') || strchr(name.c_str(), '\n'))
+        {
+            kinds = "unsupported name";
+            break;
+        }
+    }
+
+    entry* e = add(file);
+    e->modified = modified;
+    e->size = size;
+    e->kinds = kinds;
+    e->names = std::move(names);
+    e->used = true;
+    m_dirty = true;
+}
+
+//------------------------------------------------------------------------------
+bool script_manifest::is_dirty() const
+{
+    if (m_dirty)
+        return true;
+
+    for (const auto& e : m_entries)
+    {
+        if (!e->used)
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+script_manifest::entry* script_manifest::add(const char* file)
+{
+    const auto iter = m_index.find(file);
+    if (iter != m_index.end())
+    {
+        iter->second->names.clear();
+        return iter->second;
+    }
+
+    auto e = std::make_unique<entry>();
+    e->file = file;
+    entry* ret = e.get();
+    m_index.emplace(ret->file.c_str(), ret);
+    m_entries.emplace_back(std::move(e));
+    return ret;
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+#include <core/str_unordered_set.h>
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Cached record of what each Lua script did when it was last loaded, keyed by
+// file name and validated by the file's last write time and size.  Scripts
+// that only registered argmatchers can be deferred until one of their commands
+// is looked up.
+class script_manifest
+{
+public:
+    struct entry
+    {
+        str_moveable        file;
+        FILETIME            modified = {};
+        uint64              size = 0;
+        str_moveable        kinds;      // What else it did; e.g. "clink.generator".
+        std::vector<str_moveable> names; // Argmatcher commands it registered.
+        bool                used = false;
+
+        bool                is_deferrable() const { return kinds.empty() && !names.empty(); }
+    };
+
+                            script_manifest() = default;
+                            script_manifest(const script_manifest&) = delete;
+
+    bool                    load(const char* file);
+    bool                    save(const char* file);
+    const entry*            find(const char* file, const FILETIME& modified, uint64 size);
+    void                    update(const char* file, const FILETIME& modified, uint64 size, const char* kinds, std::vector<str_moveable>&& names);
+    bool                    is_dirty() const;
+
+private:
+    entry*                  add(const char* file);
+
+    std::vector<std::unique_ptr<entry>> m_entries;
+    str_unordered_map<entry*> m_index;  // Keys point into m_entries.
+    bool                    m_dirty = false;
+};
@@ -5,6 +5,7 @@
 #include "dll/dll.h"
 #include "loader/loader.h"
 
+#include <core/exec_index.h>
 #include <core/os.h>
 #include <core/str_compare.h>
 #include <core/settings.h>
@@ -222,6 +223,7 @@ static int32 editline()
     line_editor_destroy(editor);
 
     shutdown_recognizer();
+    exec_index::shutdown();
     shutdown_task_manager(true/*final*/);
 
     return 0;
@@ -338,6 +340,7 @@ int32 testbed(int32 argc, char** argv)
 #endif
 
     shutdown_recognizer();
+    exec_index::shutdown();
 
     return ret;
 }
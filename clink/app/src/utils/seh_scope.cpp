@@ -6,6 +6,7 @@
 #include "utils/app_context.h"
 #include "version.h"
 
+#include <core/log.h>
 #include <core/str.h>
 #include <terminal/terminal_helpers.h>
 
@@ -18,6 +19,9 @@ static LONG WINAPI exception_filter(EXCEPTION_POINTERS* info)
     if (s_filter <= 0) // It's thread_local, so no explicit synchronization is needed.
         return EXCEPTION_CONTINUE_SEARCH;
 
+    // Write out any queued log lines before anything else can go wrong.
+    file_logger::flush();
+
 #if defined(_MSC_VER)
     str<MAX_PATH, false> buffer;
     if (const app_context* context = app_context::get())
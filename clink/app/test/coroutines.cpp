@@ -464,5 +464,72 @@ TEST_CASE("Lua coroutines.")
         }
     }
 
+    SECTION("Scheduling")
+    {
+        lua_state lua;
+        lua_load_script(lua, app, prompt);
+
+        const char* script = "\
+        _fast = 0\
+        _slow = 0\
+        \
+        local function loop(name)\
+            while true do\
+                _G[name] = _G[name] + 1\
+                coroutine.yield()\
+            end\
+        end\
+        \
+        _fast_co = coroutine.create(function() loop('_fast') end)\
+        _slow_co = coroutine.create(function() loop('_slow') end)\
+        clink.setcoroutineinterval(_slow_co, 1000)\
+        \
+        function resume_pass()\
+            clink._resume_coroutines()\
+            return true\
+        end\
+        \
+        function verify_first_pass()\
+            return _fast == 1 and _slow == 1 and clink._wait_duration() <= 0\
+        end\
+        \
+        function verify_only_due_resumed()\
+            return _fast == 2 and _slow == 1\
+        end\
+        \
+        function slow_down_fast()\
+            clink.setcoroutineinterval(_fast_co, 1000)\
+            local dur = clink._wait_duration()\
+            return dur and dur > 900\
+        end\
+        \
+        function verify_none_due()\
+            return _fast == 2 and _slow == 1\
+        end\
+        \
+        function verify_removed()\
+            clink.removecoroutine(_fast_co)\
+            clink.removecoroutine(_slow_co)\
+            return clink._wait_duration() == nil and not clink._has_coroutines()\
+        end\
+        ";
+
+        REQUIRE_LUA_DO_STRING(lua, script);
+
+        // New coroutines are due immediately; afterwards only the coroutine
+        // whose interval has elapsed gets resumed.
+        REQUIRE(verify_ret_true(lua, "resume_pass"));
+        REQUIRE(verify_ret_true(lua, "verify_first_pass"));
+        REQUIRE(verify_ret_true(lua, "resume_pass"));
+        REQUIRE(verify_ret_true(lua, "verify_only_due_resumed"));
+
+        // Changing the interval reschedules the coroutine.
+        REQUIRE(verify_ret_true(lua, "slow_down_fast"));
+        REQUIRE(verify_ret_true(lua, "resume_pass"));
+        REQUIRE(verify_ret_true(lua, "verify_none_due"));
+
+        REQUIRE(verify_ret_true(lua, "verify_removed"));
+    }
+
     set_autosuggest_async_default();
 }
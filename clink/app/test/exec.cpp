@@ -8,6 +8,7 @@
 #include "env_fixture.h"
 #include "line_editor_tester.h"
 
+#include <core/env_snapshot.h>
 #include <core/path.h>
 #include <core/settings.h>
 #include <core/str_compare.h>
@@ -49,6 +50,7 @@ TEST_CASE("Executable match generation.")
         nullptr,
     };
     env_fixture env(exec_env);
+    REQUIRE(env_snapshot::get()->is_pathext(".py"));
 
     lua_state lua;
     lua_match_generator lua_generator(lua);
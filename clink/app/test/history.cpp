@@ -16,7 +16,9 @@
 #include <lib/history_db.h>
 #include <utils/app_context.h>
 
+#include <functional>
 #include <initializer_list>
+#include <vector>
 
 extern "C" {
 #include <readline/history.h>
@@ -77,6 +79,18 @@ struct test_history_db
         m_min_compact_threshold = threshold;
     }
 
+    void set_compact_prepared_hook(std::function<void()>&& hook)
+    {
+        m_hook = std::move(hook);
+        m_compact_prepared_hook = [] (void* data) { (*static_cast<std::function<void()>*>(data))(); };
+        m_compact_prepared_hook_data = &m_hook;
+    }
+
+    void wait_for_compact()
+    {
+        wait_for_compact_task();
+    }
+
     bool remove_by_index(int32 index)
     {
         return remove(m_index_map[index]);
@@ -87,6 +101,8 @@ struct test_history_db
         rollback<void *> revert(m_bank_handles[bank_session].m_handle_removals, nullptr);
         return remove(line);
     }
+
+    std::function<void()> m_hook;
 };
 
 //------------------------------------------------------------------------------
@@ -542,6 +558,82 @@ TEST_CASE("history rl")
     }
 }
 
+//------------------------------------------------------------------------------
+static void require_history(const std::vector<str_moveable>& expected)
+{
+    REQUIRE(history_length == int32(expected.size()));
+
+    HIST_ENTRY** list = history_list();
+    REQUIRE((list != nullptr || expected.empty()));
+    for (int32 i = 0; i < history_length; ++i)
+    {
+        REQUIRE(list[i] != nullptr);
+        REQUIRE(strcmp(list[i]->line, expected[i].c_str()) == 0);
+        REQUIRE(history_get(history_base + i) == list[i]);
+    }
+    REQUIRE((!list || list[history_length] == nullptr));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("history stifled")
+{
+    clear_history();
+
+    // Stifled history evicts the oldest entry by sliding the start of the
+    // list within its allocation, and occasionally moves the list back to
+    // the start of the allocation.  Add enough entries to do that many times.
+    const int32 max = 7;
+    stifle_history(max);
+
+    SECTION("Sliding")
+    {
+        std::vector<str_moveable> expected;
+        str_moveable line;
+        for (int32 i = 0; i < 500; ++i)
+        {
+            line.format("line %d", i);
+            add_history(line.c_str());
+
+            expected.emplace_back(std::move(line));
+            if (expected.size() > max)
+                expected.erase(expected.begin());
+            require_history(expected);
+        }
+        REQUIRE(history_base == 500 - max + 1);
+    }
+
+    SECTION("Reserved")
+    {
+        history_reserve(1000);
+
+        std::vector<str_moveable> expected;
+        str_moveable line;
+        for (int32 i = 0; i < 50; ++i)
+        {
+            line.format("line %d", i);
+            add_history(line.c_str());
+
+            expected.emplace_back(std::move(line));
+            if (expected.size() > max)
+                expected.erase(expected.begin());
+        }
+        require_history(expected);
+
+        // Stifling further keeps the newest entries.
+        stifle_history(3);
+        expected.erase(expected.begin(), expected.end() - 3);
+        require_history(expected);
+
+        add_history("last");
+        expected.erase(expected.begin());
+        expected.emplace_back("last");
+        require_history(expected);
+    }
+
+    unstifle_history();
+    clear_history();
+}
+
 //------------------------------------------------------------------------------
 TEST_CASE("history limit")
 {
@@ -631,6 +723,13 @@ TEST_CASE("history limit")
         history.add(history_lines[5-1]);
         history.load_rl_history();
 
+        // The compacted master bank is prepared in the background, and the
+        // next load commits it.
+        REQUIRE(history.get_master_deleted_count() == 4);
+        REQUIRE(strcmp(ctag.get(), history.get_master_tag()) == 0);
+        history.wait_for_compact();
+        history.load_rl_history();
+
         REQUIRE(history.get_master_length() == 3);
         REQUIRE(history.get_master_deleted_count() == 0);
         REQUIRE(strcmp(ctag.get(), history.get_master_tag()) != 0);
@@ -659,6 +758,82 @@ TEST_CASE("history limit")
             REQUIRE(os::get_file_size(master_path) == line_bytes + history.get_master_tag_size());
         }
     }
+
+    SECTION("Compacted by another session")
+    {
+        history.add(history_lines[5-1]);
+        history.add(history_lines[5-1]);
+        history.load_rl_history(false);
+
+        REQUIRE(history.get_master_deleted_count() == 4);
+
+        uint32 tag_size;
+        {
+            test_history_db separate_instance;
+            REQUIRE(separate_instance.compact(true/*force*/));
+            tag_size = separate_instance.get_master_tag_size();
+        }
+
+        // The deleted count is stale, so compacting again is skipped.
+        REQUIRE(!history.compact());
+        history.wait_for_compact();
+        REQUIRE(!history.compact());
+
+        size_t line_bytes = (strlen(history_lines[3-1]) + 1 +
+                             strlen(history_lines[4-1]) + 1 +
+                             strlen(history_lines[5-1]) + 1);
+        REQUIRE(os::get_file_size(master_path) == line_bytes + tag_size);
+    }
+
+    SECTION("Kept line removed while compacting")
+    {
+        history.add(history_lines[5-1]);
+        history.add(history_lines[5-1]);
+        history.load_rl_history(false);
+
+        REQUIRE(history.get_master_deleted_count() == 4);
+
+        // Another session removes a line that the compacted bank keeps, after
+        // the compacted bank is prepared and before it's committed.
+        history.set_compact_prepared_hook([&] () {
+            test_history_db separate_instance;
+            REQUIRE(separate_instance.remove(history_lines[3-1]));
+        });
+
+        SECTION("Automatic")
+        {
+            // Committing would bring back the removed line, so compacting is
+            // skipped and the master bank is left alone.
+            REQUIRE(!history.compact());
+            history.wait_for_compact();
+            REQUIRE(!history.compact());
+
+            {
+                test_history_db separate_instance;
+                REQUIRE(strcmp(ctag.get(), separate_instance.get_master_tag()) == 0);
+            }
+
+            size_t line_bytes = (strlen(history_lines[1-1]) + 1 +
+                                 strlen(history_lines[2-1]) + 1 +
+                                 strlen(history_lines[3-1]) + 1 +
+                                 strlen(history_lines[4-1]) + 1 +
+                                 strlen(history_lines[5-1]) + 1 +
+                                 strlen(history_lines[5-1]) + 1 +
+                                 strlen(history_lines[5-1]) + 1);
+            REQUIRE(os::get_file_size(master_path) == line_bytes + history.get_master_tag_size());
+        }
+
+        SECTION("Forced")
+        {
+            // Explicit compaction starts over, so the removed line stays gone.
+            REQUIRE(history.compact(true/*force*/));
+            REQUIRE(strcmp(ctag.get(), history.get_master_tag()) != 0);
+
+            size_t line_bytes = (strlen(history_lines[4-1]) + 1 +
+                                 strlen(history_lines[5-1]) + 1);
+            REQUIRE(os::get_file_size(master_path) == line_bytes + history.get_master_tag_size());
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -927,4 +1102,103 @@ TEST_CASE("history removals ctag")
             fclose(file);
         }
     }
+
+    SECTION("Compact carries over appended lines")
+    {
+        char buffer[128];
+        char ctag_line[128];
+
+        static const char* history_lines[] = {
+            "|cho alpha",               // Marked for deletion!
+            "echo charlie delta",
+        };
+        static const char* appended_line = "echo hotel india";
+
+        // Populate history.
+        {
+            test_history_db history;
+            history.clear();
+            history.load_rl_history(true); // initialize ctag
+
+            for(const char* line : history_lines)
+                REQUIRE(history.add(line));
+        }
+
+        expect_files({master_path});
+
+        {
+            test_history_db history;
+            history.load_rl_history(false);
+
+            // After the compacted bank is prepared and before it's committed,
+            // another session appends a line, and then this session queues a
+            // deferred deletion of it (in the .removals file).
+            history.set_compact_prepared_hook([&] () {
+                settings::find("history.shared")->set("true");
+                {
+                    test_history_db separate_instance;
+                    REQUIRE(separate_instance.add(appended_line));
+                }
+                settings::find("history.shared")->set("false");
+                REQUIRE(history.remove(appended_line));
+            });
+
+            REQUIRE(history.compact(true/*force*/));
+
+            // Verify the appended line was carried over.
+            {
+                FILE* file = fopen(master_path, "rb");
+                REQUIRE(file != nullptr);
+                REQUIRE(fgets(ctag_line, sizeof_array(ctag_line), file));
+                REQUIRE(strncmp(ctag_line, "|CTAG", 5) == 0);
+
+                REQUIRE(fgets(buffer, sizeof_array(buffer), file));
+                strip_lf(buffer);
+                REQUIRE(strcmp(buffer, history_lines[1]) == 0);
+
+                REQUIRE(fgets(buffer, sizeof_array(buffer), file));
+                strip_lf(buffer);
+                REQUIRE(strcmp(buffer, appended_line) == 0);
+
+                REQUIRE(!fgets(buffer, sizeof_array(buffer), file));
+                fclose(file);
+            }
+
+            // Verify the deferred deletion was translated to the appended
+            // line's new offset.
+            {
+                FILE* file = fopen(removals_path, "rb");
+                REQUIRE(file != nullptr);
+                REQUIRE(fgets(buffer, sizeof_array(buffer), file));
+                REQUIRE(strcmp(buffer, ctag_line) == 0);
+                const int32 expected_offset = int32(strlen(ctag_line) + strlen(history_lines[1]) + 1);
+                REQUIRE(fgets(buffer, sizeof_array(buffer), file));
+                REQUIRE(atoi(buffer) == expected_offset);
+                REQUIRE(!fgets(buffer, sizeof_array(buffer), file));
+                fclose(file);
+            }
+        }
+
+        expect_files({master_path});
+
+        // Verify the deferred deletion was applied to the appended line.
+        {
+            FILE* file = fopen(master_path, "rb");
+            REQUIRE(file != nullptr);
+            REQUIRE(fgets(buffer, sizeof_array(buffer), file));
+            REQUIRE(strcmp(buffer, ctag_line) == 0);
+
+            REQUIRE(fgets(buffer, sizeof_array(buffer), file));
+            strip_lf(buffer);
+            REQUIRE(strcmp(buffer, history_lines[1]) == 0);
+
+            REQUIRE(fgets(buffer, sizeof_array(buffer), file));
+            REQUIRE(buffer[0] == '|');
+            strip_lf(buffer);
+            REQUIRE(strcmp(buffer + 1, appended_line + 1) == 0);
+
+            REQUIRE(!fgets(buffer, sizeof_array(buffer), file));
+            fclose(file);
+        }
+    }
 }
@@ -0,0 +1,253 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "env_fixture.h"
+#include "fs_fixture.h"
+
+#include <core/base.h>
+#include <core/globber.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/settings.h>
+#include <core/str.h>
+#include <host/host_lua.h>
+#include <host/script_image.h>
+#include <lua/lua_state.h>
+#include <utils/app_context.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Script image")
+{
+    fs_fixture fs;
+
+    str<280> file(fs.get_root());
+    path::append(file, "clink_script_image");
+
+    FILETIME ft1 = { 0x89abcdef, 0x01234567 };
+    FILETIME ft2 = { 0x11111111, 0x02222222 };
+
+    const char* chunk;
+    uint32 chunk_len;
+
+    SECTION("Load")
+    {
+        {
+            script_image image;
+            REQUIRE(!image.load(file.c_str()));
+
+            std::vector<char> bytes = { 'a', '\0', 'b' };
+            image.update("c:\\scripts\\foo.lua", ft1, 123, std::move(bytes));
+            bytes = { 'x', 'y' };
+            image.update("c:\\scripts\\bar.lua", ft2, 456, std::move(bytes));
+
+            REQUIRE(image.is_dirty());
+            REQUIRE(image.save(file.c_str()));
+            REQUIRE(!image.is_dirty());
+        }
+
+        script_image image;
+        REQUIRE(image.load(file.c_str()));
+
+        REQUIRE(image.find("c:\\scripts\\foo.lua", ft1, 123, chunk, chunk_len));
+        REQUIRE(chunk_len == 3);
+        REQUIRE(memcmp(chunk, "a\0b", 3) == 0);
+
+        // Stale entries aren't found.
+        REQUIRE(!image.find("c:\\scripts\\bar.lua", ft1, 456, chunk, chunk_len));
+        REQUIRE(!image.find("c:\\scripts\\bar.lua", ft2, 457, chunk, chunk_len));
+        REQUIRE(!image.find("c:\\scripts\\other.lua", ft2, 456, chunk, chunk_len));
+
+        // Entries not used during a load are dropped when saving.
+        REQUIRE(image.is_dirty());
+        REQUIRE(image.save(file.c_str()));
+
+        script_image reloaded;
+        REQUIRE(reloaded.load(file.c_str()));
+        REQUIRE(reloaded.find("c:\\scripts\\foo.lua", ft1, 123, chunk, chunk_len));
+        REQUIRE(!reloaded.find("c:\\scripts\\bar.lua", ft2, 456, chunk, chunk_len));
+    }
+
+    SECTION("Truncated")
+    {
+        {
+            script_image image;
+            std::vector<char> bytes = { 'a', 'b', 'c', 'd' };
+            image.update("c:\\scripts\\foo.lua", ft1, 123, std::move(bytes));
+            REQUIRE(image.save(file.c_str()));
+        }
+
+        // Drop the last byte.
+        FILE* f = fopen(file.c_str(), "rb");
+        REQUIRE(f);
+        std::vector<char> data(4096);
+        data.resize(fread(data.data(), 1, data.size(), f));
+        fclose(f);
+        f = fopen(file.c_str(), "wb");
+        REQUIRE(f);
+        fwrite(data.data(), data.size() - 1, 1, f);
+        fclose(f);
+
+        script_image image;
+        REQUIRE(!image.load(file.c_str()));
+        REQUIRE(!image.find("c:\\scripts\\foo.lua", ft1, 123, chunk, chunk_len));
+    }
+
+    SECTION("Corrupt")
+    {
+        {
+            script_image image;
+            std::vector<char> bytes = { 'a', 'b', 'c', 'd' };
+            image.update("c:\\scripts\\foo.lua", ft1, 123, std::move(bytes));
+            bytes = { 'w', 'x', 'y', 'z' };
+            image.update("c:\\scripts\\bar.lua", ft2, 456, std::move(bytes));
+            REQUIRE(image.save(file.c_str()));
+        }
+
+        // Damage one byte of the last chunk, without changing its length.
+        FILE* f = fopen(file.c_str(), "rb");
+        REQUIRE(f);
+        std::vector<char> data(4096);
+        data.resize(fread(data.data(), 1, data.size(), f));
+        fclose(f);
+        REQUIRE(data.back() == 'z');
+        data.back() = 'Z';
+        f = fopen(file.c_str(), "wb");
+        REQUIRE(f);
+        fwrite(data.data(), data.size(), 1, f);
+        fclose(f);
+
+        // The whole image is discarded, not just the damaged entry.
+        script_image image;
+        REQUIRE(!image.load(file.c_str()));
+        REQUIRE(!image.find("c:\\scripts\\foo.lua", ft1, 123, chunk, chunk_len));
+        REQUIRE(!image.find("c:\\scripts\\bar.lua", ft2, 456, chunk, chunk_len));
+    }
+
+    SECTION("Bytecode")
+    {
+        str<280> script(fs.get_root());
+        path::append(script, "script.lua");
+        FILE* f = fopen(script.c_str(), "wt");
+        REQUIRE(f);
+        fputs("image_runs = (image_runs or 0) + 1\n"
+              "image_source = debug.getinfo(1, 'S').source\n", f);
+        fclose(f);
+
+        lua_state lua;
+
+        // Compiling from source produces bytecode.
+        std::vector<char> compiled;
+        REQUIRE(lua.do_file(script.c_str(), nullptr, 0, &compiled));
+        REQUIRE(!compiled.empty());
+
+        // Running from the bytecode doesn't recompile, and keeps the source
+        // name for error messages and debugging.
+        std::vector<char> recompiled;
+        REQUIRE(lua.do_file(script.c_str(), compiled.data(), uint32(compiled.size()), &recompiled));
+        REQUIRE(recompiled.empty());
+        REQUIRE(lua.do_string("assert(image_runs == 2)"));
+
+        str<> s;
+        s.format("assert(image_source == [[@%s]])", script.c_str());
+        REQUIRE(lua.do_string(s.c_str()));
+
+        // Unusable bytecode falls back to the source.
+        REQUIRE(lua.do_file(script.c_str(), "garbage", 7, &recompiled));
+        REQUIRE(!recompiled.empty());
+        REQUIRE(lua.do_string("assert(image_runs == 3)"));
+    }
+}
+
+//------------------------------------------------------------------------------
+static bool image_has_script(const char* image_file, const char* script)
+{
+    str<280> tmp;
+    globber::extrainfo info;
+    globber file_glob(script);
+    file_glob.directories(false);
+    REQUIRE(file_glob.next(tmp, true, &info));
+
+    const char* chunk;
+    uint32 chunk_len;
+    script_image image;
+    return (image.load(image_file) &&
+            image.find(script, info.modified, info.size, chunk, chunk_len));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Script image deferred")
+{
+    const char* empty_fs[] = { nullptr };
+    fs_fixture fs(empty_fs);
+
+    static const char* env_desc[] = { nullptr };
+    env_fixture env(env_desc);
+
+    app_context::desc context_desc;
+    str_base(context_desc.state_dir).copy(fs.get_root());
+    app_context context(context_desc);
+
+    settings::find("clink.path")->set(fs.get_root());
+    settings::find("lua.defer_argmatchers")->set("true");
+    settings::find("lua.cache_bytecode")->set("true");
+
+    str<280> image_file(fs.get_root());
+    path::append(image_file, "clink_script_image");
+
+    str<280> script;
+    path::join(fs.get_root(), "deferred.lua", script);
+    FILE* f = fopen(script.c_str(), "wt");
+    REQUIRE(f);
+    fputs("deferred_runs = (deferred_runs or 0) + 1\n"
+          "clink.argmatcher('imagetest'):addflags('-x')\n", f);
+    fclose(f);
+
+    // The first session runs the script, learns that it can be deferred, and
+    // saves its bytecode.
+    {
+        host_lua host;
+        host.load_scripts();
+        lua_state& lua = host;
+        REQUIRE(lua.do_string("assert(deferred_runs == 1)"));
+    }
+    REQUIRE(image_has_script(image_file.c_str(), script.c_str()));
+
+    SECTION("Kept")
+    {
+        // Later sessions defer the script, and keep its bytecode.
+        for (int32 i = 0; i < 2; ++i)
+        {
+            host_lua host;
+            host.load_scripts();
+            lua_state& lua = host;
+            REQUIRE(lua.do_string("assert(deferred_runs == nil)"));
+            REQUIRE(image_has_script(image_file.c_str(), script.c_str()));
+
+            // Loading it on demand runs it.
+            REQUIRE(lua.do_string("clink.argmatcher('imagetest')"));
+            REQUIRE(lua.do_string("assert(deferred_runs == 1)"));
+        }
+        REQUIRE(image_has_script(image_file.c_str(), script.c_str()));
+    }
+
+    SECTION("Compiled on demand")
+    {
+        REQUIRE(os::unlink(image_file.c_str()));
+
+        // Loading a deferred script on demand saves its bytecode.
+        host_lua host;
+        host.load_scripts();
+        lua_state& lua = host;
+        REQUIRE(lua.do_string("assert(deferred_runs == nil)"));
+        REQUIRE(!image_has_script(image_file.c_str(), script.c_str()));
+
+        REQUIRE(lua.do_string("clink.argmatcher('imagetest')"));
+        REQUIRE(lua.do_string("assert(deferred_runs == 1)"));
+        REQUIRE(image_has_script(image_file.c_str(), script.c_str()));
+    }
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/base.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <host/script_manifest.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Script manifest")
+{
+    fs_fixture fs;
+
+    str<280> file(fs.get_root());
+    path::append(file, "clink_script_manifest");
+
+    FILETIME ft1 = { 0x89abcdef, 0x01234567 };
+    FILETIME ft2 = { 0x11111111, 0x02222222 };
+
+    {
+        script_manifest manifest;
+        REQUIRE(!manifest.load(file.c_str()));
+
+        std::vector<str_moveable> names;
+        names.emplace_back("foo");
+        names.emplace_back("foo.exe");
+        manifest.update("c:\\scripts\\foo.lua", ft1, 123, "", std::move(names));
+
+        names.clear();
+        names.emplace_back("bar");
+        manifest.update("c:\\scripts\\bar.lua", ft2, 456, "clink.generator", std::move(names));
+
+        manifest.update("c:\\scripts\\none.lua", ft2, 789, "", std::vector<str_moveable>());
+
+        REQUIRE(manifest.is_dirty());
+        REQUIRE(manifest.save(file.c_str()));
+        REQUIRE(!manifest.is_dirty());
+    }
+
+    SECTION("Load")
+    {
+        script_manifest manifest;
+        REQUIRE(manifest.load(file.c_str()));
+
+        const script_manifest::entry* e = manifest.find("c:\\scripts\\foo.lua", ft1, 123);
+        REQUIRE(e);
+        REQUIRE(e->is_deferrable());
+        REQUIRE(e->names.size() == 2);
+        REQUIRE(e->names[0].equals("foo"));
+        REQUIRE(e->names[1].equals("foo.exe"));
+
+        e = manifest.find("c:\\scripts\\bar.lua", ft2, 456);
+        REQUIRE(e);
+        REQUIRE(!e->is_deferrable());
+        REQUIRE(e->kinds.equals("clink.generator"));
+
+        // Scripts that registered nothing aren't deferred.
+        e = manifest.find("c:\\scripts\\none.lua", ft2, 789);
+        REQUIRE(e);
+        REQUIRE(!e->is_deferrable());
+    }
+
+    SECTION("Stale")
+    {
+        script_manifest manifest;
+        REQUIRE(manifest.load(file.c_str()));
+
+        REQUIRE(!manifest.find("c:\\scripts\\foo.lua", ft2, 123));
+        REQUIRE(!manifest.find("c:\\scripts\\foo.lua", ft1, 124));
+        REQUIRE(!manifest.find("c:\\scripts\\other.lua", ft1, 123));
+    }
+
+    SECTION("Prune")
+    {
+        script_manifest manifest;
+        REQUIRE(manifest.load(file.c_str()));
+        REQUIRE(manifest.find("c:\\scripts\\foo.lua", ft1, 123));
+        REQUIRE(manifest.find("c:\\scripts\\bar.lua", ft2, 456));
+
+        // Scripts not seen during a load are dropped when saving.
+        REQUIRE(manifest.is_dirty());
+        REQUIRE(manifest.save(file.c_str()));
+
+        script_manifest reloaded;
+        REQUIRE(reloaded.load(file.c_str()));
+        REQUIRE(reloaded.find("c:\\scripts\\foo.lua", ft1, 123));
+        REQUIRE(!reloaded.find("c:\\scripts\\none.lua", ft2, 789));
+    }
+}
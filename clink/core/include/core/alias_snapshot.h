@@ -0,0 +1,46 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+#include "str_unordered_set.h"
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Copy of the doskey alias table for the current shell name, fetched in bulk
+// so that looking up aliases doesn't need a round trip to the console host
+// per name.  A snapshot is immutable; refresh() replaces the shared snapshot
+// when the contents of the alias table have changed, and set_alias()
+// invalidates it.
+class alias_snapshot
+{
+public:
+                        alias_snapshot() = default;
+                        alias_snapshot(const alias_snapshot&) = delete;
+
+    static std::shared_ptr<const alias_snapshot> get(); // Null until refresh().
+    static bool         refresh();
+    static void         invalidate();
+    static void         reset();            // get() is null until refresh().
+
+    uint32              get_count() const { return uint32(m_aliases.size()); }
+    const char*         get_name(uint32 index) const;
+    bool                find(const char* name, str_base& out) const;
+
+private:
+    struct alias
+    {
+        str_moveable    name;
+        str_moveable    key;        // Lowercase name.
+        str_moveable    text;
+    };
+
+    static std::shared_ptr<const alias_snapshot> build(const wchar_t* buffer, uint32 length);
+    void                init(const wchar_t* buffer, uint32 length);
+
+    std::vector<alias>  m_aliases;  // In the order the console reports them.
+    str_unordered_map<uint32> m_index; // Points into m_aliases.
+};
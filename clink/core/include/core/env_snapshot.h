@@ -0,0 +1,39 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+#include "str_unordered_set.h"
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Parsed copies of %PATH% and %PATHEXT%, shared by everything that searches
+// for executables.  A snapshot is immutable; refresh() replaces the shared
+// snapshot when the environment block has changed, and invalidate() discards
+// it so the next get() builds a new one.
+class env_snapshot
+{
+public:
+                        env_snapshot() = default;
+                        env_snapshot(const env_snapshot&) = delete;
+
+    static std::shared_ptr<const env_snapshot> get();
+    static bool         refresh();
+    static void         invalidate();
+
+    uint32              get_generation() const { return m_generation; }
+    const std::vector<str_moveable>& get_paths() const { return m_paths; }
+    const std::vector<str_moveable>& get_pathexts() const { return m_pathexts; }
+    bool                is_pathext(const char* ext) const;
+
+private:
+    void                init(uint32 generation);
+
+    uint32              m_generation = 0;
+    std::vector<str_moveable> m_paths;      // Expanded, unquoted, normalized.
+    std::vector<str_moveable> m_pathexts;   // Lowercase, in %PATHEXT% order.
+    str_unordered_set   m_pathext_set;      // Points into m_pathexts.
+};
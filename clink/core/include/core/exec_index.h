@@ -0,0 +1,58 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+
+#include <memory>
+#include <vector>
+
+class env_snapshot;
+struct exec_dir_scan;
+
+//------------------------------------------------------------------------------
+// Index of the executables in the %PATH% directories, i.e. files whose
+// extension is listed in %PATHEXT%.  The index is built on a background
+// thread and is immutable once published; refresh() rebuilds it, rescanning
+// only directories whose last write time changed.
+class exec_index
+{
+public:
+    struct entry
+    {
+        const char*     name;       // File name, including extension.
+        const char*     key;        // Lowercase file name; sort key.
+        uint32          attr;       // FILE_ATTRIBUTE_* flags.
+        int32           st_mode;
+        uint16          dir;        // Ordinal of directory in %PATH%.
+        uint16          ext;        // Ordinal of extension in %PATHEXT%.
+    };
+
+                        exec_index() = default;
+                        exec_index(const exec_index&) = delete;
+
+    static std::shared_ptr<const exec_index> get();
+    static void         refresh(bool force=false);
+    static void         wait();
+    static void         shutdown();
+
+    uint32              get_generation() const { return m_generation; }
+    uint32              get_count() const { return uint32(m_entries.size()); }
+    const char*         get_dir(uint32 dir) const;
+    bool                is_local(uint32 dir) const;
+    bool                is_out_of_date() const;
+    void                find_prefix(const char* prefix, std::vector<const entry*>& out, bool local_only=false) const;
+    const entry*        find_command(const char* word, bool local_only=false) const;
+
+private:
+    void                build(const std::shared_ptr<const env_snapshot>& env, const exec_index* prev);
+    std::shared_ptr<const exec_dir_scan> find_scan(const char* dir, const char* pathexts, const FILETIME& modified) const;
+    static void         proc(std::shared_ptr<const env_snapshot> env);
+
+    uint32              m_generation = 0;
+    bool                m_complete = true;
+    std::shared_ptr<const env_snapshot> m_env;
+    std::vector<std::shared_ptr<const exec_dir_scan>> m_dirs;
+    std::vector<entry>  m_entries;  // Sorted by key, then dir, then ext.
+};
@@ -5,6 +5,10 @@
 
 #include "str.h"
 
+#include <memory>
+
+struct dir_listing;
+
 //------------------------------------------------------------------------------
 class globber
 {
@@ -19,7 +23,16 @@ public:
         FILETIME            created;
     };
 
-                        globber(const char* pattern);
+    struct cache_stats
+    {
+        uint32              lookups;
+        uint32              hits;
+        uint32              invalidations;
+        uint32              directories;
+        uint32              files;
+    };
+
+                        globber(const char* pattern, bool cached=false);
                         ~globber();
     void                files(bool state)       { m_files = state; }
     void                directories(bool state) { m_directories = state; }
@@ -31,12 +44,21 @@ public:
     bool                next(str_base& out, bool rooted=true, extrainfo* extrainfo=nullptr);
     void                close();
 
+    static void         set_cache_ttl(uint32 seconds);
+    static uint32       sweep_cache(); // Returns milliseconds until next sweep is due, or -1.
+    static void         get_cache_stats(cache_stats& out);
+
 private:
                         globber(const globber&) = delete;
     void                operator = (const globber&) = delete;
+    bool                find_cached(const char* pattern);
     void                next_file();
+    bool                next_cached();
     WIN32_FIND_DATAW    m_data;
     HANDLE              m_handle;
+    std::shared_ptr<const dir_listing> m_listing;
+    uint32              m_listing_index = 0;
+    wstr<32>            m_prefix;
     str<280>            m_root;
     bool                m_files;
     bool                m_directories;
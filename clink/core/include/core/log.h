@@ -50,6 +50,11 @@ private:
 };
 
 //------------------------------------------------------------------------------
+struct log_writer;
+
+//------------------------------------------------------------------------------
+// Lines are queued without blocking and written in batches by a background
+// thread that keeps the log file open.
 class file_logger
     : public logger
 {
@@ -59,9 +64,12 @@ public:
     virtual void    emit_impl(const char* function, int32 line, const char* msg) override;
 
     static const char* get_path() { return s_this ? s_this->m_log_path.c_str() : nullptr; }
+    static uint32   get_dropped();
+    static void     flush();
 
 private:
     str<256>        m_log_path;
+    log_writer*     m_writer;
 
     static const file_logger* s_this;
 };
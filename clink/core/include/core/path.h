@@ -11,8 +11,6 @@ class str_moveable;
 namespace path
 {
 
-void        refresh_pathext();
-
 void        normalise(str_base& in_out, int32 sep=0);
 void        normalise(char* in_out, int32 sep=0);
 void        normalise_separators(str_base& in_out, int32 sep=0);
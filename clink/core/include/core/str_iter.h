@@ -16,6 +16,7 @@ public:
     const T*        get_pointer() const;
     const T*        get_next_pointer();
     void            reset_pointer(const T* ptr);
+    void            advance(uint32 len);
     void            truncate(uint32 len);
     int32           peek();
     int32           next();
@@ -72,6 +73,14 @@ template <typename T> void str_iter_impl<T>::reset_pointer(const T* ptr)
     m_ptr = ptr;
 }
 
+//------------------------------------------------------------------------------
+template <typename T> void str_iter_impl<T>::advance(uint32 len)
+{
+    assert(m_ptr);
+    assert(len <= length());
+    m_ptr += len;
+}
+
 //------------------------------------------------------------------------------
 template <typename T> void str_iter_impl<T>::truncate(uint32 len)
 {
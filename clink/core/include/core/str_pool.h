@@ -0,0 +1,87 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str_unordered_set.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class linear_allocator;
+
+//------------------------------------------------------------------------------
+// Process-wide pool of immutable, reference counted strings, so that equal
+// strings held by different subsystems share one copy.  Strings are carved
+// from linear_allocator pages grouped into generations.  Released strings stay
+// in the index so they can be reused, and a generation is freed as a whole
+// once none of its strings are referenced and it is no longer the generation
+// receiving new strings.  Thread safe.
+class str_pool
+{
+    friend class interned_str;
+
+public:
+    struct stats
+    {
+        uint32              live_strings = 0;
+        uint64              live_bytes = 0;     // Bytes in strings still referenced.
+        uint64              pooled_bytes = 0;   // Bytes in generations not yet freed.
+        uint32              generations = 0;
+        uint64              requests = 0;       // Strings interned.
+        uint64              hits = 0;           // ...that were already in the pool.
+        uint64              requested_bytes = 0;// Bytes that would have been copied.
+        uint64              stored_bytes = 0;   // Bytes actually copied.
+    };
+
+    static str_pool&        get();
+    void                    get_stats(stats& out) const;
+
+private:
+    struct generation;
+    struct entry
+    {
+        generation*         gen;
+        uint32              refs;
+        uint32              len;
+        char                text[1];
+    };
+
+                            str_pool() = default;
+                            ~str_pool();
+    entry*                  acquire(const char* s, uint32 len);
+    void                    addref(entry* e);
+    void                    release(entry* e);
+    generation*             current_generation(uint32 size);
+    void                    free_generation(generation* gen);
+
+    mutable std::mutex      m_mutex;
+    str_unordered_map<entry*> m_index;  // Keys point into the entries.
+    std::vector<std::unique_ptr<generation>> m_generations; // Last is current.
+    stats                   m_stats;
+};
+
+//------------------------------------------------------------------------------
+// Handle to a string in the str_pool.  Copying a handle shares the string.
+class interned_str
+{
+public:
+                            interned_str() = default;
+                            interned_str(const char* s, int32 len=-1) { assign(s, len); }
+                            interned_str(const interned_str& other);
+                            interned_str(interned_str&& other) : m_entry(other.m_entry) { other.m_entry = nullptr; }
+                            ~interned_str() { clear(); }
+    interned_str&           operator = (const interned_str& other);
+    interned_str&           operator = (interned_str&& other);
+    interned_str&           operator = (const char* s) { assign(s); return *this; }
+    void                    assign(const char* s, int32 len=-1);
+    void                    clear();
+    const char*             c_str() const { return m_entry ? m_entry->text : ""; }
+    uint32                  length() const { return m_entry ? m_entry->len : 0; }
+    bool                    empty() const { return !m_entry; }
+    bool                    equals(const char* s) const { return strcmp(c_str(), s) == 0; }
+
+private:
+    str_pool::entry*        m_entry = nullptr;
+};
@@ -0,0 +1,171 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "alias_snapshot.h"
+#include "os.h"
+#include "str_transform.h"
+
+#include <mutex>
+
+//------------------------------------------------------------------------------
+static std::mutex s_mutex;
+static std::shared_ptr<const alias_snapshot> s_snapshot;
+static uint32 s_length = 0;
+static uint32 s_hash = 0;
+static bool s_active = false;
+static bool s_invalid = false;
+
+//------------------------------------------------------------------------------
+static void to_key(const char* name, uint32 len, str_base& out)
+{
+    out.clear();
+    str_transform(name, len, out, transform_mode::lower);
+}
+
+//------------------------------------------------------------------------------
+static uint32 fetch_aliases(std::unique_ptr<wchar_t[]>& buffer)
+{
+    // Not const because Windows' alias API won't accept it.
+    wchar_t* shell_name = const_cast<wchar_t*>(os::get_shellname());
+
+    // The lengths are in bytes, not characters.
+    uint32 length = GetConsoleAliasesLengthW(shell_name);
+    if (length)
+    {
+        const uint32 count = length / sizeof(wchar_t) + 1;
+        buffer = std::unique_ptr<wchar_t[]>(new wchar_t[count]);
+        ZeroMemory(buffer.get(), count * sizeof(wchar_t));
+        if (!GetConsoleAliasesW(buffer.get(), length, shell_name))
+            length = 0;
+    }
+
+    return length / sizeof(wchar_t);
+}
+
+//------------------------------------------------------------------------------
+static uint32 hash_aliases(const wchar_t* buffer, uint32 length)
+{
+    // The buffer holds nul separated strings, so hash every character rather
+    // than stopping at the first nul.
+    uint32 hash = 5381;
+    for (uint32 i = 0; i < length; ++i)
+        hash = ((hash << 5) + hash) ^ buffer[i];
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const alias_snapshot> alias_snapshot::build(const wchar_t* buffer, uint32 length)
+{
+    std::shared_ptr<alias_snapshot> snapshot = std::make_shared<alias_snapshot>();
+    if (length)
+        snapshot->init(buffer, length);
+    return snapshot;
+}
+
+//------------------------------------------------------------------------------
+void alias_snapshot::init(const wchar_t* buffer, uint32 length)
+{
+    // The buffer is a sequence of nul terminated "name=text" strings.
+    str<> tmp;
+    const wchar_t* const end = buffer + length;
+    for (const wchar_t* p = buffer; p < end && *p;)
+    {
+        const uint32 len = uint32(wcsnlen(p, end - p));
+        const wchar_t* eq = wmemchr(p, '=', len);
+        if (eq)
+        {
+            alias a;
+            to_utf8(a.name, p, int32(eq - p));
+            to_key(a.name.c_str(), a.name.length(), tmp);
+            a.key = tmp.c_str();
+            to_utf8(a.text, eq + 1, int32(len - (eq + 1 - p)));
+            m_aliases.emplace_back(std::move(a));
+        }
+        p += len + 1;
+    }
+
+    m_index.reserve(m_aliases.size());
+    for (uint32 i = 0; i < m_aliases.size(); ++i)
+        m_index.emplace(m_aliases[i].key.c_str(), i);
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const alias_snapshot> alias_snapshot::get()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    if (!s_active)
+        return nullptr;
+
+    if (!s_snapshot || s_invalid)
+    {
+        std::unique_ptr<wchar_t[]> buffer;
+        s_length = fetch_aliases(buffer);
+        s_hash = hash_aliases(buffer.get(), s_length);
+        s_snapshot = build(buffer.get(), s_length);
+        s_invalid = false;
+    }
+
+    return s_snapshot;
+}
+
+//------------------------------------------------------------------------------
+bool alias_snapshot::refresh()
+{
+    // Fetching the table is one round trip to the console host; hashing it
+    // notices aliases being added, removed, or changed by running doskey
+    // between edits, even when the total length stays the same.  Parsing is
+    // only needed when something changed.
+    std::unique_ptr<wchar_t[]> buffer;
+    const uint32 length = fetch_aliases(buffer);
+    const uint32 hash = hash_aliases(buffer.get(), length);
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    s_active = true;
+    if (s_snapshot && !s_invalid && length == s_length && hash == s_hash)
+        return false;
+
+    s_length = length;
+    s_hash = hash;
+    s_snapshot = build(buffer.get(), length);
+    s_invalid = false;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void alias_snapshot::invalidate()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_invalid = true;
+}
+
+//------------------------------------------------------------------------------
+void alias_snapshot::reset()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_snapshot.reset();
+    s_active = false;
+    s_invalid = false;
+}
+
+//------------------------------------------------------------------------------
+const char* alias_snapshot::get_name(uint32 index) const
+{
+    return (index < m_aliases.size()) ? m_aliases[index].name.c_str() : nullptr;
+}
+
+//------------------------------------------------------------------------------
+bool alias_snapshot::find(const char* name, str_base& out) const
+{
+    str<32> key;
+    to_key(name, uint32(strlen(name)), key);
+
+    const auto iter = m_index.find(key.c_str());
+    if (iter == m_index.end())
+        return false;
+
+    out = m_aliases[iter->second].text.c_str();
+    return true;
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "env_snapshot.h"
+#include "os.h"
+#include "path.h"
+#include "str_hash.h"
+#include "str_tokeniser.h"
+#include "str_transform.h"
+
+#include <mutex>
+
+//------------------------------------------------------------------------------
+static std::mutex s_mutex;
+static std::shared_ptr<const env_snapshot> s_snapshot;
+static uint32 s_block_hash = 0;
+static uint32 s_generation = 0;
+
+//------------------------------------------------------------------------------
+static uint32 hash_environment_block()
+{
+    wchar_t* block = GetEnvironmentStringsW();
+    if (!block)
+        return 0;
+
+    // The block is a sequence of nul terminated strings, ending with an empty
+    // string.
+    uint32 hash = 5381;
+    for (const wchar_t* p = block; *p; ++p)
+    {
+        for (; *p; ++p)
+            hash = ((hash << 5) + hash) ^ *p;
+        hash = ((hash << 5) + hash);
+    }
+
+    FreeEnvironmentStringsW(block);
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+void env_snapshot::init(uint32 generation)
+{
+    m_generation = generation;
+
+    str<> value;
+    str<> token;
+    str<> tmp;
+
+    if (os::get_env("PATH", value))
+    {
+        str_tokeniser tokens(value.c_str(), ";");
+        tokens.add_quote_pair("\"");
+        while (tokens.next(token))
+        {
+            token.trim();
+            tmp.clear();
+            concat_strip_quotes(tmp, token.c_str(), token.length());
+            if (tmp.empty())
+                continue;
+
+            if (strchr(tmp.c_str(), '%') && os::expand_env(tmp.c_str(), tmp.length(), token))
+                tmp = token.c_str();
+
+            path::normalise_separators(tmp);
+            m_paths.emplace_back(tmp.c_str());
+        }
+    }
+
+    if (os::get_env("PATHEXT", value))
+    {
+        str_tokeniser tokens(value.c_str(), ";");
+        while (tokens.next(token))
+        {
+            token.trim();
+            if (token.empty())
+                continue;
+
+            tmp.clear();
+            str_transform(token.c_str(), token.length(), tmp, transform_mode::lower);
+            m_pathexts.emplace_back(tmp.c_str());
+        }
+    }
+
+    m_pathext_set.reserve(m_pathexts.size());
+    for (const auto& ext : m_pathexts)
+        m_pathext_set.emplace(ext.c_str());
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const env_snapshot> env_snapshot::get()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    if (!s_snapshot)
+    {
+        s_block_hash = hash_environment_block();
+        std::shared_ptr<env_snapshot> snapshot = std::make_shared<env_snapshot>();
+        snapshot->init(++s_generation);
+        s_snapshot = std::move(snapshot);
+    }
+
+    return s_snapshot;
+}
+
+//------------------------------------------------------------------------------
+bool env_snapshot::refresh()
+{
+    // Hashing the environment block is much cheaper than re-parsing PATH and
+    // PATHEXT, and it also catches changes to variables they reference.
+    const uint32 hash = hash_environment_block();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    if (s_snapshot && hash == s_block_hash)
+        return false;
+
+    s_block_hash = hash;
+    std::shared_ptr<env_snapshot> snapshot = std::make_shared<env_snapshot>();
+    snapshot->init(++s_generation);
+    s_snapshot = std::move(snapshot);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Called when %PATH% or %PATHEXT% is set from inside Clink (e.g. os.setenv()),
+// so the change takes effect immediately instead of at the next prompt.
+void env_snapshot::invalidate()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_snapshot.reset();
+}
+
+//------------------------------------------------------------------------------
+bool env_snapshot::is_pathext(const char* ext) const
+{
+    if (!ext || !*ext)
+        return false;
+
+    str<16> lower;
+    str_transform(ext, uint32(strlen(ext)), lower, transform_mode::lower);
+    return m_pathext_set.find(lower.c_str()) != m_pathext_set.end();
+}
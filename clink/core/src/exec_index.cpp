@@ -0,0 +1,396 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "exec_index.h"
+#include "env_snapshot.h"
+#include "globber.h"
+#include "os.h"
+#include "path.h"
+#include "str_transform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+//------------------------------------------------------------------------------
+struct exec_dir_file
+{
+    str_moveable        name;
+    str_moveable        key;
+    uint32              attr;
+    int32               st_mode;
+    uint16              ext;
+};
+
+//------------------------------------------------------------------------------
+struct exec_dir_scan
+{
+    str_moveable        dir;        // Full path name.
+    str_moveable        pathexts;   // %PATHEXT% the scan was filtered by.
+    FILETIME            modified = {};
+    bool                local = false;
+    std::vector<exec_dir_file> files;
+};
+
+
+
+//------------------------------------------------------------------------------
+static std::mutex s_mutex;
+static std::shared_ptr<const exec_index> s_index;
+static std::unique_ptr<std::thread> s_thread;
+static std::atomic<bool> s_building(false);
+static ULONGLONG s_last_refresh = 0;
+static const ULONGLONG c_refresh_interval = 2000;
+
+//------------------------------------------------------------------------------
+static void to_key(const char* in, str_base& out)
+{
+    out.clear();
+    str_transform(in, uint32(strlen(in)), out, transform_mode::lower);
+}
+
+//------------------------------------------------------------------------------
+static bool get_dir_modified(const char* dir, FILETIME& out)
+{
+    wstr<280> wdir(dir);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wdir.c_str(), GetFileExInfoStandard, &fad))
+        return false;
+
+    out = fad.ftLastWriteTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool is_local_dir(const char* dir)
+{
+    // Same rule the recognizer has always used:  UNC paths and drives that
+    // are unknown, invalid, or remote are not local.
+    if (!dir[0] || dir[1] != ':')
+        return false;
+
+    char drive[4];
+    drive[0] = dir[0];
+    drive[1] = ':';
+    drive[2] = '\\';
+    drive[3] = '\0';
+    return os::get_drive_type(drive) >= os::drive_type_removable;
+}
+
+//------------------------------------------------------------------------------
+static std::shared_ptr<const exec_dir_scan> scan_dir(const char* dir, const char* pathexts, const FILETIME& modified, const env_snapshot& env)
+{
+    auto scan = std::make_shared<exec_dir_scan>();
+    scan->dir = dir;
+    scan->pathexts = pathexts;
+    scan->modified = modified;
+    scan->local = is_local_dir(dir);
+
+    const auto& exts = env.get_pathexts();
+
+    str<280> pattern(dir);
+    path::append(pattern, "*");
+
+    globber globber(pattern.c_str());
+    globber.files(true);
+    globber.directories(false);
+    globber.hidden(true);
+    globber.system(true);
+
+    str<288> file;
+    str<288> key;
+    globber::extrainfo info;
+    while (globber.next(file, false, &info))
+    {
+        to_key(file.c_str(), key);
+        const char* ext = path::get_extension(key.c_str());
+        if (!ext)
+            continue;
+
+        uint32 ord = 0;
+        while (ord < exts.size() && !exts[ord].equals(ext))
+            ++ord;
+        if (ord >= exts.size() || ord > 0xffff)
+            continue;
+
+        exec_dir_file f;
+        f.name = file.c_str();
+        f.key = key.c_str();
+        f.attr = info.attr;
+        f.st_mode = info.st_mode;
+        f.ext = uint16(ord);
+        scan->files.emplace_back(std::move(f));
+    }
+
+    return scan;
+}
+
+
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const exec_index> exec_index::get()
+{
+    const std::shared_ptr<const env_snapshot> env = env_snapshot::get();
+
+    bool stale;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        // An index built from a different environment would give wrong
+        // answers, and relative %PATH% entries depend on the current
+        // directory; callers must search the file system themselves in those
+        // cases.
+        stale = (s_index && s_index->m_generation != env->get_generation());
+        if (s_index && !stale && s_index->m_complete)
+            return s_index;
+    }
+
+    // The environment changed since the index was built (e.g. os.setenv()
+    // changed %PATH%), so start rebuilding it now instead of waiting for the
+    // next prompt.
+    if (stale)
+        refresh();
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+void exec_index::refresh(bool force)
+{
+    const std::shared_ptr<const env_snapshot> env = env_snapshot::get();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    if (s_thread)
+    {
+        if (s_building)
+            return;
+        s_thread->join();
+        s_thread.reset();
+    }
+
+    const ULONGLONG now = GetTickCount64();
+    if (!force &&
+        s_index &&
+        s_index->m_generation == env->get_generation() &&
+        now - s_last_refresh < c_refresh_interval)
+        return;
+
+    s_last_refresh = now;
+    s_building = true;
+    s_thread = std::make_unique<std::thread>(&proc, env);
+}
+
+//------------------------------------------------------------------------------
+void exec_index::wait()
+{
+    std::unique_ptr<std::thread> thread;
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        thread = std::move(s_thread);
+    }
+
+    if (thread)
+        thread->join();
+}
+
+//------------------------------------------------------------------------------
+void exec_index::shutdown()
+{
+    wait();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_index.reset();
+}
+
+//------------------------------------------------------------------------------
+void exec_index::proc(std::shared_ptr<const env_snapshot> env)
+{
+    std::shared_ptr<const exec_index> prev;
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        prev = s_index;
+    }
+
+    std::shared_ptr<exec_index> index = std::make_shared<exec_index>();
+    index->build(env, prev.get());
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_index = std::move(index);
+    }
+
+    s_building = false;
+}
+
+//------------------------------------------------------------------------------
+void exec_index::build(const std::shared_ptr<const env_snapshot>& env, const exec_index* prev)
+{
+    m_env = env;
+    m_generation = env->get_generation();
+
+    // Scans are filtered by %PATHEXT%, so they can only be reused while it is
+    // unchanged.
+    str<> pathexts;
+    for (const auto& ext : env->get_pathexts())
+    {
+        pathexts.concat(ext.c_str(), ext.length());
+        pathexts.concat(";", 1);
+    }
+
+    const auto& paths = env->get_paths();
+    const uint32 count = uint32(min<size_t>(paths.size(), 0x10000));
+    m_dirs.reserve(count);
+
+    str<280> full;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        std::shared_ptr<const exec_dir_scan> scan;
+
+        const char* dir = paths[i].c_str();
+        if (!path::is_rooted(dir) || !os::get_full_path_name(dir, full))
+        {
+            m_complete = false;
+            auto empty = std::make_shared<exec_dir_scan>();
+            empty->dir = dir;
+            scan = std::move(empty);
+        }
+        else
+        {
+            FILETIME modified = {};
+            const bool has_modified = get_dir_modified(full.c_str(), modified);
+
+            // Reuse scans of directories that haven't changed.
+            if (has_modified)
+            {
+                scan = find_scan(full.c_str(), pathexts.c_str(), modified);
+                if (!scan && prev)
+                    scan = prev->find_scan(full.c_str(), pathexts.c_str(), modified);
+            }
+
+            if (!scan)
+                scan = scan_dir(full.c_str(), pathexts.c_str(), modified, *env);
+        }
+
+        for (const auto& f : scan->files)
+            m_entries.push_back({ f.name.c_str(), f.key.c_str(), f.attr, f.st_mode, uint16(i), f.ext });
+        m_dirs.emplace_back(std::move(scan));
+    }
+
+    std::sort(m_entries.begin(), m_entries.end(), [](const entry& a, const entry& b) {
+        const int32 cmp = strcmp(a.key, b.key);
+        if (cmp)
+            return cmp < 0;
+        if (a.dir != b.dir)
+            return a.dir < b.dir;
+        return a.ext < b.ext;
+    });
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const exec_dir_scan> exec_index::find_scan(const char* dir, const char* pathexts, const FILETIME& modified) const
+{
+    for (const auto& scan : m_dirs)
+    {
+        if (str_icmp(scan->dir.c_str(), dir) == 0 &&
+            scan->pathexts.equals(pathexts) &&
+            CompareFileTime(&scan->modified, &modified) == 0)
+            return scan;
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+const char* exec_index::get_dir(uint32 dir) const
+{
+    return (dir < m_dirs.size()) ? m_dirs[dir]->dir.c_str() : nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Returns whether any local directory changed since it was scanned.  This only
+// reads each directory's last write time, which is much cheaper than probing
+// each directory for each %PATHEXT% extension.
+bool exec_index::is_out_of_date() const
+{
+    for (const auto& scan : m_dirs)
+    {
+        if (!scan->local)
+            continue;
+
+        FILETIME modified = {};
+        get_dir_modified(scan->dir.c_str(), modified);
+        if (CompareFileTime(&scan->modified, &modified) != 0)
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+bool exec_index::is_local(uint32 dir) const
+{
+    return (dir < m_dirs.size()) && m_dirs[dir]->local;
+}
+
+//------------------------------------------------------------------------------
+void exec_index::find_prefix(const char* prefix, std::vector<const entry*>& out, bool local_only) const
+{
+    str<> key;
+    to_key(prefix, key);
+
+    auto iter = std::lower_bound(m_entries.begin(), m_entries.end(), key.c_str(), [](const entry& e, const char* k) {
+        return strcmp(e.key, k) < 0;
+    });
+
+    // Entries with the same name are sorted by directory, so the first one is
+    // the one that shadows the rest.
+    const char* last = nullptr;
+    for (; iter != m_entries.end(); ++iter)
+    {
+        if (strncmp(iter->key, key.c_str(), key.length()) != 0)
+            break;
+        if (local_only && !is_local(iter->dir))
+            continue;
+        if (last && strcmp(last, iter->key) == 0)
+            continue;
+
+        last = iter->key;
+        out.push_back(&*iter);
+    }
+}
+
+//------------------------------------------------------------------------------
+const exec_index::entry* exec_index::find_command(const char* word, bool local_only) const
+{
+    // Resolves the way CreateProcess searches %PATH%:  each directory in
+    // order, and within a directory each %PATHEXT% extension in order.
+    str<> key;
+    to_key(word, key);
+    const uint32 base = key.length();
+
+    const entry* found = nullptr;
+    const auto& exts = m_env->get_pathexts();
+    for (const auto& ext : exts)
+    {
+        key.truncate(base);
+        key.concat(ext.c_str(), ext.length());
+
+        auto iter = std::lower_bound(m_entries.begin(), m_entries.end(), key.c_str(), [](const entry& e, const char* k) {
+            return strcmp(e.key, k) < 0;
+        });
+
+        for (; iter != m_entries.end() && strcmp(iter->key, key.c_str()) == 0; ++iter)
+        {
+            if (local_only && !is_local(iter->dir))
+                continue;
+            if (!found || iter->dir < found->dir)
+                found = &*iter;
+            break;
+        }
+    }
+
+    return found;
+}
@@ -8,9 +8,348 @@
 #include "str.h"
 
 #include <sys/stat.h>
+#include <mutex>
+#include <vector>
 
 //------------------------------------------------------------------------------
-globber::globber(const char* pattern)
+// Starts an enumeration that skips generating short names and asks the file
+// system to return entries in large batches, so that FindNextFileW is usually
+// served from an already filled buffer rather than making a request per entry.
+// Falls back to plain FindFirstFileW if the OS rejects the extended options.
+static HANDLE find_first_file(const wchar_t* pattern, WIN32_FIND_DATAW* data)
+{
+    static bool s_basic_large_fetch = true;
+    if (s_basic_large_fetch)
+    {
+        HANDLE h = FindFirstFileExW(pattern, FindExInfoBasic, data, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+        if (h != INVALID_HANDLE_VALUE || GetLastError() != ERROR_INVALID_PARAMETER)
+            return h;
+        s_basic_large_fetch = false;
+    }
+
+    return FindFirstFileW(pattern, data);
+}
+
+//------------------------------------------------------------------------------
+struct dir_listing
+{
+    struct file
+    {
+        uint32              name;           // Offset into names.
+        uint32              name_len;
+        uint32              attr;
+        uint32              reparse_tag;
+        uint32              size_low;
+        uint32              size_high;
+        FILETIME            accessed;
+        FILETIME            modified;
+        FILETIME            created;
+    };
+
+    std::vector<file>       files;
+    std::vector<wchar_t>    names;
+};
+
+//------------------------------------------------------------------------------
+// Process-wide cache of recently enumerated directories.  Listings are shared
+// with any globbers iterating them, so evicting or invalidating an entry never
+// disturbs a globber in progress.
+class dir_cache
+{
+public:
+                            dir_cache() = default;
+                            ~dir_cache();
+    std::shared_ptr<const dir_listing> find(const wchar_t* dir);
+    std::shared_ptr<const dir_listing> fill(const wchar_t* dir);
+    void                    set_ttl(uint32 seconds);
+    uint32                  sweep();
+    uint32                  get_ttl() const { return m_ttl; }
+    void                    get_stats(globber::cache_stats& out);
+
+private:
+    struct entry
+    {
+        wstr_moveable       dir;
+        HANDLE              notify;
+        FILETIME            modified;
+        ULONGLONG           filled_tick;
+        ULONGLONG           used_tick;
+        std::shared_ptr<const dir_listing> listing;
+    };
+
+    static bool             get_dir_modified(const wchar_t* dir, FILETIME& out);
+    static bool             can_notify(const wchar_t* dir);
+    bool                    is_expired(const entry& e, ULONGLONG now) const;
+    bool                    is_stale(const entry& e, ULONGLONG now) const;
+    void                    erase(size_t index);
+    void                    make_room(size_t files);
+
+    std::vector<entry>      m_entries;
+    std::mutex              m_mutex;
+    volatile uint32         m_ttl = 5;
+    size_t                  m_files = 0;
+    uint32                  m_lookups = 0;
+    uint32                  m_hits = 0;
+    uint32                  m_invalidations = 0;
+
+    static const size_t     c_max_dirs = 16;
+    static const size_t     c_max_files = 250000;
+    static const DWORD      c_notify_filter = (FILE_NOTIFY_CHANGE_FILE_NAME|
+                                               FILE_NOTIFY_CHANGE_DIR_NAME|
+                                               FILE_NOTIFY_CHANGE_ATTRIBUTES|
+                                               FILE_NOTIFY_CHANGE_SIZE|
+                                               FILE_NOTIFY_CHANGE_LAST_WRITE);
+};
+
+static dir_cache s_dir_cache;
+
+//------------------------------------------------------------------------------
+dir_cache::~dir_cache()
+{
+    while (m_entries.size())
+        erase(m_entries.size() - 1);
+}
+
+//------------------------------------------------------------------------------
+bool dir_cache::get_dir_modified(const wchar_t* dir, FILETIME& out)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(dir, GetFileExInfoStandard, &data))
+        return false;
+    out = data.ftLastWriteTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// A change notification handle keeps the directory open, which can keep a
+// deleted directory pending delete, or prevent ejecting a removable drive.  So
+// only use them on fixed drives.
+bool dir_cache::can_notify(const wchar_t* dir)
+{
+    WCHAR root[MAX_PATH];
+    if (!GetVolumePathNameW(dir, root, sizeof_array(root)))
+        return false;
+
+    switch (GetDriveTypeW(root))
+    {
+    case DRIVE_FIXED:
+    case DRIVE_RAMDISK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool dir_cache::is_expired(const entry& e, ULONGLONG now) const
+{
+    return now - e.filled_tick >= ULONGLONG(m_ttl) * 1000;
+}
+
+//------------------------------------------------------------------------------
+bool dir_cache::is_stale(const entry& e, ULONGLONG now) const
+{
+    if (is_expired(e, now))
+        return true;
+
+    // Prefer change notifications.  Some file systems (e.g. some network
+    // shares) don't support them, so fall back to the directory's modified
+    // time, which changes when entries are added, removed, or renamed.
+    if (e.notify)
+        return WaitForSingleObject(e.notify, 0) != WAIT_TIMEOUT;
+
+    FILETIME modified;
+    if (!get_dir_modified(e.dir.c_str(), modified))
+        return true;
+    return CompareFileTime(&modified, &e.modified) != 0;
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::erase(size_t index)
+{
+    entry& e = m_entries[index];
+    if (e.notify)
+        FindCloseChangeNotification(e.notify);
+    m_files -= e.listing->files.size();
+    m_entries.erase(m_entries.begin() + index);
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::make_room(size_t files)
+{
+    while (m_entries.size() && (m_entries.size() >= c_max_dirs || m_files + files > c_max_files))
+    {
+        size_t lru = 0;
+        for (size_t i = 1; i < m_entries.size(); ++i)
+        {
+            if (m_entries[i].used_tick < m_entries[lru].used_tick)
+                lru = i;
+        }
+        erase(lru);
+    }
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const dir_listing> dir_cache::find(const wchar_t* dir)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ++m_lookups;
+
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        entry& e = m_entries[i];
+        if (_wcsicmp(e.dir.c_str(), dir) != 0)
+            continue;
+
+        const ULONGLONG now = GetTickCount64();
+        if (is_stale(e, now))
+        {
+            ++m_invalidations;
+            erase(i);
+            return nullptr;
+        }
+
+        ++m_hits;
+        e.used_tick = now;
+        return e.listing;
+    }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const dir_listing> dir_cache::fill(const wchar_t* dir)
+{
+    // Set up change notification before enumerating, so that any changes
+    // during enumeration invalidate the listing.
+    HANDLE notify = nullptr;
+    if (can_notify(dir))
+    {
+        notify = FindFirstChangeNotificationW(dir, false, c_notify_filter);
+        if (notify == INVALID_HANDLE_VALUE)
+            notify = nullptr;
+    }
+
+    FILETIME modified = {};
+    if (!notify && !get_dir_modified(dir, modified))
+        return nullptr;
+
+    wstr<280> wglob(dir);
+    if (!path::is_separator(wglob.c_str()[wglob.length() - 1]))
+        wglob << L"\\";
+    wglob << L"*";
+
+    WIN32_FIND_DATAW data;
+    HANDLE h = find_first_file(wglob.c_str(), &data);
+    if (h == INVALID_HANDLE_VALUE)
+    {
+        if (notify)
+            FindCloseChangeNotification(notify);
+        return nullptr;
+    }
+
+    std::shared_ptr<dir_listing> listing = std::make_shared<dir_listing>();
+    do
+    {
+        dir_listing::file f;
+        f.name = uint32(listing->names.size());
+        f.name_len = uint32(wcslen(data.cFileName));
+        f.attr = data.dwFileAttributes;
+        f.reparse_tag = data.dwReserved0;
+        f.size_low = data.nFileSizeLow;
+        f.size_high = data.nFileSizeHigh;
+        f.accessed = data.ftLastAccessTime;
+        f.modified = data.ftLastWriteTime;
+        f.created = data.ftCreationTime;
+        listing->names.insert(listing->names.end(), data.cFileName, data.cFileName + f.name_len + 1);
+        listing->files.emplace_back(std::move(f));
+    }
+    while (FindNextFileW(h, &data));
+    FindClose(h);
+
+    const size_t files = listing->files.size();
+    if (files > c_max_files)
+    {
+        // Too big to cache, but the listing can still be used once.
+        if (notify)
+            FindCloseChangeNotification(notify);
+        return listing;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        if (_wcsicmp(m_entries[i].dir.c_str(), dir) == 0)
+        {
+            erase(i);
+            break;
+        }
+    }
+
+    make_room(files);
+
+    entry e;
+    e.dir = dir;
+    e.notify = notify;
+    e.modified = modified;
+    e.filled_tick = e.used_tick = GetTickCount64();
+    e.listing = listing;
+    m_entries.emplace_back(std::move(e));
+    m_files += files;
+
+    return listing;
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::set_ttl(uint32 seconds)
+{
+    m_ttl = seconds;
+    sweep();
+}
+
+//------------------------------------------------------------------------------
+// Drops expired entries, so their change notification handles don't keep the
+// directories open.  Returns how many milliseconds until the next entry
+// expires, or -1 if there are no entries.
+uint32 dir_cache::sweep()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const ULONGLONG now = GetTickCount64();
+    const ULONGLONG ttl = ULONGLONG(m_ttl) * 1000;
+    ULONGLONG next = ULONGLONG(-1);
+
+    for (size_t i = m_entries.size(); i--;)
+    {
+        const entry& e = m_entries[i];
+        if (is_expired(e, now))
+            erase(i);
+        else
+            next = min(next, e.filled_tick + ttl - now);
+    }
+
+    return (next < ULONGLONG(uint32(-1))) ? uint32(next) : uint32(-1);
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::get_stats(globber::cache_stats& out)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    out.lookups = m_lookups;
+    out.hits = m_hits;
+    out.invalidations = m_invalidations;
+    out.directories = uint32(m_entries.size());
+    out.files = uint32(m_files);
+}
+
+
+
+
+//------------------------------------------------------------------------------
+globber::globber(const char* pattern, bool cached)
 : m_files(true)
 , m_directories(true)
 , m_dir_suffix(true)
@@ -62,13 +401,17 @@ globber::globber(const char* pattern)
         }
     }
 
+    path::get_directory(pattern, m_root);
+    path::normalise_separators(m_root.data());
+
+    m_handle = nullptr;
+    if (cached && s_dir_cache.get_ttl() && find_cached(pattern))
+        return;
+
     wstr<280> wglob(pattern);
-    m_handle = FindFirstFileW(wglob.c_str(), &m_data);
+    m_handle = find_first_file(wglob.c_str(), &m_data);
     if (m_handle == INVALID_HANDLE_VALUE)
         m_handle = nullptr;
-
-    path::get_directory(pattern, m_root);
-    path::normalise_separators(m_root.data());
 }
 
 //------------------------------------------------------------------------------
@@ -77,6 +420,88 @@ globber::~globber()
     close();
 }
 
+//------------------------------------------------------------------------------
+bool globber::find_cached(const char* pattern)
+{
+    // Only `prefix*` patterns are served from the cache, since they can be
+    // matched against the cached long names with a simple prefix comparison.
+    // Other wildcards have special rules in FindFirstFileW (for example `*.*`
+    // and `foo.*`, or matching against short names), so those enumerate the
+    // file system directly.
+    const char* name = path::get_name(pattern);
+    const uint32 len = uint32(strlen(name));
+    if (!len || name[len - 1] != '*')
+        return false;
+    for (uint32 i = 0; i < len - 1; ++i)
+    {
+        if (strchr("*?<>\"~", name[i]))
+            return false;
+    }
+    if (len > 1 && name[len - 2] == '.')
+        return false;
+
+    str<288> dir;
+    path::get_directory(pattern, dir);
+    if (dir.empty())
+        dir = ".";
+
+    wstr<288> wdir(dir.c_str());
+    wstr<288> wfull;
+    DWORD full_len = GetFullPathNameW(wdir.c_str(), 0, nullptr, nullptr);
+    if (!full_len || !wfull.reserve(full_len))
+        return false;
+    full_len = GetFullPathNameW(wdir.c_str(), wfull.size() - 1, wfull.data(), nullptr);
+    if (!full_len || full_len >= wfull.size())
+        return false;
+
+    std::shared_ptr<const dir_listing> listing = s_dir_cache.find(wfull.c_str());
+    if (!listing)
+        listing = s_dir_cache.fill(wfull.c_str());
+    if (!listing)
+        return false;
+
+    str<32> prefix;
+    prefix.concat(name, len - 1);
+    m_prefix = prefix.c_str();
+
+    m_listing = std::move(listing);
+    m_listing_index = 0;
+    if (!next_cached())
+        close();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool globber::next_cached()
+{
+    const uint32 prefix_len = m_prefix.length();
+    const auto& files = m_listing->files;
+    while (m_listing_index < files.size())
+    {
+        const auto& f = files[m_listing_index++];
+        const wchar_t* name = &m_listing->names[f.name];
+        if (f.name_len < prefix_len)
+            continue;
+        if (prefix_len && CompareStringOrdinal(name, prefix_len, m_prefix.c_str(), prefix_len, true) != CSTR_EQUAL)
+            continue;
+        if (f.name_len >= sizeof_array(m_data.cFileName))
+            continue;
+
+        memcpy(m_data.cFileName, name, (f.name_len + 1) * sizeof(*name));
+        m_data.cAlternateFileName[0] = '\0';
+        m_data.dwFileAttributes = f.attr;
+        m_data.dwReserved0 = f.reparse_tag;
+        m_data.nFileSizeLow = f.size_low;
+        m_data.nFileSizeHigh = f.size_high;
+        m_data.ftLastAccessTime = f.accessed;
+        m_data.ftLastWriteTime = f.modified;
+        m_data.ftCreationTime = f.created;
+        return true;
+    }
+
+    return false;
+}
+
 //------------------------------------------------------------------------------
 bool globber::older_than(int32 seconds)
 {
@@ -106,7 +531,7 @@ bool globber::next(str_base& out, bool rooted, extrainfo* extrainfo)
 {
     while (true)
     {
-        if (m_handle == nullptr)
+        if (m_handle == nullptr && !m_listing)
             return false;
 
         bool again = false;
@@ -177,11 +602,37 @@ void globber::close()
         FindClose(m_handle);
         m_handle = nullptr;
     }
+    m_listing.reset();
+}
+
+//------------------------------------------------------------------------------
+void globber::set_cache_ttl(uint32 seconds)
+{
+    s_dir_cache.set_ttl(seconds);
+}
+
+//------------------------------------------------------------------------------
+uint32 globber::sweep_cache()
+{
+    return s_dir_cache.sweep();
+}
+
+//------------------------------------------------------------------------------
+void globber::get_cache_stats(cache_stats& out)
+{
+    s_dir_cache.get_stats(out);
 }
 
 //------------------------------------------------------------------------------
 void globber::next_file()
 {
-    if (m_handle && !FindNextFileW(m_handle, &m_data))
+    if (m_listing)
+    {
+        if (!next_cached())
+            close();
+    }
+    else if (m_handle && !FindNextFileW(m_handle, &m_data))
+    {
         close();
+    }
 }
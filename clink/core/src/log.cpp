@@ -5,6 +5,8 @@
 #include "log.h"
 #include "os.h"
 
+#include <atomic>
+#include <process.h>
 #include <stdarg.h>
 
 //------------------------------------------------------------------------------
@@ -161,6 +163,335 @@ void logger::end_group(size_t rollback_index, bool discard)
 
 
 
+//------------------------------------------------------------------------------
+static const uint32 c_ring_size = 4096;         // Must be a power of 2.
+static const DWORD c_flush_interval = 50;       // Milliseconds between batches.
+static const DWORD c_idle_close = 1000;         // Close the file when idle.
+static const uint32 c_max_batch = 64 * 1024;
+static const uint32 c_max_pending = 1024 * 1024;
+static const LONGLONG c_max_log_size = 16 * 1024 * 1024;
+
+//------------------------------------------------------------------------------
+// Bounded multi-producer single-consumer ring of formatted lines, drained by a
+// writer thread.  Producers never block; when the ring is full the line is
+// dropped and counted.
+struct log_writer
+{
+    struct cell
+    {
+        std::atomic<uint32> seq;
+        char*           msg;
+        uint32          len;
+    };
+
+                        log_writer(const char* path);
+                        ~log_writer();
+    void                push(const char* msg, uint32 len);
+    void                flush();
+    uint32              get_dropped() const { return m_dropped; }
+
+private:
+    void                start();
+    bool                lock_consumer(DWORD timeout);
+    void                unlock_consumer();
+    void                drain();
+    void                write();
+    bool                open();
+    void                close();
+    bool                is_same_file() const;
+    void                maybe_rotate(LONGLONG size);
+    static unsigned __stdcall threadproc(void* param);
+
+    str_moveable        m_path;
+    cell                m_cells[c_ring_size];
+    std::atomic<uint32> m_enqueue_pos;
+    uint32              m_dequeue_pos = 0;
+    std::atomic<uint32> m_dropped;
+    uint32              m_reported_dropped = 0;
+    std::atomic<bool>   m_consuming;
+    std::atomic<bool>   m_started;
+    std::atomic<bool>   m_stop;
+    std::atomic<bool>   m_sync;
+    HANDLE              m_file = INVALID_HANDLE_VALUE;
+    HANDLE              m_wake = nullptr;
+    HANDLE              m_thread = nullptr;
+    DWORD               m_last_write = 0;
+    str_moveable        m_batch;
+};
+
+//------------------------------------------------------------------------------
+log_writer::log_writer(const char* path)
+: m_enqueue_pos(0)
+, m_dropped(0)
+, m_consuming(false)
+, m_started(false)
+, m_stop(false)
+, m_sync(false)
+{
+    m_path = path;
+    for (uint32 i = 0; i < c_ring_size; ++i)
+    {
+        m_cells[i].seq.store(i, std::memory_order_relaxed);
+        m_cells[i].msg = nullptr;
+        m_cells[i].len = 0;
+    }
+    m_wake = CreateEvent(nullptr, false, false, nullptr);
+}
+
+//------------------------------------------------------------------------------
+log_writer::~log_writer()
+{
+    m_stop = true;
+    if (m_thread)
+    {
+        // Don't wait indefinitely; this can run during process exit, after
+        // the writer thread has already been terminated.
+        SetEvent(m_wake);
+        if (WaitForSingleObject(m_thread, 1000) == WAIT_OBJECT_0)
+        {
+            // The thread is gone, so a consumer lock it still holds (it was
+            // terminated mid-drain) is abandoned and can be reclaimed.
+            m_consuming.store(false, std::memory_order_release);
+        }
+        CloseHandle(m_thread);
+    }
+
+    // Don't touch the file while a still-running writer thread owns it.
+    if (lock_consumer(200))
+    {
+        drain();
+        close();
+        unlock_consumer();
+    }
+
+    if (m_wake)
+        CloseHandle(m_wake);
+}
+
+//------------------------------------------------------------------------------
+void log_writer::push(const char* msg, uint32 len)
+{
+    uint32 pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    cell* c;
+    while (true)
+    {
+        c = &m_cells[pos & (c_ring_size - 1)];
+        const int32 dif = int32(c->seq.load(std::memory_order_acquire) - pos);
+        if (dif == 0)
+        {
+            if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+        {
+            ++m_dropped;
+            return;
+        }
+        else
+        {
+            pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    c->msg = static_cast<char*>(malloc(len));
+    c->len = c->msg ? len : 0;
+    if (c->msg)
+        memcpy(c->msg, msg, len);
+    c->seq.store(pos + 1, std::memory_order_release);
+
+    if (!m_started.exchange(true))
+        start();
+
+    if (m_sync)
+        flush();
+    else if ((pos & (c_ring_size / 4 - 1)) == 0)
+        SetEvent(m_wake); // Don't wait for the timer when the ring fills up.
+}
+
+//------------------------------------------------------------------------------
+void log_writer::flush()
+{
+    // Only drain while holding the consumer lock.  If the writer thread is
+    // busy (e.g. blocked on disk I/O) it will drain the ring itself when it
+    // finishes; draining concurrently would duplicate or corrupt lines.
+    if (lock_consumer(200))
+    {
+        drain();
+        unlock_consumer();
+    }
+}
+
+//------------------------------------------------------------------------------
+void log_writer::start()
+{
+    if (m_wake)
+        m_thread = reinterpret_cast<HANDLE>(_beginthreadex(nullptr, 0, &threadproc, this, 0, nullptr));
+    if (!m_thread)
+        m_sync = true;
+}
+
+//------------------------------------------------------------------------------
+bool log_writer::lock_consumer(DWORD timeout)
+{
+    const DWORD begin = GetTickCount();
+    while (m_consuming.exchange(true, std::memory_order_acquire))
+    {
+        if (GetTickCount() - begin >= timeout)
+            return false;
+        Sleep(1);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void log_writer::unlock_consumer()
+{
+    m_consuming.store(false, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+void log_writer::drain()
+{
+    while (true)
+    {
+        cell& c = m_cells[m_dequeue_pos & (c_ring_size - 1)];
+        if (int32(c.seq.load(std::memory_order_acquire) - (m_dequeue_pos + 1)) < 0)
+            break;
+
+        if (c.msg)
+        {
+            m_batch.concat(c.msg, c.len);
+            free(c.msg);
+            c.msg = nullptr;
+        }
+        c.seq.store(m_dequeue_pos + c_ring_size, std::memory_order_release);
+        ++m_dequeue_pos;
+
+        if (m_batch.length() >= c_max_batch)
+            write();
+    }
+
+    const uint32 dropped = m_dropped;
+    if (dropped != m_reported_dropped)
+    {
+        str<> tmp;
+        tmp.format("%04x %-24s %4d *** DROPPED %u LOG LINES ***\r\n", GetCurrentProcessId(), "log_writer", 0, dropped - m_reported_dropped);
+        m_batch.concat(tmp.c_str(), tmp.length());
+        m_reported_dropped = dropped;
+    }
+
+    if (m_batch.length())
+        write();
+}
+
+//------------------------------------------------------------------------------
+void log_writer::write()
+{
+    if (m_file == INVALID_HANDLE_VALUE && !open())
+    {
+        // The file may be pending deletion while another process still has
+        // it open; keep the lines and retry on the next batch.
+        if (m_batch.length() > c_max_pending)
+            m_batch.clear();
+        return;
+    }
+
+    DWORD written;
+    WriteFile(m_file, m_batch.c_str(), m_batch.length(), &written, nullptr);
+    m_batch.clear();
+    m_last_write = GetTickCount();
+
+    // If the file was deleted (e.g. another process restarted the log) then
+    // close it so the deletion can complete, and reopen on the next batch.
+    FILE_STANDARD_INFO info;
+    if (GetFileInformationByHandleEx(m_file, FileStandardInfo, &info, sizeof(info)))
+    {
+        if (info.DeletePending)
+            close();
+        else
+            maybe_rotate(info.EndOfFile.QuadPart);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool log_writer::open()
+{
+    // Other processes write to the same log file, and may delete or rotate
+    // it while it's open here.
+    wstr<280> wpath(m_path.c_str());
+    m_file = CreateFileW(wpath.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    return (m_file != INVALID_HANDLE_VALUE);
+}
+
+//------------------------------------------------------------------------------
+void log_writer::close()
+{
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool log_writer::is_same_file() const
+{
+    wstr<280> wpath(m_path.c_str());
+    HANDLE h = CreateFileW(wpath.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    BY_HANDLE_FILE_INFORMATION a;
+    BY_HANDLE_FILE_INFORMATION b;
+    const bool same = (GetFileInformationByHandle(m_file, &a) &&
+                       GetFileInformationByHandle(h, &b) &&
+                       a.dwVolumeSerialNumber == b.dwVolumeSerialNumber &&
+                       a.nFileIndexHigh == b.nFileIndexHigh &&
+                       a.nFileIndexLow == b.nFileIndexLow);
+    CloseHandle(h);
+    return same;
+}
+
+//------------------------------------------------------------------------------
+void log_writer::maybe_rotate(LONGLONG size)
+{
+    if (size < c_max_log_size)
+        return;
+
+    // Another process may have rotated the file already, in which case just
+    // reopen the path.
+    if (is_same_file())
+    {
+        str<280> old(m_path.c_str());
+        old << ".1";
+        wstr<280> wpath(m_path.c_str());
+        wstr<280> wold(old.c_str());
+        MoveFileExW(wpath.c_str(), wold.c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+
+    close();
+}
+
+//------------------------------------------------------------------------------
+unsigned __stdcall log_writer::threadproc(void* param)
+{
+    log_writer* writer = static_cast<log_writer*>(param);
+    while (!writer->m_stop)
+    {
+        WaitForSingleObject(writer->m_wake, c_flush_interval);
+        if (writer->lock_consumer(INFINITE))
+        {
+            writer->drain();
+            if (writer->m_file != INVALID_HANDLE_VALUE && GetTickCount() - writer->m_last_write >= c_idle_close)
+                writer->close();
+            writer->unlock_consumer();
+        }
+    }
+    return 0;
+}
+
+
+
 //------------------------------------------------------------------------------
 const file_logger* file_logger::s_this = nullptr;
 
@@ -168,6 +499,7 @@ const file_logger* file_logger::s_this = nullptr;
 file_logger::file_logger(const char* log_path)
 {
     m_log_path << log_path;
+    m_writer = new log_writer(log_path);
     s_this = this;
 }
 
@@ -175,27 +507,49 @@ file_logger::file_logger(const char* log_path)
 file_logger::~file_logger()
 {
     s_this = nullptr;
+    delete m_writer;
 }
 
 //------------------------------------------------------------------------------
 void file_logger::emit_impl(const char* function, int32 line, const char* msg)
 {
-    FILE* file;
-
-    file = fopen(m_log_path.c_str(), "at");
-    if (file == nullptr)
-        return;
-
     str<24> func_name;
     func_name << function;
 
     DWORD pid = GetCurrentProcessId();
 
+    // The log file has always had CRLF line endings (it used to be written
+    // in text mode), including for newlines embedded in the message.
     str<256> buffer;
-    buffer.format("%04x %-24s %4d %s\n", pid, func_name.c_str(), line, msg);
-    fputs(buffer.c_str(), file);
+    buffer.format("%04x %-24s %4d ", pid, func_name.c_str(), line);
+    for (const char* walk = msg; *walk;)
+    {
+        const char* eol = strchr(walk, '\n');
+        if (!eol)
+        {
+            buffer.concat(walk);
+            break;
+        }
+        const uint32 len = uint32(eol - walk);
+        buffer.concat(walk, (len && eol[-1] == '\r') ? len - 1 : len);
+        buffer.concat("\r\n", 2);
+        walk = eol + 1;
+    }
+    buffer.concat("\r\n", 2);
+    m_writer->push(buffer.c_str(), buffer.length());
+}
+
+//------------------------------------------------------------------------------
+uint32 file_logger::get_dropped()
+{
+    return s_this ? s_this->m_writer->get_dropped() : 0;
+}
 
-    fclose(file);
+//------------------------------------------------------------------------------
+void file_logger::flush()
+{
+    if (s_this)
+        s_this->m_writer->flush();
 }
 
 
@@ -3,7 +3,9 @@
 
 #include "pch.h"
 #include "os.h"
+#include "alias_snapshot.h"
 #include "cwd_restorer.h"
+#include "env_snapshot.h"
 #include "path.h"
 #include "str.h"
 #include "str_iter.h"
@@ -435,7 +437,7 @@ int32 get_pushd_depth() { return s_pushd_depth; }
 
 //------------------------------------------------------------------------------
 static const wchar_t* s_shell_name = L"cmd.exe";
-void set_shellname(const wchar_t* shell_name) { s_shell_name = shell_name; }
+void set_shellname(const wchar_t* shell_name) { s_shell_name = shell_name; alias_snapshot::invalidate(); }
 const wchar_t* get_shellname() { return s_shell_name; }
 
 //------------------------------------------------------------------------------
@@ -973,7 +975,11 @@ bool set_env(const char* name, const char* value)
     // setting PROMPT from inside Clink.
     const wchar_t* value_arg = (value != nullptr) ? wvalue.c_str() : nullptr;
     if (SetEnvironmentVariableW(wname.c_str(), value_arg) != 0)
+    {
+        if (stricmp(name, "PATH") == 0 || stricmp(name, "PATHEXT") == 0)
+            env_snapshot::invalidate();
         return true;
+    }
 
     map_errno();
     return false;
@@ -982,6 +988,15 @@ bool set_env(const char* name, const char* value)
 //------------------------------------------------------------------------------
 bool get_alias(const char* name, str_base& out)
 {
+    // During an edit session the alias table is fetched once in bulk.
+    if (std::shared_ptr<const alias_snapshot> snapshot = alias_snapshot::get())
+    {
+        if (snapshot->find(name, out) && !out.empty())
+            return true;
+        errno = ENOENT;
+        return false;
+    }
+
     wstr<32> alias_name;
     alias_name = name;
 
@@ -1015,6 +1030,7 @@ bool set_alias(const char* name, const char* command)
     {
         wstr<32> wname(name);
         wstr<32> wcommand(command);
+        alias_snapshot::invalidate();
         if (AddConsoleAliasW(wname.data(), wcommand.data(), const_cast<wchar_t*>(s_shell_name)))
             return true;
         map_errno();
@@ -3,32 +3,16 @@
 
 #include "pch.h"
 #include "base.h"
+#include "env_snapshot.h"
 #include "path.h"
 #include "os.h"
 #include "str.h"
 #include "str_tokeniser.h"
 
 #include <string>
-#include <map>
 
 #include <Shlobj.h>
 
-//------------------------------------------------------------------------------
-struct ext_comparer
-{
-    bool operator()(const std::wstring& a, const std::wstring& b) const
-    {
-        return (CompareStringW(LOCALE_USER_DEFAULT,
-                               NORM_IGNORECASE|NORM_LINGUISTIC_CASING,
-                               a.c_str(), int32(a.length()),
-                               b.c_str(), int32(b.length())) == CSTR_LESS_THAN);
-    }
-};
-
-//------------------------------------------------------------------------------
-static bool s_have_pathexts = false;
-static std::map<std::wstring, bool, ext_comparer> s_pathexts;
-
 namespace path {
 
 //------------------------------------------------------------------------------
@@ -114,15 +98,6 @@ static int32 get_directory_end(const char* path)
 
 
 
-//------------------------------------------------------------------------------
-void refresh_pathext()
-{
-    s_have_pathexts = false;
-    s_pathexts.clear();
-}
-
-
-
 //------------------------------------------------------------------------------
 void normalise(str_base& in_out, int32 sep)
 {
@@ -783,34 +758,7 @@ bool is_executable_extension(const char* in)
     if (!ext)
         return false;
 
-    if (!s_have_pathexts)
-    {
-        str<> pathext;
-        if (!os::get_env("pathext", pathext))
-            return false;
-
-        str_tokeniser tokens(pathext.c_str(), ";");
-        const char *start;
-        int32 length;
-
-        wstr<> wtoken;
-        while (str_token token = tokens.next(start, length))
-        {
-            str_iter rhs(start, length);
-            wtoken.clear();
-            to_utf16(wtoken, rhs);
-
-            s_pathexts.emplace(wtoken.c_str(), true);
-        }
-
-        s_have_pathexts = true;
-    }
-
-    wstr<> wext(ext);
-    if (s_pathexts.find(wext.c_str()) != s_pathexts.end())
-        return true;
-
-    return false;
+    return env_snapshot::get()->is_pathext(ext);
 }
 
 }; // namespace path
@@ -9,6 +9,11 @@
 #include <assert.h>
 #endif
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define USE_SSE2_UTF_CONVERSION
+#include <emmintrin.h>
+#endif
+
 //------------------------------------------------------------------------------
 template <typename TYPE>
 struct builder
@@ -62,6 +67,215 @@ builder<char>& builder<char>::operator << (int32 value)
 
 
 
+//------------------------------------------------------------------------------
+// The bulk conversions below only handle input whose conversion is the same
+// regardless of how str_iter treats malformed input:  ASCII, and well formed
+// 2 and 3 byte sequences.  They stop at anything else (including nul) and
+// leave it to the str_iter loops, so invalid input converts exactly as it
+// always has.
+//
+// The SIMD loops use aligned loads, so that a load never crosses into a page
+// that the scalar loops wouldn't have read.
+
+//------------------------------------------------------------------------------
+static bool is_aligned16(const void* p)
+{
+    return !(uintptr_t(p) & 15);
+}
+
+//------------------------------------------------------------------------------
+static bool is_continuation(char c)
+{
+    return (uint8(c) & 0xc0) == 0x80;
+}
+
+//------------------------------------------------------------------------------
+// Copies leading ASCII characters (excluding nul) from 'in' into 'out', up to
+// 'len' of them.  'out' may be nullptr to only count.  Returns the count.
+static uint32 widen_ascii(wchar_t* out, const char* in, uint32 len)
+{
+    uint32 i = 0;
+
+#ifdef USE_SSE2_UTF_CONVERSION
+    for (; i < len && !is_aligned16(in + i); ++i)
+    {
+        const uint8 c = in[i];
+        if (uint32(c) - 1 >= 0x7f)
+            return i;
+        if (out)
+            out[i] = c;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16)
+    {
+        // High bit set in any byte that is >= 0x80 or is nul.
+        const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(in + i));
+        if (_mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, zero))))
+            break;
+        if (out)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(v, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(v, zero));
+        }
+    }
+#endif
+
+    for (; i < len; ++i)
+    {
+        const uint8 c = in[i];
+        if (uint32(c) - 1 >= 0x7f)
+            break;
+        if (out)
+            out[i] = c;
+    }
+
+    return i;
+}
+
+//------------------------------------------------------------------------------
+// Copies leading ASCII characters (excluding nul) from 'in' into 'out', up to
+// 'len' of them.  'out' may be nullptr to only count.  Returns the count.
+static uint32 narrow_ascii(char* out, const wchar_t* in, uint32 len)
+{
+    uint32 i = 0;
+
+#ifdef USE_SSE2_UTF_CONVERSION
+    for (; i < len && !is_aligned16(in + i); ++i)
+    {
+        const uint32 c = in[i];
+        if (c - 1 >= 0x7f)
+            return i;
+        if (out)
+            out[i] = char(c);
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16)
+    {
+        // Saturating pack maps anything >= 0x80 to a byte >= 0x80, and
+        // anything >= 0x8000 to nul, so one test catches everything.
+        const __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+        const __m128i v = _mm_packus_epi16(lo, hi);
+        if (_mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, zero))))
+            break;
+        if (out)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+    }
+#endif
+
+    for (; i < len; ++i)
+    {
+        const uint32 c = in[i];
+        if (c - 1 >= 0x7f)
+            break;
+        if (out)
+            out[i] = char(c);
+    }
+
+    return i;
+}
+
+//------------------------------------------------------------------------------
+// Converts as much of 'in' as the bulk conversion can handle, writing at most
+// 'room' characters.  Returns the number of bytes consumed, and the number of
+// characters produced in 'written'.
+static uint32 bulk_to_utf16(wchar_t* out, uint32 room, const char* in, uint32 len, uint32& written)
+{
+    uint32 i = 0;
+    uint32 w = 0;
+    while (i < len && w < room)
+    {
+        const uint8 c = in[i];
+        if (uint32(c) - 1 < 0x7f)
+        {
+            const uint32 n = widen_ascii(out ? out + w : nullptr, in + i, min(len - i, room - w));
+            i += n;
+            w += n;
+        }
+        else if (c >= 0xc0 && c < 0xe0 && i + 1 < len && is_continuation(in[i + 1]))
+        {
+            // Overlong encodings of nul end the string, same as str_iter.
+            const uint32 d = ((c & 0x1f) << 6) | (in[i + 1] & 0x3f);
+            if (!d)
+                break;
+            if (out)
+                out[w] = wchar_t(d);
+            i += 2;
+            ++w;
+        }
+        else if (c >= 0xe0 && c < 0xf0 && i + 2 < len && is_continuation(in[i + 1]) && is_continuation(in[i + 2]))
+        {
+            const uint32 d = ((c & 0x0f) << 12) | ((in[i + 1] & 0x3f) << 6) | (in[i + 2] & 0x3f);
+            if (!d)
+                break;
+            if (out)
+                out[w] = wchar_t(d);
+            i += 3;
+            ++w;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    written = w;
+    return i;
+}
+
+//------------------------------------------------------------------------------
+// Converts as much of 'in' as the bulk conversion can handle, writing at most
+// 'room' bytes.  Returns the number of characters consumed, and the number of
+// bytes produced in 'written'.
+static uint32 bulk_to_utf8(char* out, uint32 room, const wchar_t* in, uint32 len, uint32& written)
+{
+    uint32 i = 0;
+    uint32 w = 0;
+    while (i < len && w < room)
+    {
+        const uint32 c = in[i];
+        if (c - 1 < 0x7f)
+        {
+            const uint32 n = narrow_ascii(out ? out + w : nullptr, in + i, min(len - i, room - w));
+            i += n;
+            w += n;
+        }
+        else if (c >= 0x80 && c < 0x800 && room - w >= 2)
+        {
+            if (out)
+            {
+                out[w + 0] = char(0xc0 | (c >> 6));
+                out[w + 1] = char(0x80 | (c & 0x3f));
+            }
+            ++i;
+            w += 2;
+        }
+        else if (c >= 0x800 && (c & 0xf800) != 0xd800 && room - w >= 3)
+        {
+            if (out)
+            {
+                out[w + 0] = char(0xe0 | (c >> 12));
+                out[w + 1] = char(0x80 | ((c >> 6) & 0x3f));
+                out[w + 2] = char(0x80 | (c & 0x3f));
+            }
+            ++i;
+            w += 3;
+        }
+        else
+        {
+            // Surrogates, nul, and sequences that would be truncated.
+            break;
+        }
+    }
+
+    written = w;
+    return i;
+}
+
+
+
 //------------------------------------------------------------------------------
 int32 to_utf8(char* out, int32 max_count, wstr_iter& iter)
 {
@@ -97,9 +311,25 @@ int32 to_utf8(char* out, int32 max_count, wstr_iter& iter)
 
     builder<char> builder(out, max_count);
 
+    const wchar_t* const end = iter.get_pointer() + iter.length();
+
     int32 c;
-    while (!builder.truncated() && (c = iter.next()))
+    while (!builder.truncated())
     {
+        // Convert runs in bulk where possible.
+        const wchar_t* ptr = iter.get_pointer();
+        const uint32 room = builder.start ? uint32(builder.end - builder.write) : uint32(-1);
+        uint32 written;
+        if (const uint32 consumed = bulk_to_utf8(builder.start ? builder.write : nullptr, room, ptr, uint32(end - ptr), written))
+        {
+            builder.write += written;
+            iter.advance(consumed);
+            continue;
+        }
+
+        if (!(c = iter.next()))
+            break;
+
         if (c < 0x80)
         {
             builder << c;
@@ -205,9 +435,26 @@ int32 to_utf16(wchar_t* out, int32 max_count, str_iter& iter)
 
     builder<wchar_t> builder(out, max_count);
 
+    const char* const end = iter.get_pointer() + iter.length();
+
     int32 c;
-    while (!builder.truncated() && (c = iter.next()))
+    while (!builder.truncated())
+    {
+        // Convert runs in bulk where possible.
+        const char* ptr = iter.get_pointer();
+        const uint32 room = builder.start ? uint32(builder.end - builder.write) : uint32(-1);
+        uint32 written;
+        if (const uint32 consumed = bulk_to_utf16(builder.start ? builder.write : nullptr, room, ptr, uint32(end - ptr), written))
+        {
+            builder.write += written;
+            iter.advance(consumed);
+            continue;
+        }
+
+        if (!(c = iter.next()))
+            break;
         builder << c;
+    }
 
     return builder.get_written();
 }
@@ -0,0 +1,247 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "str_pool.h"
+#include "linear_allocator.h"
+#include "debugheap.h"
+#include "str.h"
+
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+static const uint32 c_page_size = 16384;
+
+//------------------------------------------------------------------------------
+struct str_pool::generation
+{
+                            generation() : alloc(c_page_size) {}
+    linear_allocator        alloc;
+    std::vector<entry*>     entries;
+    uint32                  live = 0;   // Entries with references.
+    uint64                  bytes = 0;
+};
+
+
+
+//------------------------------------------------------------------------------
+str_pool& str_pool::get()
+{
+    // Intentionally never destroyed:  handles in other static objects can
+    // outlive any static destruction order.
+    static str_pool* s_pool = []() {
+        dbg_ignore_scope(snapshot, "str_pool");
+        return new str_pool;
+    }();
+    return *s_pool;
+}
+
+//------------------------------------------------------------------------------
+str_pool::~str_pool() = default;
+
+//------------------------------------------------------------------------------
+void str_pool::get_stats(stats& out) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    out = m_stats;
+    out.live_strings = 0;
+    out.live_bytes = 0;
+    out.pooled_bytes = 0;
+    out.generations = uint32(m_generations.size());
+    for (const auto& gen : m_generations)
+    {
+        out.live_strings += gen->live;
+        out.pooled_bytes += gen->bytes;
+        for (const entry* e : gen->entries)
+        {
+            if (e->refs)
+                out.live_bytes += e->len + 1;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+str_pool::entry* str_pool::acquire(const char* s, uint32 len)
+{
+    assert(len);
+    assert(!s[len]);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ++m_stats.requests;
+    m_stats.requested_bytes += len + 1;
+
+    const auto iter = m_index.find(s);
+    if (iter != m_index.end())
+    {
+        ++m_stats.hits;
+        entry* e = iter->second;
+        if (!e->refs++)
+            ++e->gen->live;
+        return e;
+    }
+
+    dbg_ignore_scope(snapshot, "str_pool");
+
+    // Round up so the next entry's header stays aligned.
+    const uint32 align = sizeof(void*);
+    const uint32 size = (uint32(offsetof(entry, text)) + len + 1 + align - 1) & ~(align - 1);
+
+    generation* gen = current_generation(size);
+    entry* e = gen ? static_cast<entry*>(gen->alloc.alloc(size)) : nullptr;
+    if (!e)
+        return nullptr;
+
+    e->gen = gen;
+    e->refs = 1;
+    e->len = len;
+    memcpy(e->text, s, len + 1);
+
+    gen->entries.push_back(e);
+    ++gen->live;
+    gen->bytes += size;
+    m_stats.stored_bytes += len + 1;
+
+    m_index.emplace(e->text, e);
+    return e;
+}
+
+//------------------------------------------------------------------------------
+void str_pool::addref(entry* e)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    assert(e->refs);
+    ++e->refs;
+}
+
+//------------------------------------------------------------------------------
+void str_pool::release(entry* e)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    assert(e->refs);
+    if (--e->refs)
+        return;
+
+    // The string stays in the index so it can be reused, until its whole
+    // generation becomes unreferenced.
+    generation* gen = e->gen;
+    assert(gen->live);
+    if (!--gen->live && gen != m_generations.back().get())
+        free_generation(gen);
+}
+
+//------------------------------------------------------------------------------
+str_pool::generation* str_pool::current_generation(uint32 size)
+{
+    if (!m_generations.empty())
+    {
+        generation* gen = m_generations.back().get();
+        if (gen->entries.empty() || gen->alloc.fits(size) || gen->alloc.oversized(size))
+            return gen;
+
+        // The current generation is full; if nothing references it then it
+        // can be freed as soon as a new generation replaces it.
+        if (!gen->live)
+        {
+            m_generations.emplace_back(std::make_unique<generation>());
+            free_generation(gen);
+            return m_generations.back().get();
+        }
+    }
+
+    m_generations.emplace_back(std::make_unique<generation>());
+    return m_generations.back().get();
+}
+
+//------------------------------------------------------------------------------
+void str_pool::free_generation(generation* gen)
+{
+    assert(!gen->live);
+
+    for (const entry* e : gen->entries)
+        m_index.erase(e->text);
+
+    for (auto iter = m_generations.begin(); iter != m_generations.end(); ++iter)
+    {
+        if (iter->get() == gen)
+        {
+            m_generations.erase(iter);
+            break;
+        }
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+interned_str::interned_str(const interned_str& other)
+: m_entry(other.m_entry)
+{
+    if (m_entry)
+        str_pool::get().addref(m_entry);
+}
+
+//------------------------------------------------------------------------------
+interned_str& interned_str::operator = (const interned_str& other)
+{
+    if (m_entry != other.m_entry)
+    {
+        if (other.m_entry)
+            str_pool::get().addref(other.m_entry);
+        clear();
+        m_entry = other.m_entry;
+    }
+    return *this;
+}
+
+//------------------------------------------------------------------------------
+interned_str& interned_str::operator = (interned_str&& other)
+{
+    if (this != &other)
+    {
+        clear();
+        m_entry = other.m_entry;
+        other.m_entry = nullptr;
+    }
+    return *this;
+}
+
+//------------------------------------------------------------------------------
+void interned_str::assign(const char* s, int32 len)
+{
+    const bool terminated = (len < 0);
+    if (terminated)
+        len = s ? int32(strlen(s)) : 0;
+
+    str_pool::entry* e = nullptr;
+    if (len > 0)
+    {
+        if (!terminated)
+        {
+            // The pool is indexed by nul terminated strings.
+            str<> tmp;
+            tmp.concat(s, len);
+            e = str_pool::get().acquire(tmp.c_str(), tmp.length());
+        }
+        else
+        {
+            e = str_pool::get().acquire(s, len);
+        }
+    }
+
+    clear();
+    m_entry = e;
+}
+
+//------------------------------------------------------------------------------
+void interned_str::clear()
+{
+    if (m_entry)
+    {
+        str_pool::get().release(m_entry);
+        m_entry = nullptr;
+    }
+}
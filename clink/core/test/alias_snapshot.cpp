@@ -0,0 +1,79 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include <core/alias_snapshot.h>
+#include <core/os.h>
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Alias snapshot")
+{
+    // Remove the test alias and deactivate the snapshot even if a REQUIRE
+    // fails, so later tests see the console's aliases directly.
+    struct cleanup
+    {
+        ~cleanup()
+        {
+            wstr<> wname("clink_test_alias");
+            AddConsoleAliasW(wname.data(), nullptr, const_cast<wchar_t*>(os::get_shellname()));
+            alias_snapshot::reset();
+        }
+    } _cleanup;
+
+    REQUIRE(os::set_alias("clink_test_alias", "first text"));
+    alias_snapshot::refresh();
+
+    std::shared_ptr<const alias_snapshot> snapshot = alias_snapshot::get();
+    REQUIRE(snapshot);
+
+    SECTION("Find")
+    {
+        str<> out;
+        REQUIRE(snapshot->find("clink_test_alias", out));
+        REQUIRE(out.equals("first text"));
+        REQUIRE(snapshot->find("CLINK_Test_Alias", out));
+        REQUIRE(!snapshot->find("clink_test_nope", out));
+
+        REQUIRE(os::get_alias("Clink_Test_Alias", out));
+        REQUIRE(out.equals("first text"));
+        REQUIRE(!os::get_alias("clink_test_nope", out));
+    }
+
+    SECTION("Unchanged")
+    {
+        REQUIRE(!alias_snapshot::refresh());
+        REQUIRE(alias_snapshot::get() == snapshot);
+    }
+
+    SECTION("Invalidate")
+    {
+        // Setting an alias replaces the snapshot, but existing references
+        // remain valid.
+        REQUIRE(os::set_alias("clink_test_alias", "second"));
+        std::shared_ptr<const alias_snapshot> snapshot2 = alias_snapshot::get();
+        REQUIRE(snapshot2 != snapshot);
+
+        str<> out;
+        REQUIRE(snapshot2->find("clink_test_alias", out));
+        REQUIRE(out.equals("second"));
+        REQUIRE(snapshot->find("clink_test_alias", out));
+        REQUIRE(out.equals("first text"));
+    }
+
+    SECTION("Same length")
+    {
+        // Changing an alias behind Clink's back (e.g. via doskey) without
+        // changing the table's length is still noticed by refresh().
+        wstr<> wname("clink_test_alias");
+        wstr<> wtext("FIRST TEXT");
+        AddConsoleAliasW(wname.data(), wtext.data(), const_cast<wchar_t*>(os::get_shellname()));
+        REQUIRE(alias_snapshot::refresh());
+
+        str<> out;
+        REQUIRE(alias_snapshot::get()->find("clink_test_alias", out));
+        REQUIRE(out.equals("FIRST TEXT"));
+    }
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include <core/env_snapshot.h>
+#include <core/os.h>
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Environment snapshot")
+{
+    str<> old_path;
+    str<> old_pathext;
+    const bool had_path = os::get_env("PATH", old_path);
+    const bool had_pathext = os::get_env("PATHEXT", old_pathext);
+
+    os::set_env("CLINK_TEST_DIR", "c:\\expanded");
+    os::set_env("PATH", " c:\\one ;;\"c:\\two;three\";%CLINK_TEST_DIR%\\bin; ");
+    os::set_env("PATHEXT", ".COM;.Exe; .bat ;");
+    env_snapshot::refresh();
+
+    std::shared_ptr<const env_snapshot> env = env_snapshot::get();
+
+    SECTION("Paths")
+    {
+        const auto& paths = env->get_paths();
+        REQUIRE(paths.size() == 3);
+        REQUIRE(paths[0].equals("c:\\one"));
+        REQUIRE(paths[1].equals("c:\\two;three"));
+        REQUIRE(paths[2].equals("c:\\expanded\\bin"));
+    }
+
+    SECTION("Extensions")
+    {
+        const auto& exts = env->get_pathexts();
+        REQUIRE(exts.size() == 3);
+        REQUIRE(exts[0].equals(".com"));
+        REQUIRE(exts[1].equals(".exe"));
+        REQUIRE(exts[2].equals(".bat"));
+
+        REQUIRE(env->is_pathext(".EXE"));
+        REQUIRE(env->is_pathext(".bat"));
+        REQUIRE(!env->is_pathext(".txt"));
+        REQUIRE(!env->is_pathext(""));
+        REQUIRE(!env->is_pathext(nullptr));
+    }
+
+    SECTION("Refresh")
+    {
+        // Unchanged environment keeps the same snapshot.
+        REQUIRE(!env_snapshot::refresh());
+        REQUIRE(env_snapshot::get() == env);
+
+        // A changed environment replaces the snapshot, but existing
+        // references remain valid.
+        os::set_env("PATHEXT", ".cmd");
+        REQUIRE(env_snapshot::refresh());
+        std::shared_ptr<const env_snapshot> env2 = env_snapshot::get();
+        REQUIRE(env2 != env);
+        REQUIRE(env2->get_generation() != env->get_generation());
+        REQUIRE(env2->is_pathext(".CMD"));
+        REQUIRE(!env2->is_pathext(".exe"));
+        REQUIRE(env->is_pathext(".exe"));
+    }
+
+    SECTION("Set from Clink")
+    {
+        // Setting PATH or PATHEXT from inside Clink takes effect immediately,
+        // without waiting for refresh().
+        os::set_env("PATH", "c:\\four");
+        std::shared_ptr<const env_snapshot> env2 = env_snapshot::get();
+        REQUIRE(env2 != env);
+        REQUIRE(env2->get_paths().size() == 1);
+        REQUIRE(env2->get_paths()[0].equals("c:\\four"));
+
+        // Other variables don't discard the snapshot.
+        os::set_env("CLINK_TEST_DIR", "c:\\other");
+        REQUIRE(env_snapshot::get() == env2);
+    }
+
+    os::set_env("CLINK_TEST_DIR", nullptr);
+    os::set_env("PATH", had_path ? old_path.c_str() : nullptr);
+    os::set_env("PATHEXT", had_pathext ? old_pathext.c_str() : nullptr);
+    env_snapshot::refresh();
+}
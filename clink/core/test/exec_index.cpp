@@ -0,0 +1,165 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/env_snapshot.h>
+#include <core/exec_index.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Executables index")
+{
+    static const char* fs[] = {
+        "one/foo.exe",
+        "one/bar.txt",
+        "one/baz.cmd",
+        "two/foo.cmd",
+        "two/foo.exe",
+        "two/bar.bat",
+        "two/readme.md",
+        nullptr,
+    };
+
+    fs_fixture fixture(fs);
+
+    str<> old_path;
+    str<> old_pathext;
+    const bool had_path = os::get_env("PATH", old_path);
+    const bool had_pathext = os::get_env("PATHEXT", old_pathext);
+
+    str<> one(fixture.get_root());
+    str<> two(fixture.get_root());
+    path::append(one, "one");
+    path::append(two, "two");
+
+    str<> paths;
+    paths << one.c_str() << ";" << two.c_str();
+    os::set_env("PATH", paths.c_str());
+    os::set_env("PATHEXT", ".COM;.EXE;.BAT;.CMD");
+    env_snapshot::refresh();
+
+    exec_index::wait();
+    exec_index::refresh(true);
+    exec_index::wait();
+
+    std::shared_ptr<const exec_index> index = exec_index::get();
+    REQUIRE(index);
+
+    SECTION("Commands")
+    {
+        // Earlier directories shadow later ones, and within a directory
+        // %PATHEXT% order applies.
+        const exec_index::entry* e = index->find_command("foo");
+        REQUIRE(e);
+        REQUIRE(e->dir == 0);
+        REQUIRE(strcmp(e->name, "foo.exe") == 0);
+
+        e = index->find_command("BAR");
+        REQUIRE(e);
+        REQUIRE(e->dir == 1);
+        REQUIRE(strcmp(e->name, "bar.bat") == 0);
+
+        REQUIRE(!index->find_command("readme"));
+        REQUIRE(!index->find_command("nope"));
+    }
+
+    SECTION("Prefix")
+    {
+        std::vector<const exec_index::entry*> out;
+        index->find_prefix("FO", out);
+        REQUIRE(out.size() == 2);
+        REQUIRE(strcmp(out[0]->name, "foo.cmd") == 0);
+        REQUIRE(out[0]->dir == 1);
+        REQUIRE(strcmp(out[1]->name, "foo.exe") == 0);
+        REQUIRE(out[1]->dir == 0);
+
+        out.clear();
+        index->find_prefix("", out);
+        REQUIRE(out.size() == 4);
+    }
+
+    SECTION("Refresh")
+    {
+        str<> file(one.c_str());
+        path::append(file, "bar.com");
+        if (FILE* f = fopen(file.c_str(), "wt"))
+            fclose(f);
+
+        exec_index::refresh(true);
+        exec_index::wait();
+
+        std::shared_ptr<const exec_index> index2 = exec_index::get();
+        REQUIRE(index2);
+        REQUIRE(index2 != index);
+
+        const exec_index::entry* e = index2->find_command("bar");
+        REQUIRE(e);
+        REQUIRE(e->dir == 0);
+        REQUIRE(strcmp(e->name, "bar.com") == 0);
+
+        // The old index is unaffected.
+        e = index->find_command("bar");
+        REQUIRE(e);
+        REQUIRE(e->dir == 1);
+
+        os::unlink(file.c_str());
+    }
+
+    SECTION("Out of date")
+    {
+        REQUIRE(!index->is_out_of_date());
+
+        // Adding a file changes the directory's last write time.
+        str<> file(two.c_str());
+        path::append(file, "new.exe");
+        if (FILE* f = fopen(file.c_str(), "wt"))
+            fclose(f);
+
+        REQUIRE(index->is_out_of_date());
+
+        exec_index::refresh(true);
+        exec_index::wait();
+
+        std::shared_ptr<const exec_index> index2 = exec_index::get();
+        REQUIRE(index2);
+        REQUIRE(!index2->is_out_of_date());
+        REQUIRE(index2->find_command("new"));
+
+        os::unlink(file.c_str());
+    }
+
+    SECTION("Stale")
+    {
+        os::set_env("PATHEXT", ".EXE");
+        REQUIRE(!exec_index::get());
+
+        // Asking for a stale index starts rebuilding it.
+        exec_index::wait();
+        std::shared_ptr<const exec_index> index2 = exec_index::get();
+        REQUIRE(index2);
+        REQUIRE(index2->find_command("foo"));
+        REQUIRE(!index2->find_command("bar"));
+    }
+
+    SECTION("Relative")
+    {
+        os::set_env("PATH", "one");
+        env_snapshot::refresh();
+        exec_index::refresh(true);
+        exec_index::wait();
+        REQUIRE(!exec_index::get());
+    }
+
+    os::set_env("PATH", had_path ? old_path.c_str() : nullptr);
+    os::set_env("PATHEXT", had_pathext ? old_pathext.c_str() : nullptr);
+    env_snapshot::refresh();
+    exec_index::shutdown();
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/globber.h>
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static void glob(const char* pattern, bool cached, std::vector<str_moveable>& out)
+{
+    out.clear();
+
+    str<> file;
+    globber globber(pattern, cached);
+    globber.hidden(true);
+    while (globber.next(file, false))
+        out.emplace_back(file.c_str());
+}
+
+//------------------------------------------------------------------------------
+static bool same(const std::vector<str_moveable>& a, const std::vector<str_moveable>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (!a[i].equals(b[i].c_str()))
+            return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Globber cache")
+{
+    static const char* fs[] = {
+        "abc",
+        "Abd.txt",
+        "xyz",
+        "dir1/only",
+        "dir1/abc",
+        "dir2/.",
+        nullptr,
+    };
+
+    fs_fixture fixture(fs);
+    globber::set_cache_ttl(60);
+
+    std::vector<str_moveable> live;
+    std::vector<str_moveable> cached;
+
+    SECTION("Same results")
+    {
+        static const char* patterns[] = {
+            "*", "a*", "AB*", "abd.*", "x*", "q*", "dir1\\*", "dir1/a*",
+            ".*", "..", "*.txt", "a?c",
+        };
+
+        for (const char* pattern : patterns)
+        {
+            glob(pattern, false, live);
+            glob(pattern, true, cached);
+            REQUIRE(same(live, cached), [&] () {
+                printf("pattern: %s\n", pattern);
+            });
+        }
+    }
+
+    SECTION("Hits")
+    {
+        globber::cache_stats before;
+        globber::get_cache_stats(before);
+
+        glob("a*", true, cached);
+        glob("x*", true, cached);
+
+        globber::cache_stats after;
+        globber::get_cache_stats(after);
+
+        REQUIRE(after.lookups == before.lookups + 2);
+        REQUIRE(after.hits >= before.hits + 1);
+    }
+
+    SECTION("Disabled")
+    {
+        glob("a*", true, cached);
+        globber::set_cache_ttl(0);
+
+        globber::cache_stats stats;
+        globber::get_cache_stats(stats);
+        REQUIRE(stats.directories == 0);
+
+        glob("a*", false, live);
+        glob("a*", true, cached);
+        REQUIRE(same(live, cached));
+    }
+
+    SECTION("Sweep")
+    {
+        glob("a*", true, cached);
+
+        // Unexpired entries are kept, and the next sweep is due when the
+        // entry expires.
+        const uint32 due = globber::sweep_cache();
+        REQUIRE(due > 0);
+        REQUIRE(due <= 60 * 1000);
+
+        globber::cache_stats stats;
+        globber::get_cache_stats(stats);
+        REQUIRE(stats.directories == 1);
+
+        // Expired entries are dropped, and then no sweep is due.
+        globber::set_cache_ttl(0);
+        globber::get_cache_stats(stats);
+        REQUIRE(stats.directories == 0);
+        REQUIRE(globber::sweep_cache() == uint32(-1));
+    }
+
+    globber::set_cache_ttl(5);
+}
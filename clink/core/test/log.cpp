@@ -0,0 +1,86 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/log.h>
+#include <core/path.h>
+#include <core/str.h>
+
+#include <memory>
+
+//------------------------------------------------------------------------------
+static uint32 count_lines(const char* file, const char* needle)
+{
+    uint32 count = 0;
+    if (FILE* f = fopen(file, "rt"))
+    {
+        char line[512];
+        while (fgets(line, sizeof(line), f))
+        {
+            if (strstr(line, needle))
+                ++count;
+        }
+        fclose(f);
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("File logger")
+{
+    fs_fixture fixture;
+
+    str<> file(fixture.get_root());
+    path::append(file, "test.log");
+
+    // The logger must be torn down even if a REQUIRE fails, otherwise the
+    // singleton and file_logger::s_this outlive the test.
+    REQUIRE(!logger::get());
+    std::unique_ptr<file_logger> log(new file_logger(file.c_str()));
+    REQUIRE(file_logger::get_path());
+
+    SECTION("Flush")
+    {
+        for (uint32 i = 0; i < 100; ++i)
+            LOG("line %u", i);
+
+        file_logger::flush();
+        REQUIRE(count_lines(file.c_str(), " line ") == 100);
+        REQUIRE(file_logger::get_dropped() == 0);
+    }
+
+    SECTION("Line endings")
+    {
+        LOG("crlf");
+        LOG("first\nsecond");
+        file_logger::flush();
+
+        str<> content;
+        if (FILE* f = fopen(file.c_str(), "rb"))
+        {
+            char buffer[512];
+            const size_t len = fread(buffer, 1, sizeof(buffer) - 1, f);
+            buffer[len] = '\0';
+            content = buffer;
+            fclose(f);
+        }
+        REQUIRE(strstr(content.c_str(), " crlf\r\n"));
+        REQUIRE(strstr(content.c_str(), " first\r\nsecond\r\n"));
+        REQUIRE(!strstr(content.c_str(), "first\n"));
+    }
+
+    SECTION("Shutdown")
+    {
+        for (uint32 i = 0; i < 10; ++i)
+            LOG("line %u", i);
+
+        // Deleting the logger writes any queued lines.
+        log.reset();
+        REQUIRE(!file_logger::get_path());
+        REQUIRE(count_lines(file.c_str(), " line ") == 10);
+    }
+}
@@ -4,9 +4,72 @@
 #include "pch.h"
 #include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
 
+#include "benchmark.h"
+
 #include <core/str.h>
 #include <core/str_iter.h>
 
+//------------------------------------------------------------------------------
+// Per code point conversions, the way str_convert worked before it converted
+// runs in bulk.  The bulk conversions must produce identical results.
+static void slow_to_utf16(const char* in, int32 len, wstr_base& out)
+{
+    out.clear();
+    str_iter iter(in, len);
+    while (int32 c = iter.next())
+    {
+        wchar_t w[2];
+        if (c > 0xffff)
+        {
+            w[0] = wchar_t((c >> 10) + 0xd7c0);
+            w[1] = wchar_t((c & 0x3ff) + 0xdc00);
+            out.concat(w, 2);
+        }
+        else
+        {
+            w[0] = wchar_t(c);
+            out.concat(w, 1);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+static void slow_to_utf8(const wchar_t* in, int32 len, str_base& out)
+{
+    out.clear();
+    wstr_iter iter(in, len);
+    while (int32 c = iter.next())
+    {
+        char b[4];
+        if (c < 0x80)
+        {
+            b[0] = char(c);
+            out.concat(b, 1);
+        }
+        else if (c < 0x800)
+        {
+            b[0] = char(0xc0 | (c >> 6));
+            b[1] = char(0x80 | (c & 0x3f));
+            out.concat(b, 2);
+        }
+        else if (c < 0x10000)
+        {
+            b[0] = char(0xe0 | (c >> 12));
+            b[1] = char(0x80 | ((c >> 6) & 0x3f));
+            b[2] = char(0x80 | (c & 0x3f));
+            out.concat(b, 3);
+        }
+        else
+        {
+            b[0] = char(0xf0 | (c >> 18));
+            b[1] = char(0x80 | ((c >> 12) & 0x3f));
+            b[2] = char(0x80 | ((c >> 6) & 0x3f));
+            b[3] = char(0x80 | (c & 0x3f));
+            out.concat(b, 4);
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 TEST_CASE("Wide character/UTF-8 conversion")
 {
@@ -76,6 +139,34 @@ TEST_CASE("Wide character/UTF-8 conversion")
             REQUIRE(t.length() == 3);
         }
 
+        SECTION("Invalid")
+        {
+            // Lone and reversed surrogates, between runs of ASCII long enough
+            // for bulk conversion.
+            static const wchar_t* const invalid[] = {
+                L"\xd800", L"\xdc00", L"\xdbff", L"\xdfff", L"\xdc00\xd800",
+                L"\xd800\xd800\xdc00", L"\xd800x", L"\x00e9\x4e2d",
+            };
+
+            wstr<> in;
+            str<> expected;
+            for (const wchar_t* seq : invalid)
+            {
+                for (uint32 pad = 0; pad < 40; pad += 13)
+                {
+                    in.clear();
+                    for (uint32 i = 0; i < pad; ++i)
+                        in.concat(L"a", 1);
+                    in.concat(seq);
+                    in.concat(L"0123456789abcdef0123456789abcdef");
+
+                    slow_to_utf8(in.c_str(), in.length(), expected);
+                    s.from_utf16(in.c_str());
+                    REQUIRE(s.equals(expected.c_str()));
+                }
+            }
+        }
+
         SECTION("Stream")
         {
             wstr_iter iter(L"01234567");
@@ -154,6 +245,37 @@ TEST_CASE("Wide character/UTF-8 conversion")
             REQUIRE(t.length() == 3);
         }
 
+        SECTION("Invalid")
+        {
+            // Runs of ASCII long enough for bulk conversion, around sequences
+            // that must go through str_iter.
+            static const char* const invalid[] = {
+                "\x80", "\xbf", "\xc0", "\xc1\xbf", "\xe0\xa0", "\xe0\x80\x80",
+                "\xed\xa0\x80", "\xed\xbf\xbf", "\xf0\x90", "\xf8\x88\x80\x80\x80",
+                "\xfe", "\xff", "\xe4\xb8\xadx", "\xc0\x80", "\xe4\xb8",
+            };
+
+            str<> in;
+            wstr<> expected;
+            for (const char* seq : invalid)
+            {
+                for (uint32 pad = 0; pad < 40; pad += 13)
+                {
+                    in.clear();
+                    for (uint32 i = 0; i < pad; ++i)
+                        in.concat("a", 1);
+                    in.concat(seq);
+                    in.concat("0123456789abcdef0123456789abcdef");
+
+                    slow_to_utf16(in.c_str(), in.length(), expected);
+                    s.from_utf8(in.c_str());
+                    REQUIRE(s.equals(expected.c_str()), [&] () {
+                        printf("pad %u, seq %s\n", pad, seq);
+                    });
+                }
+            }
+        }
+
         SECTION("Stream")
         {
             str_iter iter("01234567");
@@ -169,3 +291,57 @@ TEST_CASE("Wide character/UTF-8 conversion")
         }
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("Wide character/UTF-8 conversion benchmark")
+{
+    if (!g_run_benchmarks)
+        return;
+
+    static const char* const inputs[] = {
+        "c:\\Program Files\\Microsoft Visual Studio\\2022\\Community\\VC\\Tools\\MSVC\\bin\\cl.exe",
+        "c:\\\xe7\x94\xa8\xe6\x88\xb7\\\xe6\x96\x87\xe6\xa1\xa3\\\xe9\xa1\xb9\xe7\x9b\xae\\\xe6\xba\x90\xe4\xbb\xa3\xe7\xa0\x81\\\xe6\xb5\x8b\xe8\xaf\x95.txt",
+    };
+    static const char* const names[] = { "path", "cjk" };
+
+    const uint32 count = 100000;
+    for (uint32 i = 0; i < sizeof_array(inputs); ++i)
+    {
+        const char* in = inputs[i];
+        const int32 len = int32(strlen(in));
+
+        str<> name;
+        wstr<> wide;
+        str<> narrow;
+
+        name.format("to_utf16 (%s): per code point", names[i]);
+        {
+            benchmark_timer timer(name.c_str(), count);
+            for (uint32 n = 0; n < count; ++n)
+                slow_to_utf16(in, len, wide);
+        }
+
+        name.format("to_utf16 (%s): bulk", names[i]);
+        {
+            benchmark_timer timer(name.c_str(), count);
+            for (uint32 n = 0; n < count; ++n)
+                wide.from_utf8(in);
+        }
+
+        name.format("to_utf8 (%s): per code point", names[i]);
+        {
+            benchmark_timer timer(name.c_str(), count);
+            for (uint32 n = 0; n < count; ++n)
+                slow_to_utf8(wide.c_str(), wide.length(), narrow);
+        }
+
+        name.format("to_utf8 (%s): bulk", names[i]);
+        {
+            benchmark_timer timer(name.c_str(), count);
+            for (uint32 n = 0; n < count; ++n)
+                narrow.from_utf16(wide.c_str());
+        }
+
+        REQUIRE(narrow.equals(in));
+    }
+}
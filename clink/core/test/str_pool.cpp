@@ -0,0 +1,82 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include <core/str.h>
+#include <core/str_pool.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_pool: sharing")
+{
+    str_pool::stats before;
+    str_pool::get().get_stats(before);
+
+    interned_str a("str_pool test abc");
+    interned_str b("str_pool test abc");
+    interned_str c("str_pool test abcdef", 17);
+    interned_str d("str_pool test xyz");
+
+    REQUIRE(a.equals("str_pool test abc"));
+    REQUIRE(a.length() == 17);
+    REQUIRE(a.c_str() == b.c_str());
+    REQUIRE(a.c_str() == c.c_str());
+    REQUIRE(a.c_str() != d.c_str());
+
+    interned_str e(a);
+    REQUIRE(e.c_str() == a.c_str());
+    e = d;
+    REQUIRE(e.c_str() == d.c_str());
+    e = std::move(d);
+    REQUIRE(d.empty());
+    REQUIRE(e.equals("str_pool test xyz"));
+
+    interned_str empty("");
+    REQUIRE(empty.empty());
+    REQUIRE(empty.length() == 0);
+    REQUIRE(empty.equals(""));
+
+    str_pool::stats after;
+    str_pool::get().get_stats(after);
+    REQUIRE(after.requests - before.requests == 4);
+    REQUIRE(after.hits - before.hits == 2);
+    REQUIRE(after.live_strings - before.live_strings == 2);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_pool: reclaim")
+{
+    str_pool::stats before;
+    str_pool::get().get_stats(before);
+
+    // Fill several generations.
+    std::vector<interned_str> strings;
+    str<> s;
+    for (uint32 i = 0; i < 4000; ++i)
+    {
+        s.format("str_pool reclaim %u", i);
+        strings.emplace_back(s.c_str());
+    }
+
+    str_pool::stats full;
+    str_pool::get().get_stats(full);
+    REQUIRE(full.generations > before.generations + 1);
+    REQUIRE(full.live_strings == before.live_strings + 4000);
+
+    // A released string can be reused while its generation is alive.
+    const char* p = strings[3999].c_str();
+    strings[3999].clear();
+    interned_str again("str_pool reclaim 3999");
+    REQUIRE(again.c_str() == p);
+
+    // Releasing everything frees the old generations.
+    strings.clear();
+    str_pool::stats released;
+    str_pool::get().get_stats(released);
+    REQUIRE(released.live_strings == before.live_strings + 1);
+    REQUIRE(released.generations < full.generations);
+    REQUIRE(released.pooled_bytes < full.pooled_bytes);
+}
@@ -135,6 +135,7 @@ public:
     static expand_result        expand(const char* line, str_base& out);
 
 private:
+    struct                      compact_task;
     friend                      class read_line_iter;
     bool                        is_valid() const;
     void                        get_file_path(str_base& out, bool session) const;
@@ -147,6 +148,7 @@ private:
     bank_handles                get_bank(uint32 index) const;
     bool                        remove_internal(line_id id, bool guard_ctag);
     void                        make_open_error(str_base* error_message, bank_t bank) const;
+    void                        wait_for_compact_task();
     void*                       m_alive_file = nullptr;
     str_moveable                m_path;
     int32                       m_id;
@@ -158,7 +160,11 @@ private:
     size_t                      m_master_len;
     size_t                      m_master_deleted_count;
 
+    compact_task*               m_compact_task = nullptr;
+
     size_t                      m_min_compact_threshold = 200;
+    void                        (*m_compact_prepared_hook)(void*) = nullptr; // Lets tests change the master bank between compact phases.
+    void*                       m_compact_prepared_hook_data = nullptr;
 
     bool                        m_use_master_bank = false;
     bool                        m_diagnostic = false;
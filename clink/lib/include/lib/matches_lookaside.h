@@ -33,12 +33,40 @@ private:
     static const match_extra s_empty_extra;
 };
 
+//------------------------------------------------------------------------------
+// Builds a match list for Readline where all matches (except the lcd entry in
+// [0]) are packed into a single arena, each preceded by its match_extra.  This
+// avoids one allocation per match, lookup_match() becomes an O(1) offset, and
+// destroy_matches_lookaside() releases the whole arena in one step.
+class packed_match_list_builder
+{
+public:
+                            packed_match_list_builder(uint32 count_hint);
+                            ~packed_match_list_builder();
+    bool                    set_lcd(const char* text, uint32 len);
+    bool                    add(const char* match, match_type type,
+                                const char* display, const char* description,
+                                char append_char, uint8 flags);
+    uint32                  get_count() const { return m_count; }
+    char**                  detach();
+private:
+    bool                    ensure_matches(uint32 count);
+    bool                    ensure_arena(size_t size);
+    char**                  m_matches = nullptr;
+    uint32                  m_reserved = 0;
+    uint32                  m_count = 0;
+    char*                   m_arena = nullptr;
+    size_t                  m_arena_size = 0;
+    size_t                  m_arena_used = 0;
+};
+
 //------------------------------------------------------------------------------
 // Each match in 'matches' must conform to the PACKED MATCH FORMAT (except the
 // lcd entry in [0], which is omitted from the lookaside table).
 match_details lookup_match(const char* match);
 int32 create_matches_lookaside(char** matches);
 int32 destroy_matches_lookaside(char** matches);
+void free_match(char* match);
 void set_matches_lookaside_oneoff(const char* match, match_type type, char append_char, uint8 flags);
 void clear_matches_lookaside_oneoff();
 
@@ -6,6 +6,7 @@
 #include "line_buffer.h"
 
 #include <core/str_iter.h>
+#include <core/str_pool.h>
 
 #include <vector>
 
@@ -20,12 +21,12 @@ enum class suggestion_action : uint8
 //------------------------------------------------------------------------------
 struct suggestion
 {
-    str_moveable    m_suggestion;
+    interned_str    m_suggestion;
     uint32          m_suggestion_offset = -1;
     int32           m_highlight_offset = -1;
     int32           m_highlight_length = -1;
-    str_moveable    m_tooltip;
-    str_moveable    m_source;
+    interned_str    m_tooltip;
+    interned_str    m_source;
     int32           m_history_index = -1;
 };
 
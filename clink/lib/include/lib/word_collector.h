@@ -5,9 +5,11 @@
 
 #include "line_state.h"
 
+#include <core/str.h>
 #include <core/str_iter.h>
 #include <core/str_tokeniser.h>
 
+#include <memory>
 #include <vector>
 
 class line_buffer;
@@ -103,6 +105,7 @@ public:
     command_line_states() { clear(); }
     void set(const char* line_buffer, uint32 line_length, uint32 line_cursor, const words& words, collect_words_mode mode, const commands& commands);
     void set(const line_buffer& buffer, const words& words, collect_words_mode mode, const commands& commands);
+    void set(const char* line_buffer, const line_states& lines);
     uint32 break_end_word(uint32 truncate, uint32 keep, bool discard);
     void split_for_hinter();
     void clear();
@@ -118,3 +121,33 @@ private:
     bool m_broke_end_word;
 #endif
 };
+
+//------------------------------------------------------------------------------
+// Immutable copy of the command line states for one revision of the input
+// line.  It owns its copy of the line text and words, so the classifier, the
+// hinter, and Lua coroutines can all share it by reference, and it stays
+// valid after the line buffer changes.
+class command_line_snapshot
+{
+public:
+    struct stats
+    {
+        uint32          built;
+        uint32          reused;
+    };
+
+                        command_line_snapshot(const line_states& lines);
+                        command_line_snapshot(const command_line_snapshot&) = delete;
+    bool                is_line(const char* line, uint32 length) const;
+    const line_states&  get_linestates() const;
+    const line_state&   get_linestate() const;
+    const line_state&   get_hinter_linestate() const; // Main thread only.
+
+    static void         note_reused();
+    static void         get_stats(stats& out);
+
+private:
+    str_moveable        m_line;
+    command_line_states m_states;
+    mutable std::unique_ptr<command_line_states> m_hinter_states;
+};
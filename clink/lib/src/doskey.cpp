@@ -5,12 +5,14 @@
 #include "doskey.h"
 #include "cmd_tokenisers.h"
 
+#include <core/alias_snapshot.h>
 #include <core/base.h>
 #include <core/settings.h>
 #include <core/str.h>
 #include <core/str_iter.h>
 #include <core/str_tokeniser.h>
 #include <core/debugheap.h>
+#include <core/os.h>
 
 #include "terminal/printer.h"
 #include "terminal/terminal_helpers.h"
@@ -28,6 +30,31 @@ setting_bool g_enhanced_doskey(
 
 
 
+//------------------------------------------------------------------------------
+static bool lookup_alias(const wchar_t* shell_name, const char* alias, str_base& text)
+{
+    // During an edit session the alias table is fetched once in bulk.
+    if (wcsicmp(shell_name, os::get_shellname()) == 0)
+    {
+        if (std::shared_ptr<const alias_snapshot> snapshot = alias_snapshot::get())
+            return snapshot->find(alias, text);
+    }
+
+    // First check it exists.
+    wchar_t unused;
+    wstr<32> walias(alias);
+    if (!GetConsoleAliasW(walias.data(), &unused, sizeof(unused), const_cast<wchar_t*>(shell_name)))
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+            return false;
+
+    // It does. Allocate space and fetch it.
+    wstr_moveable wtext;
+    wtext.reserve(8192, true/*exact*/);
+    GetConsoleAliasW(walias.data(), wtext.data(), wtext.size(), const_cast<wchar_t*>(shell_name));
+    text = wtext.c_str();
+    return true;
+}
+
 //------------------------------------------------------------------------------
 static bool get_alias(const wchar_t* shell_name, str_iter& in, uint32& skipped, str_base& alias, str_base& text, int32& parens, bool relaxed=false)
 {
@@ -80,18 +107,9 @@ fallback:
         return get_alias(shell_name, in, skipped, alias, text, parens, true);
     }
 
-    // Find the alias' text. First check it exists.
-    wchar_t unused;
-    wstr<32> walias(alias.c_str());
-    if (!GetConsoleAliasW(walias.data(), &unused, sizeof(unused), const_cast<wchar_t*>(shell_name)))
-        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
-            goto fallback;
-
-    // It does. Allocate space and fetch it.
-    wstr_moveable wtext;
-    wtext.reserve(8192, true/*exact*/);
-    GetConsoleAliasW(walias.data(), wtext.data(), wtext.size(), const_cast<wchar_t*>(shell_name));
-    text = wtext.c_str();
+    // Find the alias' text.
+    if (!lookup_alias(shell_name, alias.c_str(), text))
+        goto fallback;
 
     // Advance the iterator.
     while (in.peek() == ' ')
@@ -301,6 +319,7 @@ bool doskey::add_alias(const char* alias, const char* text)
 {
     wstr<64> walias(alias);
     wstr<> wtext(text);
+    alias_snapshot::invalidate();
     return (AddConsoleAliasW(walias.data(), wtext.data(), m_shell_name.data()) == TRUE);
 }
 
@@ -308,6 +327,7 @@ bool doskey::add_alias(const char* alias, const char* text)
 bool doskey::remove_alias(const char* alias)
 {
     wstr<64> walias(alias);
+    alias_snapshot::invalidate();
     return (AddConsoleAliasW(walias.data(), nullptr, m_shell_name.data()) == TRUE);
 }
 
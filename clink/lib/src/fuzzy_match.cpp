@@ -0,0 +1,250 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fuzzy_match.h"
+
+#include <core/base.h>
+#include <core/str_compare.h>
+#include <core/str_iter.h>
+
+//------------------------------------------------------------------------------
+// Scoring is loosely based on fzf's:  each matched character is worth
+// c_score_match, plus a bonus depending on where it is, and gaps between
+// matched characters are penalized.
+static const int32 c_score_match = 16;
+static const int32 c_penalty_gap_start = -3;
+static const int32 c_penalty_gap_extension = -1;
+static const int32 c_bonus_boundary_white = 10;     // After whitespace.
+static const int32 c_bonus_boundary = 8;            // After punctuation.
+static const int32 c_bonus_camel = 7;               // camelCase, or a digit after a non-digit.
+static const int32 c_bonus_consecutive = 4;
+static const int32 c_bonus_first_multiplier = 2;
+
+//------------------------------------------------------------------------------
+enum char_class : uint8 { class_white, class_punct, class_lower, class_upper, class_digit };
+
+//------------------------------------------------------------------------------
+static char_class classify(int32 c)
+{
+    if (c == ' ' || c == '\t')
+        return class_white;
+    if (c >= 'a' && c <= 'z')
+        return class_lower;
+    if (c >= 'A' && c <= 'Z')
+        return class_upper;
+    if (c >= '0' && c <= '9')
+        return class_digit;
+    if (c < 0x80)
+        return class_punct;
+    return class_lower;
+}
+
+//------------------------------------------------------------------------------
+static int32 boundary_bonus(char_class prev, char_class curr)
+{
+    if (curr == class_white || curr == class_punct)
+        return 0;
+    if (prev == class_white)
+        return c_bonus_boundary_white;
+    if (prev == class_punct)
+        return c_bonus_boundary;
+    if ((prev == class_lower && curr == class_upper) ||
+        (prev != class_digit && curr == class_digit))
+        return c_bonus_camel;
+    return 0;
+}
+
+
+
+//------------------------------------------------------------------------------
+void fuzzy_matcher::set_needle(const char* needle, int32 mode, bool fuzzy_accents)
+{
+    m_mode = mode;
+    m_fuzzy_accents = fuzzy_accents;
+    m_needle.clear();
+    m_mask = 0;
+
+    bool prev_sep = false;
+    str_iter iter(needle);
+    while (int32 c = iter.next())
+    {
+        c = fold(c);
+        const bool sep = (c == '/');
+        if (sep && prev_sep)
+            continue;
+        prev_sep = sep;
+        m_needle.push_back(c);
+        m_mask |= mask_bit(c);
+    }
+}
+
+//------------------------------------------------------------------------------
+// The mask has a bit for each (folded) character in TEXT.  Callers can cache
+// masks and use may_match() to reject rows without scoring them.
+uint64 fuzzy_matcher::get_mask(const char* text) const
+{
+    uint64 mask = 0;
+    str_iter iter(text);
+    while (int32 c = iter.next())
+        mask |= mask_bit(fold(c));
+    return mask;
+}
+
+//------------------------------------------------------------------------------
+int32 fuzzy_matcher::score(const char* text) const
+{
+    const int32 needle_len = int32(m_needle.size());
+    if (!needle_len)
+        return 0;
+
+    const int32* const n = m_needle.data();
+
+    // Decode and fold the text, and compute the bonus for each position, so
+    // the scans below are simple loops over arrays.  Decoding stops at the
+    // end of the first occurrence of the needle as a subsequence; nothing
+    // after it can be part of the shortest window.
+    m_text.clear();
+    m_bonus.clear();
+    int32 j = 0;
+    int32 end = -1;
+    {
+        char_class prev = class_white;
+        bool prev_sep = false;
+        str_iter iter(text);
+        while (int32 c = iter.next())
+        {
+            const char_class curr = classify(c);
+            c = fold(c);
+            const bool sep = (c == '/');
+            if (sep && prev_sep)
+                continue;
+            prev_sep = sep;
+            m_text.push_back(c);
+            m_bonus.push_back(int8(boundary_bonus(prev, curr)));
+            prev = curr;
+
+            if (c == n[j] && ++j == needle_len)
+            {
+                end = int32(m_text.size()) - 1;
+                break;
+            }
+        }
+    }
+    if (end < 0)
+        return no_match;
+
+    const int32* const t = m_text.data();
+
+    // Scan backwards from the end to find the shortest window.
+    int32 start = end;
+    j = needle_len - 1;
+    for (int32 i = end; i >= 0; --i)
+    {
+        if (t[i] == n[j] && --j < 0)
+        {
+            start = i;
+            break;
+        }
+    }
+
+    // Score the window.
+    int32 score = 0;
+    int32 consecutive = 0;
+    int32 first_bonus = 0;
+    bool in_gap = false;
+    j = 0;
+    for (int32 i = start; i <= end; ++i)
+    {
+        if (j < needle_len && t[i] == n[j])
+        {
+            int32 bonus = m_bonus[i];
+            if (!consecutive)
+            {
+                first_bonus = bonus;
+            }
+            else
+            {
+                // A run of consecutive matches keeps the bonus of the
+                // character that started it.
+                if (bonus >= c_bonus_boundary && bonus > first_bonus)
+                    first_bonus = bonus;
+                bonus = max<int32>(bonus, max<int32>(first_bonus, c_bonus_consecutive));
+            }
+            score += c_score_match + (j ? bonus : bonus * c_bonus_first_multiplier);
+            ++consecutive;
+            in_gap = false;
+            ++j;
+        }
+        else
+        {
+            score += in_gap ? c_penalty_gap_extension : c_penalty_gap_start;
+            consecutive = 0;
+            first_bonus = 0;
+            in_gap = true;
+        }
+    }
+
+    return max<int32>(score, 0);
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of bytes in TEXT through the end of the first occurrence
+// of the needle as a subsequence, or no_match.
+int32 fuzzy_matcher::match_end(const char* text, int32 len) const
+{
+    const int32 needle_len = int32(m_needle.size());
+    if (!needle_len)
+        return 0;
+
+    int32 j = 0;
+    bool prev_sep = false;
+    str_iter iter(text, len);
+    while (int32 c = iter.next())
+    {
+        c = fold(c);
+        const bool sep = (c == '/');
+        if (sep && prev_sep)
+            continue;
+        prev_sep = sep;
+        if (c == m_needle[j] && ++j == needle_len)
+            return int32(iter.get_pointer() - text);
+    }
+
+    return no_match;
+}
+
+//------------------------------------------------------------------------------
+// Folds the same way as str_compare_impl().
+int32 fuzzy_matcher::fold(int32 c) const
+{
+    // Most text is ASCII, and there are no accented ASCII characters, so
+    // avoid the more expensive calls for ASCII.
+    if (c < 0x80)
+    {
+        if (m_mode > str_compare_scope::exact && c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        else if (m_mode > str_compare_scope::caseless && c == '-')
+            c = '_';
+        else if (c == '\\')
+            c = '/';
+        return c;
+    }
+
+    if (m_mode > str_compare_scope::exact)
+        c = (c > 0xffff) ? c : int32(uintptr_t(CharLowerW(LPWSTR(uintptr_t(c)))));
+    if (m_mode > str_compare_scope::caseless && c == '-')
+        c = '_';
+    if (c == '\\')
+        c = '/';
+    if (m_fuzzy_accents)
+        c = normalize_accent(c);
+    return c;
+}
+
+//------------------------------------------------------------------------------
+uint64 fuzzy_matcher::mask_bit(int32 c)
+{
+    // Characters that share a bit only make the mask less selective.
+    return uint64(1) << ((c < 0x80) ? (c % 63) : 63);
+}
@@ -0,0 +1,38 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Scores fuzzy matches, where the characters in the needle must appear in
+// order but not necessarily adjacent.  Matches score higher when the matched
+// characters are contiguous, and when they start words.  Characters are
+// folded the same way str_compare() folds them for the str_compare_scope mode
+// and fuzzy accent setting passed to set_needle().
+class fuzzy_matcher
+{
+public:
+    enum { no_match = -1 };
+
+    void            set_needle(const char* needle, int32 mode, bool fuzzy_accents);
+    bool            empty() const { return m_needle.empty(); }
+    uint64          get_mask(const char* text) const;
+    bool            may_match(uint64 mask) const { return !(m_mask & ~mask); }
+    int32           score(const char* text) const;
+    int32           match_end(const char* text, int32 len=-1) const;
+
+private:
+    int32           fold(int32 c) const;
+    static uint64   mask_bit(int32 c);
+
+    std::vector<int32> m_needle;    // Folded codepoints.
+    uint64          m_mask = 0;     // Union of mask_bit() for the needle.
+    int32           m_mode = 0;
+    bool            m_fuzzy_accents = false;
+
+    // Scratch buffers reused across calls to score().
+    mutable std::vector<int32> m_text;
+    mutable std::vector<int8> m_bonus;
+};
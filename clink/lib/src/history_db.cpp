@@ -26,7 +26,9 @@ extern "C" {
 }
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
 #include <unordered_set>
 
 #include <core/debugheap.h>
@@ -244,7 +246,7 @@ public:
 
 protected:
                     bank_lock() = default;
-                    bank_lock(const bank_handles& handles, bool exclusive);
+                    bank_lock(const bank_handles& handles, bool exclusive, bool wait=true);
                     bank_lock(bank_lock&& other);
                     ~bank_lock();
     bank_lock&      operator = (bank_lock&& other);
@@ -253,7 +255,7 @@ protected:
 };
 
 //------------------------------------------------------------------------------
-bank_lock::bank_lock(const bank_handles& handles, bool exclusive)
+bank_lock::bank_lock(const bank_handles& handles, bool exclusive, bool wait)
 : m_handle_lines(handles.m_handle_lines)
 , m_handle_removals(handles.m_handle_removals)
 {
@@ -268,9 +270,24 @@ bank_lock::bank_lock(const bank_handles& handles, bool exclusive)
 
     OVERLAPPED overlapped = {};
     int32 flags = exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0;
-    LockFileEx(m_handle_lines, flags, 0, ~0u, ~0u, &overlapped);
+    if (!wait)
+        flags |= LOCKFILE_FAIL_IMMEDIATELY;
+    if (!LockFileEx(m_handle_lines, flags, 0, ~0u, ~0u, &overlapped) && !wait)
+    {
+        // Another process holds the lock; the lock is invalid.
+        m_handle_lines = nullptr;
+        m_handle_removals = nullptr;
+        return;
+    }
     if (m_handle_removals)
-        LockFileEx(m_handle_removals, flags, 0, ~0u, ~0u, &overlapped);
+    {
+        if (!LockFileEx(m_handle_removals, flags, 0, ~0u, ~0u, &overlapped) && !wait)
+        {
+            UnlockFileEx(m_handle_lines, 0, ~0u, ~0u, &overlapped);
+            m_handle_lines = nullptr;
+            m_handle_removals = nullptr;
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -364,7 +381,8 @@ public:
     };
 
     explicit                read_lock() = default;
-    explicit                read_lock(const bank_handles& handles, bool exclusive=false);
+    explicit                read_lock(const bank_handles& handles, bool exclusive=false, bool wait=true);
+    uint32                  get_size() const;
     line_id_impl            find(const char* line) const;
     template <class T> void find(const char* line, T&& callback) const;
     int32                   apply_removals(write_lock& lock) const;
@@ -380,11 +398,12 @@ class write_lock
 {
 public:
                     write_lock() = default;
-    explicit        write_lock(const bank_handles& handles);
+    explicit        write_lock(const bank_handles& handles, bool wait=true);
     void            clear();
     line_id_impl    add(const char* line);
     bool            remove(line_id_impl id);
     void            append(const read_lock& src);
+    void            append(const char* data, uint32 len);
 };
 
 //------------------------------------------------------------------------------
@@ -394,11 +413,17 @@ static bool extract_ctag(const read_lock& lock, concurrency_tag& tag);
 
 
 //------------------------------------------------------------------------------
-read_lock::read_lock(const bank_handles& handles, bool exclusive)
-: bank_lock(handles, exclusive)
+read_lock::read_lock(const bank_handles& handles, bool exclusive, bool wait)
+: bank_lock(handles, exclusive, wait)
 {
 }
 
+//------------------------------------------------------------------------------
+uint32 read_lock::get_size() const
+{
+    return GetFileSize(m_handle_lines, nullptr);
+}
+
 //------------------------------------------------------------------------------
 template <class T> void read_lock::find(const char* line, T&& callback) const
 {
@@ -760,8 +785,8 @@ void read_lock::line_iter::set_file_offset(uint32 offset)
 
 
 //------------------------------------------------------------------------------
-write_lock::write_lock(const bank_handles& handles)
-: read_lock(handles, true)
+write_lock::write_lock(const bank_handles& handles, bool wait)
+: read_lock(handles, true, wait)
 {
 }
 
@@ -833,6 +858,15 @@ void write_lock::append(const read_lock& src)
         WriteFile(m_handle_lines, buffer.data(), bytes_read, &written, nullptr);
 }
 
+//------------------------------------------------------------------------------
+void write_lock::append(const char* data, uint32 len)
+{
+    DWORD written;
+
+    SetFilePointer(m_handle_lines, 0, nullptr, FILE_END);
+    WriteFile(m_handle_lines, data, len, &written, nullptr);
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -970,13 +1004,71 @@ static bool extract_ctag(const read_lock& lock, concurrency_tag& tag)
 }
 
 //------------------------------------------------------------------------------
-static void rewrite_master_bank(write_lock& lock, size_t limit=0, size_t* _kept=nullptr, size_t* _deleted=nullptr, bool uniq=false, size_t* _dups=nullptr, std::map<line_id_impl, line_id_impl>* remap=nullptr)
+// A compacted copy of the master bank.  It is prepared while holding only a
+// shared lock, and then committed while holding an exclusive lock.  The commit
+// only needs to verify the bank hasn't changed, carry over lines that were
+// appended meanwhile, and write the copy in one go.
+struct compacted_bank
+{
+    void                clear();
+    bool                translate(line_id_impl old_id, line_id_impl& new_id) const;
+
+    str_moveable        m_image;            // New content, including the new ctag.
+    concurrency_tag     m_old_ctag;         // Ctag of the bank it was prepared from.
+    uint32              m_snapshot_size = 0; // Size of the bank it was prepared from.
+    std::vector<uint32> m_kept_offsets;     // Old offsets of kept lines, ascending.
+    std::map<line_id_impl, line_id_impl> m_remap;
+    size_t              m_kept = 0;
+    size_t              m_deleted = 0;
+    size_t              m_dups = 0;
+};
+
+//------------------------------------------------------------------------------
+void compacted_bank::clear()
+{
+    m_image.free();
+    m_old_ctag.clear();
+    m_snapshot_size = 0;
+    m_kept_offsets.clear();
+    m_remap.clear();
+    m_kept = 0;
+    m_deleted = 0;
+    m_dups = 0;
+}
+
+//------------------------------------------------------------------------------
+bool compacted_bank::translate(line_id_impl old_id, line_id_impl& new_id) const
+{
+    const auto iter = m_remap.find(old_id);
+    if (iter != m_remap.end())
+    {
+        new_id = iter->second;
+        return true;
+    }
+
+    // Lines appended after the image was prepared follow the image.
+    if (old_id.offset >= m_snapshot_size && old_id.offset < c_max_line_id.offset)
+    {
+        const uint64 offset = uint64(old_id.offset) - m_snapshot_size + m_image.length();
+        if (offset < c_max_line_id.offset)
+        {
+            new_id = line_id_impl(uint32(offset));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+static void prepare_master_bank(const read_lock& lock, compacted_bank& compacted, size_t limit=0, bool uniq=false)
 {
     history_read_buffer buffer;
     str_map_case<size_t>::type seen;
 
-    if (_dups)
-        *_dups = 0;
+    compacted.clear();
+    extract_ctag(lock, compacted.m_old_ctag);
+    compacted.m_snapshot_size = lock.get_size();
 
     struct remap_history_line
     {
@@ -1022,8 +1114,7 @@ static void rewrite_master_bank(write_lock& lock, size_t limit=0, size_t* _kept=
                 keep = std::move(lines_to_keep[lookup->second]);
                 assert(!lines_to_keep[lookup->second].get());
                 // Update number of duplicate entries.
-                if (_dups)
-                    ++(*_dups);
+                ++compacted.m_dups;
             }
             seen.insert_or_assign(keep->m_line.m_line.get(), lines_to_keep.size());
         }
@@ -1038,16 +1129,12 @@ static void rewrite_master_bank(write_lock& lock, size_t limit=0, size_t* _kept=
         assert(!keep.get());
     }
 
-    if (_kept)
-        *_kept = lines_to_keep.size();
-    if (_deleted)
-        *_deleted = iter.get_deleted_count();
+    compacted.m_kept = lines_to_keep.size();
+    compacted.m_deleted = iter.get_deleted_count();
 
-    // Clear and write new tag.
+    // Generate new tag.
     concurrency_tag tag;
     tag.generate_new_tag();
-    lock.clear();
-    lock.add(tag.get());
 
     // Decide how many lines to keep.
     size_t start = 0;
@@ -1058,19 +1145,43 @@ static void rewrite_master_bank(write_lock& lock, size_t limit=0, size_t* _kept=
                 --limit;
     }
 
-    // Write lines from vector.
+    // Assign the new offsets, and measure the image so it can be allocated
+    // once instead of growing it a line at a time.
+    uint64 offset = strlen(tag.get()) + 1;
     for (size_t ii = start; ii < lines_to_keep.size(); ++ii)
     {
         const auto& keep = lines_to_keep[ii];
         if (keep)
         {
             if (keep->m_timestamp.m_line.get())
-                keep->m_timestamp.m_new = lock.add(keep->m_timestamp.m_line.get());
+            {
+                keep->m_timestamp.m_new = line_id_impl(uint32(min<uint64>(offset, c_max_line_id.offset)));
+                offset += strlen(keep->m_timestamp.m_line.get()) + 1;
+            }
             else
+            {
                 keep->m_timestamp.m_new.outer = 0;
-            keep->m_line.m_new = lock.add(keep->m_line.m_line.get());
+            }
+            keep->m_line.m_new = line_id_impl(uint32(min<uint64>(offset, c_max_line_id.offset)));
+            offset += strlen(keep->m_line.m_line.get()) + 1;
+        }
+    }
+
+    // Write lines from vector into the image.
+    compacted.m_image.reserve(uint32(offset));
+    compacted.m_image << tag.get() << "\n";
+    for (size_t ii = start; ii < lines_to_keep.size(); ++ii)
+    {
+        const auto& keep = lines_to_keep[ii];
+        if (keep)
+        {
+            if (keep->m_timestamp.m_line.get())
+                compacted.m_image << keep->m_timestamp.m_line.get() << "\n";
+            compacted.m_image << keep->m_line.m_line.get() << "\n";
+            compacted.m_kept_offsets.push_back(keep->m_line.m_old.offset);
         }
     }
+    assert(compacted.m_image.length() == offset);
 
     // Verify ids monotonically increase.
 #ifdef DEBUG
@@ -1097,19 +1208,162 @@ static void rewrite_master_bank(write_lock& lock, size_t limit=0, size_t* _kept=
     }
 #endif
 
-    if (remap)
+    for (size_t ii = start; ii < lines_to_keep.size(); ++ii)
+    {
+        const auto& keep = lines_to_keep[ii];
+        if (keep)
+        {
+            if (keep->m_timestamp.m_line.get())
+                compacted.m_remap.emplace(keep->m_timestamp.m_old.outer, keep->m_timestamp.m_new.outer);
+            compacted.m_remap.emplace(keep->m_line.m_old.outer, keep->m_line.m_new.outer);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns false if the bank changed since the image was prepared in a way that
+// invalidates the image; the bank is left untouched in that case.
+static bool commit_master_bank(write_lock& lock, const compacted_bank& compacted)
+{
+    // Compacted or cleared by another session?
+    concurrency_tag tag;
+    extract_ctag(lock, tag);
+    if (strcmp(tag.get(), compacted.m_old_ctag.get()) != 0)
+        return false;
+
+    const uint32 size = lock.get_size();
+    if (size < compacted.m_snapshot_size)
+        return false;
+
+    history_read_buffer buffer;
+    read_lock::file_iter iter(lock, buffer.data(), buffer.size());
+
+    // Removing a line marks it in place, so verify none of the kept lines
+    // have been removed meanwhile.  This is a single sequential read, and
+    // doesn't need to parse lines.
+    auto kept = compacted.m_kept_offsets.begin();
+    const auto kept_end = compacted.m_kept_offsets.end();
+    while (kept != kept_end)
     {
-        for (size_t ii = start; ii < lines_to_keep.size(); ++ii)
+        const uint32 bytes = iter.next();
+        if (!bytes)
+            return false;
+
+        const unsigned __int64 base = iter.get_buffer_offset();
+        for (; kept != kept_end && *kept < base + bytes; ++kept)
         {
-            const auto& keep = lines_to_keep[ii];
-            if (keep)
+            if (buffer.data()[*kept - base] == '|')
+                return false;
+        }
+    }
+
+    // Lines appended meanwhile are carried over verbatim.
+    str_moveable tail;
+    if (size > compacted.m_snapshot_size)
+    {
+        tail.reserve(size - compacted.m_snapshot_size);
+        iter.set_file_offset(compacted.m_snapshot_size);
+        while (const uint32 bytes = iter.next())
+            tail.concat(buffer.data(), bytes);
+    }
+
+    lock.clear();
+    lock.append(compacted.m_image.c_str(), compacted.m_image.length());
+    if (tail.length())
+        lock.append(tail.c_str(), tail.length());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static void rewrite_master_bank(write_lock& lock, compacted_bank& compacted, size_t limit=0, bool uniq=false)
+{
+    prepare_master_bank(lock, compacted, limit, uniq);
+    const bool committed = commit_master_bank(lock, compacted);
+    assert(committed); // Can't change while the lock is held.
+    (void)committed;
+}
+
+//------------------------------------------------------------------------------
+// Automatic compaction prepares the compacted master bank on a worker thread,
+// through its own handle to the master bank, so that reading the whole bank
+// doesn't delay the prompt.  A later call to compact() commits it.
+struct history_db::compact_task
+{
+                        compact_task(const char* path, const char* ctag, size_t limit, bool uniq);
+                        ~compact_task();
+    bool                is_done() const { return m_done.load(); }
+    void                wait();
+
+    compacted_bank      m_compacted;
+    bool                m_prepared = false; // Valid once is_done().
+
+private:
+    static void         proc(compact_task* task);
+    bank_handles        m_handles;
+    concurrency_tag     m_ctag;
+    const size_t        m_limit;
+    const bool          m_uniq;
+    std::atomic<bool>   m_done;
+    std::unique_ptr<std::thread> m_thread;
+};
+
+//------------------------------------------------------------------------------
+history_db::compact_task::compact_task(const char* path, const char* ctag, size_t limit, bool uniq)
+: m_limit(limit)
+, m_uniq(uniq)
+, m_done(false)
+{
+    m_ctag.set(ctag);
+    m_handles.m_handle_lines = open_file(path, true/*if_exists*/);
+    if (!m_handles)
+    {
+        m_done = true;
+        return;
+    }
+
+    dbg_ignore_scope(snapshot, "History compact thread");
+    m_thread = std::make_unique<std::thread>(&proc, this);
+}
+
+//------------------------------------------------------------------------------
+history_db::compact_task::~compact_task()
+{
+    wait();
+    m_handles.close();
+}
+
+//------------------------------------------------------------------------------
+void history_db::compact_task::wait()
+{
+    if (m_thread)
+    {
+        m_thread->join();
+        m_thread.reset();
+    }
+}
+
+//------------------------------------------------------------------------------
+void history_db::compact_task::proc(compact_task* task)
+{
+    {
+        // If another session holds the master bank lock (e.g. it's compacting
+        // or reaping), leave compaction for a later time.
+        read_lock src(task->m_handles, false, false/*wait*/);
+        if (src)
+        {
+            // If another session already compacted the master bank since it
+            // was loaded, then there's nothing to do.
+            concurrency_tag tag;
+            extract_ctag(src, tag);
+            if (strcmp(tag.get(), task->m_ctag.get()) == 0)
             {
-                if (keep->m_timestamp.m_line.get())
-                    remap->emplace(keep->m_timestamp.m_old.outer, keep->m_timestamp.m_new.outer);
-                remap->emplace(keep->m_line.m_old.outer, keep->m_line.m_new.outer);
+                prepare_master_bank(src, task->m_compacted, task->m_limit, task->m_uniq);
+                task->m_prepared = true;
             }
         }
     }
+
+    task->m_done = true;
 }
 
 //------------------------------------------------------------------------------
@@ -1210,6 +1464,8 @@ history_db::history_db(const char* path, int32 id, bool use_master_bank)
 //------------------------------------------------------------------------------
 history_db::~history_db()
 {
+    delete m_compact_task;
+
     // Close alive handle
     if (m_alive_file)
         CloseHandle(m_alive_file);
@@ -1321,7 +1577,8 @@ void history_db::initialise(str_base* error_message)
             write_lock lock(get_bank(bank_master));
             if (!extract_ctag(lock, m_master_ctag))
             {
-                rewrite_master_bank(lock);
+                compacted_bank compacted;
+                rewrite_master_bank(lock, compacted);
                 extract_ctag(lock, m_master_ctag);
             }
         }
@@ -1472,7 +1729,24 @@ static void __clear_history()
 //------------------------------------------------------------------------------
 void history_db::load_internal()
 {
+    // Size the history list up front instead of growing it while adding
+    // entries.  Reloading usually yields about as many entries as before, and
+    // the first load estimates the entry count from the size of the banks.
+    size_t reserve = m_index_map.size();
+    if (!reserve)
+    {
+        const uint32 c_estimated_line_bytes = 32;
+        for (const auto& handles : m_bank_handles)
+        {
+            const DWORD size = handles.m_handle_lines ? GetFileSize(handles.m_handle_lines, nullptr) : 0;
+            if (size != INVALID_FILE_SIZE)
+                reserve += size / c_estimated_line_bytes;
+        }
+        reserve = min<size_t>(reserve, c_max_max_history_lines);
+    }
+
     __clear_history();
+    history_reserve(int32(reserve));
     m_index_map.clear();
     m_master_len = 0;
     m_master_deleted_count = 0;
@@ -1603,59 +1877,120 @@ bool history_db::compact(bool force, bool uniq, int32 _limit)
     if (limit > c_max_max_history_lines)
         limit = c_max_max_history_lines;
 
-    // When force is true, load_internal() was not called, so m_master_len is 0,
-    // this loop can't remove entries, and rewrite_master_bank() does instead.
-    if (limit > 0 && !force)
+    // Automatic compaction happens while starting up, so it must not make the
+    // prompt wait.  If another session holds the master bank lock (e.g. it's
+    // compacting or reaping), leave compaction for a later time.
+    const bool wait = force;
+
+    bank_handles master_handles = get_bank(bank_master);
+    master_handles.m_handle_removals = nullptr; // Don't redirect removals.
+
+    // Commit a compacted master bank that a worker thread prepared for an
+    // earlier call.  This happens before pruning, so pruning can't remove
+    // lines that the compacted bank keeps.  Explicit compaction starts over.
+    compacted_bank compacted;
+    bool prepared = false;
+    if (m_compact_task)
     {
-        LOG("History:  %zu active, %zu deleted", m_master_len, m_master_deleted_count);
-        DIAG("... prune:  lines active %zu / limit %zu\n", m_master_len, limit);
+        if (!force && !m_compact_task->is_done())
+        {
+            DIAG("... skip compact; compacted master bank is still being prepared\n");
+            return false;
+        }
 
-        // Delete oldest history entries that exceed it.  This only marks them as
-        // deleted; compacting is a separate operation.
-        if (m_master_len > limit)
+        std::unique_ptr<compact_task> task(m_compact_task);
+        m_compact_task = nullptr;
+        if (!force && task->m_prepared)
         {
-            uint32 removed = 0;
-            while (m_master_len > limit)
+            DIAG("... compact:  commit prepared master bank\n");
+            compacted = std::move(task->m_compacted);
+            prepared = true;
+        }
+    }
+
+    if (!prepared)
+    {
+        // When force is true, load_internal() was not called, so m_master_len is 0,
+        // this loop can't remove entries, and prepare_master_bank() does instead.
+        if (limit > 0 && !force)
+        {
+            LOG("History:  %zu active, %zu deleted", m_master_len, m_master_deleted_count);
+            DIAG("... prune:  lines active %zu / limit %zu\n", m_master_len, limit);
+
+            // Delete oldest history entries that exceed it.  This only marks them as
+            // deleted; compacting is a separate operation.
+            if (m_master_len > limit)
             {
-                line_id_impl id;
-                id.outer = m_index_map[0];
-                if (id.bank_index != bank_master)
+                uint32 removed = 0;
+                while (m_master_len > limit)
                 {
-                    LOG("tried to trim from non-master bank");
-                    break;
-                }
-                //LOG("remove bank %u, offset %u, active %u (master len was %u)", id.bank_index, id.offset, id.active, m_master_len);
-                if (!remove(id))
-                {
-                    LOG("failed to remove");
-                    DIAG("... ... failed to remove line at offset %u\n", id.offset);
-                    break;
+                    line_id_impl id;
+                    id.outer = m_index_map[0];
+                    if (id.bank_index != bank_master)
+                    {
+                        LOG("tried to trim from non-master bank");
+                        break;
+                    }
+                    //LOG("remove bank %u, offset %u, active %u (master len was %u)", id.bank_index, id.offset, id.active, m_master_len);
+                    if (!remove(id))
+                    {
+                        LOG("failed to remove");
+                        DIAG("... ... failed to remove line at offset %u\n", id.offset);
+                        break;
+                    }
+                    removed++;
                 }
-                removed++;
+                LOG("History:  removed %u", removed);
+                DIAG("... ... lines removed %u\n", removed);
             }
-            LOG("History:  removed %u", removed);
-            DIAG("... ... lines removed %u\n", removed);
         }
+
+        // Since the ratio of deleted lines to active lines is already known here,
+        // this is the most convenient/performant place to compact the master bank.
+        size_t threshold = (limit ? max(limit, m_min_compact_threshold) : 5000);
+        if (!(force || m_master_deleted_count > threshold))
+        {
+            DIAG("... skip compact; threshold is %zu, actual marked for delete is %zu\n", threshold, m_master_deleted_count);
+            return false;
+        }
+
+        DIAG("... compact:  rewrite master bank\n");
+
+        assert(!m_master_ctag.empty());
+
+        // Prepare the compacted master bank while holding only a shared lock,
+        // so other sessions can still load history meanwhile.  Automatic
+        // compaction prepares it on a worker thread and commits it on a later
+        // call, so reading the whole bank doesn't delay the prompt.  The
+        // commit still rewrites the whole file while holding the exclusive
+        // lock; it's just a single write instead of a read and write per line.
+        if (!force)
+        {
+            DIAG("... compact:  prepare master bank in the background\n");
+            m_compact_task = new compact_task(m_bank_filenames[bank_master].c_str(), m_master_ctag.get(), limit, uniq);
+            return false;
+        }
+
+        read_lock src(master_handles, false, wait);
+        if (!src)
+        {
+            DIAG("... skip compact; master bank is busy\n");
+            return false;
+        }
+
+        prepare_master_bank(src, compacted, limit, uniq);
     }
 
-    // Since the ratio of deleted lines to active lines is already known here,
-    // this is the most convenient/performant place to compact the master bank.
-    size_t threshold = (limit ? max(limit, m_min_compact_threshold) : 5000);
-    if (!(force || m_master_deleted_count > threshold))
+    if (m_compact_prepared_hook)
+        m_compact_prepared_hook(m_compact_prepared_hook_data);
+
+    write_lock dest(master_handles, wait);
+    if (!dest)
     {
-        DIAG("... skip compact; threshold is %zu, actual marked for delete is %zu\n", threshold, m_master_deleted_count);
+        DIAG("... skip compact; master bank is busy\n");
         return false;
     }
 
-    DIAG("... compact:  rewrite master bank\n");
-
-    size_t kept, deleted, dups;
-    assert(!m_master_ctag.empty());
-
-    bank_handles master_handles = get_bank(bank_master);
-    master_handles.m_handle_removals = nullptr; // Don't redirect removals.
-    write_lock dest(master_handles);
-
     struct removal_file_data
     {
         str_moveable                m_file;
@@ -1706,11 +2041,24 @@ bool history_db::compact(bool force, bool uniq, int32 _limit)
         }
     });
 
-    // Rewrite the master bank and apply the limit (if any).  This may also
-    // optionally enforce uniqueness.  The result counters are written to
-    // the log file.
-    std::map<line_id_impl, line_id_impl> remap_removals;
-    rewrite_master_bank(dest, limit, &kept, &deleted, uniq, &dups, &remap_removals);
+    // Swap in the compacted master bank.  The limit (if any) and uniqueness
+    // (if requested) were already applied while preparing it.  The result
+    // counters are written to the log file.
+    if (!commit_master_bank(dest, compacted))
+    {
+        // The master bank changed too much while the compacted bank was being
+        // prepared.  Explicit compaction starts over while holding the lock.
+        if (!force)
+        {
+            DIAG("... skip compact; master bank changed while compacting\n");
+            return false;
+        }
+        rewrite_master_bank(dest, compacted, limit, uniq);
+    }
+
+    const size_t kept = compacted.m_kept;
+    const size_t deleted = compacted.m_deleted;
+    const size_t dups = compacted.m_dups;
 
     // Extract the new master concurrency tag.
     str<64> old_ctag(m_master_ctag.get());
@@ -1734,10 +2082,10 @@ bool history_db::compact(bool force, bool uniq, int32 _limit)
         // Look up the ids and write the new ids for ones that were kept.
         for (const auto& id : r.m_lines)
         {
-            const auto iter = remap_removals.find(id);
-            if (iter != remap_removals.end())
+            line_id_impl new_id;
+            if (compacted.translate(id, new_id))
             {
-                tmp.format("%u\n", iter->second.offset);
+                tmp.format("%u\n", new_id.offset);
                 WriteFile(handle, tmp.c_str(), tmp.length(), &written, nullptr);
             }
         }
@@ -1883,6 +2231,13 @@ bool history_db::remove_internal(line_id id, bool guard_ctag)
     return true;
 }
 
+//------------------------------------------------------------------------------
+void history_db::wait_for_compact_task()
+{
+    if (m_compact_task)
+        m_compact_task->wait();
+}
+
 //------------------------------------------------------------------------------
 void history_db::make_open_error(str_base* error_message, bank_t bank) const
 {
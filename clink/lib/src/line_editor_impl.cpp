@@ -27,6 +27,7 @@
 #endif
 
 #include <core/base.h>
+#include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/str_iter.h>
@@ -57,6 +58,7 @@ extern setting_bool g_autosuggest_enable;
 extern setting_bool g_history_autoexpand;
 extern setting_enum g_expand_mode;
 extern setting_bool g_history_show_preview;
+extern setting_int g_files_cache_ttl;
 extern setting_enum g_default_bindings;
 extern setting_color g_color_histexpand;
 // TODO: line_editor_impl vs rl_module.
@@ -318,6 +320,8 @@ void line_editor_impl::begin_line()
 
     set_active_line_editor(this, m_desc.callbacks);
 
+    globber::set_cache_ttl(max<int32>(g_files_cache_ttl.get(), 0));
+
     match_pipeline pipeline(m_matches);
     pipeline.reset();
 
@@ -337,6 +341,8 @@ void line_editor_impl::begin_line()
     m_command_line_states.clear();
     m_prev_words_buffer_fingerprint.clear();
     m_classify_words.clear();
+    m_classify_snapshot.reset();
+    m_classify_snapshot_fingerprint.clear();
 
     m_override_needle = nullptr;
     m_override_words.clear();
@@ -366,6 +372,7 @@ void line_editor_impl::end_line()
     m_words.clear();
     m_command_line_states.clear();
     m_classify_words.clear();
+    m_classify_snapshot.reset();
 
     set_active_line_editor(nullptr, nullptr);
 
@@ -672,7 +679,7 @@ void line_editor_impl::update_matches()
 
     if (generate)
     {
-        const auto linestates = get_linestates();
+        const auto& linestates = get_linestates();
         match_pipeline pipeline(m_matches);
         pipeline.reset();
         pipeline.generate(linestates, m_generator);
@@ -747,7 +754,7 @@ matches* line_editor_impl::maybe_regenerate_matches(const char* needle, display_
     if (debug_filter) puts("-- GENERATE");
 #endif
 
-    const auto linestates = command_line_states.get_linestates(m_buffer);
+    const auto& linestates = command_line_states.get_linestates(m_buffer);
     pipeline.generate(linestates, m_generator, old_filtering);
 
 #ifdef DEBUG
@@ -1049,11 +1056,25 @@ void line_editor_impl::collect_words()
 }
 
 //------------------------------------------------------------------------------
-command_line_states line_editor_impl::collect_command_line_states()
+std::shared_ptr<const command_line_snapshot> line_editor_impl::get_classify_snapshot()
 {
+    // The classifier and the hinter share one snapshot per revision of the
+    // line, and a forced reclassify reuses it if the line hasn't changed.
+    const line_buffer_fingerprint fp = m_buffer.get_fingerprint();
+    if (m_classify_snapshot &&
+        fp == m_classify_snapshot_fingerprint &&
+        m_classify_snapshot->is_line(m_buffer.get_buffer(), m_buffer.get_length()))
+    {
+        command_line_snapshot::note_reused();
+        return m_classify_snapshot;
+    }
+
     command_line_states command_line_states;
     collect_words(m_classify_words, nullptr, collect_words_mode::whole_command, command_line_states);
-    return command_line_states;
+
+    m_classify_snapshot = std::make_shared<command_line_snapshot>(command_line_states.get_linestates(m_buffer));
+    m_classify_snapshot_fingerprint = fp;
+    return m_classify_snapshot;
 }
 
 //------------------------------------------------------------------------------
@@ -1191,7 +1212,9 @@ void line_editor_impl::before_display_readline()
 
     bool calced_history_expansions = false;
     history_expansion* list = nullptr;
-    command_line_states command_line_states = ((!skip_classifier && !plain) || (!skip_hinter)) ? collect_command_line_states() : ::command_line_states();
+    std::shared_ptr<const command_line_snapshot> snapshot;
+    if ((!skip_classifier && !plain) || (!skip_hinter))
+        snapshot = get_classify_snapshot();
 
     if (!skip_classifier)
     {
@@ -1213,7 +1236,7 @@ void line_editor_impl::before_display_readline()
         else
         {
             // Use the full line; don't stop at the cursor.
-            m_classifier->classify(command_line_states.get_linestates(m_buffer), m_classifications, dbg_word_classes);
+            m_classifier->classify(snapshot->get_linestates(), m_classifications, dbg_word_classes);
             if (g_history_autoexpand.get() &&
                 g_expand_mode.get() &&
                 (g_history_show_preview.get() ||
@@ -1297,10 +1320,9 @@ void line_editor_impl::before_display_readline()
         const double clock = os::clock();
 #endif
 
-        // Ensure a word covers the cursorpos, so onadvance has a chance to
-        // run for the cursorpos.
-        command_line_states.split_for_hinter();
-        m_hinter->get_hint(command_line_states.get_linestate(m_buffer), m_input_hint);
+        // The hinter line state ensures a word covers the cursorpos, so
+        // onadvance has a chance to run for the cursorpos.
+        m_hinter->get_hint(snapshot->get_hinter_linestate(), m_input_hint);
 
 #ifdef DEBUG
         const int32 dbgrow = dbg_get_env_int("DEBUG_HINTER");
@@ -1434,7 +1456,7 @@ void line_editor_impl::reclassify(reclassify_reason why)
 }
 
 //------------------------------------------------------------------------------
-line_state line_editor_impl::get_linestate() const
+const line_state& line_editor_impl::get_linestate() const
 {
     assert(!need_collect_words());
 
@@ -1445,7 +1467,7 @@ line_state line_editor_impl::get_linestate() const
 }
 
 //------------------------------------------------------------------------------
-line_states line_editor_impl::get_linestates() const
+const line_states& line_editor_impl::get_linestates() const
 {
     assert(!need_collect_words());
 
@@ -132,7 +132,7 @@ private:
     void                begin_line();
     void                end_line();
     void                collect_words();
-    command_line_states collect_command_line_states();
+    std::shared_ptr<const command_line_snapshot> get_classify_snapshot();
     uint32              collect_words(words& words, matches_impl* matches, collect_words_mode mode, command_line_states& command_line_states);
     void                before_display_readline();
     void                maybe_send_oncommand_event();
@@ -141,8 +141,8 @@ private:
     void                update_internal(bool force=false);
     bool                update_input();
     module::context     get_context() const;
-    line_state          get_linestate() const;
-    line_states         get_linestates() const;
+    const line_state&   get_linestate() const;
+    const line_states&  get_linestates() const;
     void                set_flag(uint8 flag);
     void                clear_flag(uint8 flag);
     bool                check_flag(uint8 flag) const;
@@ -187,6 +187,8 @@ private:
     int32               m_prev_cursor = 0;
     prev_buffer         m_prev_classify;
     words               m_classify_words;
+    std::shared_ptr<const command_line_snapshot> m_classify_snapshot;
+    line_buffer_fingerprint m_classify_snapshot_fingerprint;
 
     str<16>             m_prev_command_word;
     line_buffer_fingerprint m_prev_command_buffer_fingerprint;
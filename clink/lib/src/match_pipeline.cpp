@@ -7,6 +7,7 @@
 #include "match_pipeline.h"
 #include "matches_impl.h"
 #include "display_matches.h"
+#include "fuzzy_match.h"
 #include "slash_translation.h"
 
 #include <core/array.h>
@@ -49,6 +50,15 @@ setting_bool g_files_system(
     "file lists.",
     false);
 
+setting_int g_files_cache_ttl(
+    "files.cache_ttl",
+    "Seconds to cache directory listings",
+    "Completing file names caches recent directory listings, so that completing\n"
+    "again in the same directory is faster.  A cached listing is discarded when\n"
+    "the directory changes, or after this many seconds.  Set this to 0 to\n"
+    "disable the cache.",
+    5);
+
 extern setting_enum g_default_bindings;
 extern setting_bool g_match_wild;
 
@@ -511,6 +521,65 @@ void match_pipeline::select(const char* needle) const
 #endif
 }
 
+//------------------------------------------------------------------------------
+void match_pipeline::select_fuzzy(const char* needle) const
+{
+    const int32 count = m_matches.get_info_count();
+
+    str<> expanded;
+    if (rl_complete_with_tilde_expansion && needle[0] == '~')
+    {
+        if (path::tilde_expand(needle, expanded))
+        {
+            if (!needle[1])
+                path::maybe_strip_last_separator(expanded);
+            needle = expanded.c_str();
+        }
+    }
+
+    // Scores are indexed by ordinal, since coalescing moves the infos.
+    std::vector<int32> scores;
+    if (count)
+    {
+        fuzzy_matcher matcher;
+        matcher.set_needle(needle, str_compare_scope::current(), str_compare_scope::current_fuzzy_accents());
+
+        const bool include_hidden = (_rl_match_hidden_files || *path::get_name(needle) == '.');
+        match_info* const infos = m_matches.get_infos();
+        for (int32 i = 0; i < count; ++i)
+        {
+            auto& info = infos[i];
+            int32 score = fuzzy_matcher::no_match;
+            if ((include_hidden || !path::is_unix_hidden(info.match, true)) &&
+                include_match_type(info.type))
+                score = matcher.score(info.match);
+
+            info.select = (score != fuzzy_matcher::no_match);
+            if (info.select)
+            {
+                if (scores.size() <= info.ordinal)
+                    scores.resize(info.ordinal + 1, fuzzy_matcher::no_match);
+                scores[info.ordinal] = score;
+            }
+        }
+        m_matches.set_completion_type(rl_completion_type);
+    }
+
+    m_matches.coalesce(count);
+
+    // The best matches go first; ties keep the original order.
+    auto predicate = [&] (const match_info& lhs, const match_info& rhs) {
+        const int32 l = scores[lhs.ordinal];
+        const int32 r = scores[rhs.ordinal];
+        if (l != r)
+            return l > r;
+        return lhs.ordinal < rhs.ordinal;
+    };
+
+    match_info* const infos = m_matches.get_infos();
+    std::sort(infos, infos + m_matches.get_match_count(), predicate);
+}
+
 //------------------------------------------------------------------------------
 void match_pipeline::sort() const
 {
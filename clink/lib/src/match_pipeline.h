@@ -20,6 +20,7 @@ public:
     void                restrict(str_base& needle) const;
     void                restrict(char** keep_matches) const;
     void                select(const char* needle) const;
+    void                select_fuzzy(const char* needle) const;
     void                sort() const;
 
 private:
@@ -594,7 +594,7 @@ matches_impl::store_impl::store_impl(uint32 size)
 
 //------------------------------------------------------------------------------
 matches_impl::matches_impl()
-: m_store(0x10000u)
+: m_shared(std::make_shared<shared_store>())
 , m_filename_completion_desired(false)
 , m_filename_display_desired(false)
 {
@@ -621,7 +621,7 @@ matches_iter matches_impl::get_iter(const char* pattern) const
 //------------------------------------------------------------------------------
 uint32 matches_impl::get_info_count() const
 {
-    return int32(m_infos.size());
+    return uint32(m_infos.size());
 }
 
 //------------------------------------------------------------------------------
@@ -684,7 +684,7 @@ const char* matches_impl::get_match_display(uint32 index) const
     if (index >= get_match_count())
         return nullptr;
 
-    return m_infos[index].display;
+    return get_aux(m_infos[index]).display;
 }
 
 //------------------------------------------------------------------------------
@@ -693,7 +693,7 @@ const char* matches_impl::get_match_description(uint32 index) const
     if (index >= get_match_count())
         return nullptr;
 
-    return m_infos[index].description;
+    return get_aux(m_infos[index]).description;
 }
 
 //------------------------------------------------------------------------------
@@ -711,7 +711,7 @@ char matches_impl::get_match_append_char(uint32 index) const
     if (index >= get_match_count())
         return 0;
 
-    return m_infos[index].append_char;
+    return get_aux(m_infos[index]).append_char;
 }
 
 //------------------------------------------------------------------------------
@@ -720,7 +720,7 @@ shadow_bool matches_impl::get_match_suppress_append(uint32 index) const
     shadow_bool tmp(false);
     if (index < get_match_count())
     {
-        char suppress = m_infos[index].suppress_append;
+        char suppress = get_aux(m_infos[index]).suppress_append;
         if (suppress >= 0)
             tmp.set_explicit(suppress);
     }
@@ -733,21 +733,22 @@ bool matches_impl::get_match_append_display(uint32 index) const
     if (index >= get_match_count())
         return false;
 
-    return m_infos[index].append_display;
+    return get_aux(m_infos[index]).append_display;
 }
 
 //------------------------------------------------------------------------------
 bool matches_impl::get_match_custom_display(uint32 index) const
 {
-    auto& info = m_infos[index];
-    if (info.custom_display < 0)
+    const auto& info = m_infos[index];
+    const auto& aux = get_aux(info);
+    if (aux.custom_display < 0)
     {
         const char* match = info.match;
         if (!is_match_type(info.type, match_type::none))
             match = __printable_part(const_cast<char*>(match));
-        return (strcmp(match, info.display) != 0);
+        return (strcmp(match, aux.display) != 0);
     }
-    return info.custom_display > 0;
+    return aux.custom_display > 0;
 }
 
 //------------------------------------------------------------------------------
@@ -774,7 +775,7 @@ const char* matches_impl::get_unfiltered_match_display(uint32 index) const
     if (index >= get_info_count())
         return nullptr;
 
-    return m_infos[index].display;
+    return get_aux(m_infos[index]).display;
 }
 
 //------------------------------------------------------------------------------
@@ -783,7 +784,7 @@ const char* matches_impl::get_unfiltered_match_description(uint32 index) const
     if (index >= get_info_count())
         return nullptr;
 
-    return m_infos[index].description;
+    return get_aux(m_infos[index]).description;
 }
 
 //------------------------------------------------------------------------------
@@ -792,7 +793,7 @@ char matches_impl::get_unfiltered_match_append_char(uint32 index) const
     if (index >= get_info_count())
         return 0;
 
-    return m_infos[index].append_char;
+    return get_aux(m_infos[index]).append_char;
 }
 
 //------------------------------------------------------------------------------
@@ -801,7 +802,7 @@ shadow_bool matches_impl::get_unfiltered_match_suppress_append(uint32 index) con
     shadow_bool tmp(false);
     if (index < get_info_count())
     {
-        char suppress = m_infos[index].suppress_append;
+        char suppress = get_aux(m_infos[index]).suppress_append;
         if (suppress >= 0)
             tmp.set_explicit(suppress);
     }
@@ -814,7 +815,7 @@ bool matches_impl::get_unfiltered_match_append_display(uint32 index) const
     if (index >= get_info_count())
         return false;
 
-    return m_infos[index].append_display;
+    return get_aux(m_infos[index]).append_display;
 }
 
 //------------------------------------------------------------------------------
@@ -928,7 +929,15 @@ void matches_impl::reset()
     delete m_dedup;
     m_dedup = nullptr;
 
-    m_store.reset();
+    if (m_shared.use_count() > 1)
+    {
+        m_shared = std::make_shared<shared_store>();
+    }
+    else
+    {
+        m_shared->store.reset();
+        m_shared->aux.clear();
+    }
     m_infos.clear();
     m_count = 0;
     m_any_none_type = false;
@@ -959,8 +968,9 @@ void matches_impl::transfer(matches_impl& from)
     // Do not transfer m_generator; it is consumer configuration, not part of
     // the matches state.
 
-    m_store = std::move(from.m_store);
+    m_shared = std::move(from.m_shared);
     m_infos = std::move(from.m_infos);
+    from.m_shared = std::make_shared<shared_store>();
     m_generation_id = from.m_generation_id;
     m_count = from.m_count;
     m_any_none_type = from.m_any_none_type;
@@ -993,21 +1003,12 @@ void matches_impl::copy(const matches_impl& from)
 {
     clear();
 
-    for (const auto& info : from.m_infos)
-    {
-        match_info add;
-        add.match = info.match ? m_store.store_front(info.match) : nullptr;
-        add.display = info.display ? m_store.store_front(info.display) : nullptr;
-        add.description = info.description ? m_store.store_front(info.description) : nullptr;
-        add.ordinal = m_infos.size();
-        add.type = info.type;
-        add.append_char = info.append_char;
-        add.suppress_append = info.suppress_append;
-        add.append_display = info.append_display;
-        add.custom_display = info.custom_display;
-        add.select = false; // (Shouldn't matter.)
-        m_infos.emplace_back(std::move(add));
-    }
+    // Share the immutable strings and cold fields; only the hot match_info
+    // array is copied, so the copy can select and sort independently.
+    m_shared = from.m_shared;
+    m_infos = from.m_infos;
+    for (auto& info : m_infos)
+        info.select = false; // (Shouldn't matter.)
 
     m_generation_id = from.m_generation_id;
     m_count = from.m_count;
@@ -1035,7 +1036,32 @@ void matches_impl::copy(const matches_impl& from)
 void matches_impl::clear()
 {
     reset();
-    m_store.clear();
+    if (m_shared.use_count() <= 1)
+        m_shared->store.clear();
+}
+
+//------------------------------------------------------------------------------
+void matches_impl::unshare()
+{
+    if (m_shared.use_count() <= 1)
+        return;
+
+    // Something else still references the shared store, so make a private
+    // copy of the strings and cold fields before modifying anything.
+    std::shared_ptr<shared_store> from = std::move(m_shared);
+    m_shared = std::make_shared<shared_store>();
+    m_shared->aux.reserve(from->aux.size());
+
+    for (const auto& aux : from->aux)
+    {
+        match_aux_info add_aux = aux;
+        add_aux.display = aux.display ? m_shared->store.store_front(aux.display) : nullptr;
+        add_aux.description = aux.description ? m_shared->store.store_front(aux.description) : nullptr;
+        m_shared->aux.emplace_back(std::move(add_aux));
+    }
+
+    for (auto& info : m_infos)
+        info.match = info.match ? m_shared->store.store_front(info.match) : nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -1210,7 +1236,9 @@ bool matches_impl::add_match(const match_desc& desc, bool already_normalized)
         match = tmp.c_str();
     }
 
-    const char* store_match = m_store.store_front(match);
+    unshare();
+
+    const char* store_match = m_shared->store.store_front(match);
     if (!store_match)
         return false;
 
@@ -1225,25 +1253,30 @@ bool matches_impl::add_match(const match_desc& desc, bool already_normalized)
             m_any_none_type = true;
     }
 
-    const char* store_display = (desc.display && *desc.display) ? m_store.store_front(desc.display) : nullptr;
-    const char* store_description = (desc.description && *desc.description) ? m_store.store_front(desc.description) : nullptr;
+    const char* store_display = (desc.display && *desc.display) ? m_shared->store.store_front(desc.display) : nullptr;
+    const char* store_description = (desc.description && *desc.description) ? m_shared->store.store_front(desc.description) : nullptr;
     bool append_display = (desc.append_display && store_display);
 
     match_lookup lookup = { store_match, type };
     m_dedup->emplace(std::move(lookup));
 
+    assert(m_infos.size() == m_shared->aux.size());
+
     match_info info;
     info.match = store_match;
-    info.display = store_display;
-    info.description = store_description;
     info.ordinal = uint32(m_infos.size());
     info.type = type;
-    info.append_char = desc.append_char;
-    info.suppress_append = desc.suppress_append;
-    info.append_display = append_display;
-    info.custom_display = (desc.missing_match ? true : (store_display ? -1 : false));
     info.select = false;
     m_infos.emplace_back(std::move(info));
+
+    match_aux_info aux;
+    aux.display = store_display;
+    aux.description = store_description;
+    aux.append_char = desc.append_char;
+    aux.suppress_append = desc.suppress_append;
+    aux.append_display = append_display;
+    aux.custom_display = (desc.missing_match ? true : (store_display ? -1 : false));
+    m_shared->aux.emplace_back(std::move(aux));
     ++m_count;
 
     if (store_description)
@@ -1261,6 +1294,8 @@ void matches_impl::set_generator(match_generator* generator)
 //------------------------------------------------------------------------------
 void matches_impl::done_building()
 {
+    unshare();
+
     // If there were any `none` type matches and file completion has not been
     // explicitly disabled, then it's necessary to post-process the matches to
     // identify which are directories, or files, or neither.
@@ -1276,6 +1311,7 @@ void matches_impl::done_building()
         case slash_translation::automatic:  sep = m_sep; break;
         }
 
+        bool any_erased = false;
         for (uint32 i = m_count; i--;)
         {
             auto& info = m_infos[i];
@@ -1305,11 +1341,27 @@ void matches_impl::done_building()
 
                 // Check if it has become a duplicate.
                 if (m_dedup->find(lookup) != m_dedup->end())
+                {
+                    assert(info.ordinal == i);
                     m_infos.erase(m_infos.begin() + i);
+                    m_shared->aux.erase(m_shared->aux.begin() + i);
+                    --m_count;
+                    any_erased = true;
+                }
                 else
+                {
                     m_dedup->emplace(std::move(lookup));
+                }
             }
         }
+
+        // Matches are still in their original order here, so the ordinals
+        // can simply be renumbered to keep indexing the aux infos correctly.
+        if (any_erased)
+        {
+            for (uint32 i = 0; i < m_infos.size(); ++i)
+                m_infos[i].ordinal = i;
+        }
     }
 
     delete m_dedup;
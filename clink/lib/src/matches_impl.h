@@ -7,22 +7,34 @@
 
 #include "core/array.h"
 #include "core/linear_allocator.h"
+#include <memory>
 #include <unordered_set>
 #include <vector>
 
 //------------------------------------------------------------------------------
+// Hot fields, touched by every select, sort, and coalesce pass.  These are
+// reordered in place as the matches are selected and sorted.
 struct match_info
 {
     const char*     match;
+    uint32          ordinal;            // Original unsorted order; indexes match_aux_info.
+    match_type      type;
+    bool            select;
+};
+
+static_assert(sizeof(match_info) <= sizeof(void*) + 8, "match_info should stay compact; move cold fields into match_aux_info");
+
+//------------------------------------------------------------------------------
+// Cold fields, only needed for displaying or inserting a match.  These stay in
+// the original unsorted order, and are found via match_info::ordinal.
+struct match_aux_info
+{
     const char*     display;
     const char*     description;
-    unsigned        ordinal;            // Original unsorted order.
-    match_type      type;
     char            append_char;        // Zero means not specified.
     char            suppress_append;    // Negative means not specified.
     bool            append_display;
     char            custom_display;     // Negative means not calculated yet.
-    bool            select;
 };
 
 //------------------------------------------------------------------------------
@@ -134,7 +146,9 @@ private:
     uint32                  get_info_count() const;
     const match_info*       get_infos() const;
     match_info*             get_infos();
+    const match_aux_info&   get_aux(const match_info& info) const { return m_shared->aux[info.ordinal]; }
     void                    reset();
+    void                    unshare();
     void                    coalesce(uint32 count_hint, bool restrict=false);
 
 private:
@@ -146,13 +160,25 @@ private:
     };
 
     typedef std::vector<match_info> infos;
+    typedef std::vector<match_aux_info> aux_infos;
+
+    // The strings and cold fields of a completed match set are immutable, so
+    // copies share them by reference instead of re-storing every string.  Each
+    // copy has its own match_info array, which it selects and sorts as an
+    // independent view.
+    struct shared_store
+    {
+                            shared_store() : store(0x10000u) {}
+        store_impl          store;
+        aux_infos           aux;
+    };
 
     match_generator*        m_generator = nullptr;
 
-    store_impl              m_store;
+    std::shared_ptr<shared_store> m_shared;
     infos                   m_infos;
     int32                   m_generation_id = -1;
-    unsigned short          m_count = 0;
+    uint32                  m_count = 0;
     bool                    m_any_none_type = false;
     bool                    m_deprecated_mode = false;
     bool                    m_coalesced = false;
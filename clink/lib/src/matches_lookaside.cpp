@@ -107,18 +107,43 @@ match_details::match_details(const char* match, const match_extra* extra)
 
 
 
+//------------------------------------------------------------------------------
+static void parse_packed_match(const char* match, match_extra* extra)
+{
+    size_t len = strlen(match) + 1;
+    const uint16 lo_type = static_cast<uint8>(match[len++]);
+    const uint16 hi_type = static_cast<uint8>(match[len++]);
+    extra->type = static_cast<match_type>(lo_type | (hi_type << 8));
+    extra->append_char = match[len++];
+    extra->flags = uint8(match[len++]);
+#ifdef DEBUG
+    const bool is_magic = (strnicmp(match + len, ":LA:", 4) == 0);
+    assert(is_magic);
+    len += 4;
+#endif
+    extra->display_offset = static_cast<unsigned short>(len);
+    extra->description_offset = static_cast<unsigned short>(len + strlen(match + len) + 1);
+}
+
+
+
 //------------------------------------------------------------------------------
 class matches_lookaside
 {
     typedef std::unordered_map<UINT_PTR, match_extra*> match_extra_map;
 public:
                             matches_lookaside(char** matches);
+                            matches_lookaside(char** matches, char* arena, size_t arena_size);
                             ~matches_lookaside();
     bool                    associated(char** matches) const;
+    bool                    owns(const char* match) const;
     const match_extra*      find(const char* match) const;
+    void                    release_arena();
 private:
     bool                    add(const char* match);
     char**                  m_matches;
+    char*                   m_arena = nullptr;
+    size_t                  m_arena_size = 0;
     match_extra_map         m_map;
     linear_allocator        m_allocator;
 };
@@ -136,9 +161,48 @@ matches_lookaside::matches_lookaside(char** matches)
         while (add(*(++matches))) {}
 };
 
+//------------------------------------------------------------------------------
+matches_lookaside::matches_lookaside(char** matches, char* arena, size_t arena_size)
+: m_matches(matches)
+, m_arena(arena)
+, m_arena_size(arena_size)
+, m_allocator(8192)
+{
+    assert(matches);
+    assert(arena);
+}
+
 //------------------------------------------------------------------------------
 matches_lookaside::~matches_lookaside()
 {
+    free(m_arena);
+}
+
+//------------------------------------------------------------------------------
+bool matches_lookaside::owns(const char* match) const
+{
+    return m_arena && match >= m_arena && match < m_arena + m_arena_size;
+}
+
+//------------------------------------------------------------------------------
+void matches_lookaside::release_arena()
+{
+    if (!m_arena)
+        return;
+
+    // Remove the matches owned by the arena, so that Readline only frees the
+    // remaining entries individually (normally just the lcd).
+    char** write = m_matches;
+    for (char** read = m_matches; *read; ++read)
+    {
+        if (!owns(*read))
+            *(write++) = *read;
+    }
+    *write = nullptr;
+
+    free(m_arena);
+    m_arena = nullptr;
+    m_arena_size = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -150,6 +214,18 @@ bool matches_lookaside::associated(char** matches) const
 //------------------------------------------------------------------------------
 const match_extra* matches_lookaside::find(const char* match) const
 {
+    if (m_arena)
+    {
+        // Each match in the arena is immediately preceded by its match_extra.
+        if (!owns(match))
+            return nullptr;
+        const match_extra* extra = reinterpret_cast<const match_extra*>(match - sizeof(match_extra));
+#ifdef DEBUG
+        assert(strnicmp(match + extra->display_offset - 4, ":LA:", 4) == 0);
+#endif
+        return extra;
+    }
+
     auto const iter = m_map.find(reinterpret_cast<UINT_PTR>(match));
     if (iter == m_map.end())
         return nullptr;
@@ -167,21 +243,172 @@ bool matches_lookaside::add(const char* match)
     if (!extra)
         return false;
 
-    size_t len = strlen(match) + 1;
-    const uint16 lo_type = static_cast<uint8>(match[len++]);
-    const uint16 hi_type = static_cast<uint8>(match[len++]);
-    extra->type = static_cast<match_type>(lo_type | (hi_type << 8));
-    extra->append_char = match[len++];
-    extra->flags = uint8(match[len++]);
+    parse_packed_match(match, extra);
+
+    m_map.emplace(key, extra);
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------
+packed_match_list_builder::packed_match_list_builder(uint32 count_hint)
+{
+    ensure_matches(count_hint);
+    ensure_arena(size_t(count_hint) * 64);
+}
+
+//------------------------------------------------------------------------------
+packed_match_list_builder::~packed_match_list_builder()
+{
+    if (m_matches)
+        free(m_matches[0]);
+    free(m_matches);
+    free(m_arena);
+}
+
+//------------------------------------------------------------------------------
+bool packed_match_list_builder::set_lcd(const char* text, uint32 len)
+{
+    if (!ensure_matches(0))
+        return false;
+
+    char* lcd = static_cast<char*>(malloc(len + 1));
+    if (!lcd)
+        return false;
+
+    memcpy(lcd, text, len);
+    lcd[len] = '\0';
+
+    free(m_matches[0]);
+    m_matches[0] = lcd;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool packed_match_list_builder::add(const char* match, match_type type,
+                                    const char* display, const char* description,
+                                    char append_char, uint8 flags)
+{
+    if (!ensure_matches(m_count + 1))
+        return false;
+
+    // Each entry is a match_extra followed by the PACKED MATCH FORMAT, padded
+    // so the next match_extra is aligned.
+    const size_t packed_size = calc_packed_size(match, display, description);
+    const size_t align = alignof(match_extra);
+    const size_t entry_size = (sizeof(match_extra) + packed_size + align - 1) & ~(align - 1);
+    if (!ensure_arena(m_arena_used + entry_size))
+        return false;
+
+    char* const entry = m_arena + m_arena_used;
+    char* const packed = entry + sizeof(match_extra);
+    if (!pack_match(packed, packed_size, match, type, display, description, append_char, flags))
+        return false;
+
+    parse_packed_match(packed, reinterpret_cast<match_extra*>(entry));
+
+    // The arena may move while it grows, so store offsets until detach().
+    m_matches[++m_count] = reinterpret_cast<char*>(m_arena_used + sizeof(match_extra));
+    m_arena_used += entry_size;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+char** packed_match_list_builder::detach()
+{
+    if (!m_matches || !m_matches[0])
+        return nullptr;
+
+    // Trim the arena before converting offsets into pointers.
+    if (m_arena_used && m_arena_used < m_arena_size)
+    {
+        if (char* trimmed = static_cast<char*>(realloc(m_arena, m_arena_used)))
+        {
+            m_arena = trimmed;
+            m_arena_size = m_arena_used;
+        }
+    }
+
+    for (uint32 i = 1; i <= m_count; ++i)
+        m_matches[i] = m_arena + reinterpret_cast<size_t>(m_matches[i]);
+    m_matches[m_count + 1] = nullptr;
+
+    char** matches = m_matches;
+
 #ifdef DEBUG
-    const bool is_magic = (strnicmp(match + len, ":LA:", 4) == 0);
-    assert(is_magic);
-    len += 4;
+    // Make sure the pool isn't growing large, which would suggest a bug (leak).
+    assert(s_lookasides.size() <= 5);
 #endif
-    extra->display_offset = static_cast<unsigned short>(len);
-    extra->description_offset = static_cast<unsigned short>(len + strlen(match + len) + 1);
 
-    m_map.emplace(key, extra);
+    if (m_count)
+    {
+        s_lookasides.push_front(new matches_lookaside(matches, m_arena, m_arena_size));
+    }
+    else
+    {
+        // An empty list still needs a lookaside so destroy doesn't complain.
+        free(m_arena);
+        create_matches_lookaside(matches);
+    }
+
+    m_matches = nullptr;
+    m_reserved = 0;
+    m_count = 0;
+    m_arena = nullptr;
+    m_arena_size = 0;
+    m_arena_used = 0;
+    return matches;
+}
+
+//------------------------------------------------------------------------------
+bool packed_match_list_builder::ensure_matches(uint32 count)
+{
+    count += 2; // For the lcd and the terminating nullptr.
+    if (count > m_reserved)
+    {
+        uint32 new_reserve = 64;
+        while (new_reserve < count)
+        {
+            const uint32 prev = new_reserve;
+            new_reserve <<= 1;
+            if (new_reserve < prev)
+                return false;
+        }
+
+        char** new_matches = static_cast<char**>(realloc(m_matches, new_reserve * sizeof(m_matches[0])));
+        if (!new_matches)
+            return false;
+
+        if (!m_matches)
+            new_matches[0] = nullptr;
+        m_matches = new_matches;
+        m_reserved = new_reserve;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool packed_match_list_builder::ensure_arena(size_t size)
+{
+    if (size > m_arena_size)
+    {
+        size_t new_size = max<size_t>(4096, m_arena_size);
+        while (new_size < size)
+        {
+            const size_t prev = new_size;
+            new_size <<= 1;
+            if (new_size < prev)
+                return false;
+        }
+
+        char* new_arena = static_cast<char*>(realloc(m_arena, new_size));
+        if (!new_arena)
+            return false;
+
+        m_arena = new_arena;
+        m_arena_size = new_size;
+    }
     return true;
 }
 
@@ -239,6 +466,7 @@ int32 destroy_matches_lookaside(char** matches)
     for (auto iter = s_lookasides.begin(); iter != s_lookasides.end(); iter++)
         if ((*iter)->associated(matches))
         {
+            (*iter)->release_arena();
             delete *iter;
             s_lookasides.erase(iter);
             return true;
@@ -251,6 +479,17 @@ int32 destroy_matches_lookaside(char** matches)
     return false;
 }
 
+//------------------------------------------------------------------------------
+void free_match(char* match)
+{
+    // Matches packed into an arena are freed along with the arena.
+    for (auto iter : s_lookasides)
+        if (iter->owns(match))
+            return;
+
+    free(match);
+}
+
 //------------------------------------------------------------------------------
 void set_matches_lookaside_oneoff(const char* match, match_type type, char append_char, uint8 flags)
 {
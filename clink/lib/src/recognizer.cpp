@@ -6,11 +6,13 @@
 #include "reclassify.h"
 #include "recognizer.h"
 
+#include <core/env_snapshot.h>
+#include <core/exec_index.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/str.h>
 #include <core/str_iter.h>
-#include <core/str_tokeniser.h>
+#include <core/str_pool.h>
 #include <core/str_transform.h>
 #include <core/str_unordered_set.h>
 #include <core/settings.h>
@@ -18,6 +20,7 @@
 #include <core/debugheap.h>
 
 #include <memory>
+#include <vector>
 #include <thread>
 #include <mutex>
 #include <shlwapi.h>
@@ -66,7 +69,7 @@ static bool file_exists(const char* full, str_base& out)
 }
 
 //------------------------------------------------------------------------------
-static bool search_for_extension(str_base& full, const char* word, str_base& out)
+static bool search_for_extension(str_base& full, const char* word, const env_snapshot& env, str_base& out)
 {
     path::append(full, "");
     const uint32 trunc = full.length();
@@ -78,25 +81,18 @@ static bool search_for_extension(str_base& full, const char* word, str_base& out
             return true;
     }
 
-    str<> pathext;
-    if (!os::get_env("pathext", pathext))
+    const auto& pathexts = env.get_pathexts();
+    if (pathexts.empty())
         return false;
 
-    str_tokeniser tokens(pathext.c_str(), ";");
-    const char *start;
-    int32 length;
-
     const char* ext = path::get_extension(word);
     if (ext && str_icmp(ext, ".LNK") == 0 && file_exists(full.c_str(), out))
         return true;
 
-    str<16> token_ext;
-    while (str_token token = tokens.next(start, length))
+    for (const auto& token_ext : pathexts)
     {
         if (ext)
         {
-            token_ext.clear();
-            token_ext.concat(start, length);
             if (token_ext.iequals(ext))
             {
                 full.truncate(trunc);
@@ -108,7 +104,7 @@ static bool search_for_extension(str_base& full, const char* word, str_base& out
 
         full.truncate(trunc);
         path::append(full, word);
-        full.concat(start, length);
+        full.concat(token_ext.c_str(), token_ext.length());
         if (file_exists(full.c_str(), out))
             return true;
     }
@@ -129,6 +125,40 @@ static bool search_for_extension(str_base& full, const char* word, str_base& out
     return false;
 }
 
+//------------------------------------------------------------------------------
+static bool search_dirs(const std::vector<const char*>& paths, const char* word, const char* cwd, const env_snapshot& env, str_base& out)
+{
+    str<> tmp;
+    str<> full;
+    for (const char* dir : paths)
+    {
+        if (!*dir)
+            continue;
+
+        // Get full path name.
+        path::join(cwd, dir, tmp);
+        if (!os::get_full_path_name(tmp.c_str(), full, tmp.length()))
+            continue;
+
+        // Skip drives that are unknown, invalid, or remote.
+        {
+            char drive[4];
+            drive[0] = full.c_str()[0];
+            drive[1] = ':';
+            drive[2] = '\\';
+            drive[3] = '\0';
+            if (os::get_drive_type(drive) < os::drive_type_removable)
+                continue;
+        }
+
+        // Try PATHEXT extensions.
+        if (search_for_extension(full, word, env, out))
+            return true;
+    }
+
+    return false;
+}
+
 //------------------------------------------------------------------------------
 static bool search_for_executable(const char* _word, const char* cwd, str_base& out)
 {
@@ -141,53 +171,59 @@ static bool search_for_executable(const char* _word, const char* cwd, str_base&
     const bool need_cwd = !!NeedCurrentDirectoryForExePathW(word.c_str());
     const bool need_path = !rl_last_path_separator(_word);
 
+    // When the executables index is current, it answers %PATH% lookups for
+    // plain command names without touching the file system.
+    std::shared_ptr<const exec_index> index;
+    if (need_path && !path::is_rooted(_word) && !path::get_extension(_word))
+        index = exec_index::get();
+
     // Make list of paths to search.
-    str<> tmp;
-    str<> paths;
+    const std::shared_ptr<const env_snapshot> env = env_snapshot::get();
+    std::vector<const char*> paths;
+    str<> rooted_dir;
     if (path::is_rooted(_word))
     {
-        path::get_directory(_word, paths);
+        path::get_directory(_word, rooted_dir);
+        paths.push_back(rooted_dir.c_str());
     }
     else
     {
         if (need_cwd)
-            paths = cwd;
-        if (need_path && os::get_env("PATH", tmp))
+            paths.push_back(cwd);
+        if (need_path && !index)
         {
-            if (paths.length() > 0)
-                paths.concat(";", 1);
-            paths.concat(tmp.c_str(), tmp.length());
+            for (const auto& dir : env->get_paths())
+                paths.push_back(dir.c_str());
         }
     }
 
-    str<> full;
-    str<280> token;
-    str_tokeniser tokens(paths.c_str(), ";");
-    while (tokens.next(token))
-    {
-        token.trim();
-        if (token.empty())
-            continue;
-
-        // Get full path name.
-        path::join(cwd, token.c_str(), tmp);
-        if (!os::get_full_path_name(tmp.c_str(), full, tmp.length()))
-            continue;
+    if (search_dirs(paths, _word, cwd, *env, out))
+        return true;
 
-        // Skip drives that are unknown, invalid, or remote.
+    if (index)
+    {
+        // Skips the same non-local directories as the loop above.
+        const exec_index::entry* entry = index->find_command(_word, true/*local_only*/);
+        if (entry)
         {
-            char drive[4];
-            drive[0] = full.c_str()[0];
-            drive[1] = ':';
-            drive[2] = '\\';
-            drive[3] = '\0';
-            if (os::get_drive_type(drive) < os::drive_type_removable)
-                continue;
+            str<> full(index->get_dir(entry->dir));
+            path::append(full, entry->name);
+            if (file_exists(full.c_str(), out))
+                return true;
         }
 
-        // Try PATHEXT extensions.
-        if (search_for_extension(full, _word, out))
-            return true;
+        // The index is rebuilt at most every couple of seconds, so it can
+        // miss an executable that was just created.  Most misses are partial
+        // words, though, so only probe the directories directly when one of
+        // them changed since the index was built, and rebuild the index.
+        if (!index->is_out_of_date())
+            return false;
+
+        exec_index::refresh(true/*force*/);
+        paths.clear();
+        for (const auto& dir : env->get_paths())
+            paths.push_back(dir.c_str());
+        return search_dirs(paths, _word, cwd, *env, out);
     }
 
     return false;
@@ -209,8 +245,8 @@ class recognizer
 
     struct cache_entry
     {
-        char*               m_key; // Owns lifetime of the key in m_cache or m_pending.
-        str_moveable        m_file;
+        interned_str        m_key; // Owns lifetime of the key in m_cache or m_pending.
+        interned_str        m_file;
         time_t              m_age;
         recognition         m_recognition;
         bool                m_outofdate;
@@ -293,13 +329,7 @@ void recognizer::clear()
 
     m_queue.clear();
 
-    for (auto iter = m_pending.begin(); iter != m_pending.end();)
-    {
-        char* key = iter->second.m_key;
-        iter = m_pending.erase(iter);
-        free(key);
-    }
-    assert(m_pending.empty());
+    m_pending.clear();
 
 #ifdef DEBUG
     const time_t threshold = 60/*secinmin*/ * 1/*minutes*/;
@@ -312,9 +342,7 @@ void recognizer::clear()
     {
         if (iter->second.m_age < age)
         {
-            char* key = iter->second.m_key;
             iter = m_cache.erase(iter);
-            free(key);
         }
         else
         {
@@ -507,19 +535,19 @@ bool recognizer::store(const char* word, const char* file, recognition cached, b
     auto const iter = map.find(word);
     if (iter != map.end())
     {
-        assert(iter->first == iter->second.m_key);
+        assert(iter->first == iter->second.m_key.c_str());
         entry.m_key = iter->second.m_key;
         map.insert_or_assign(iter->first, std::move(entry));
         set_result_available(true);
         return true;
     }
 
-    char* key = static_cast<char*>(malloc(strlen(word) + 1));
-    if (!key)
+    // The pending and cache maps share the interned key.
+    entry.m_key = word;
+    if (entry.m_key.empty())
         return false;
 
-    strcpy(key, word);
-    entry.m_key = key;
+    const char* key = entry.m_key.c_str();
     map.emplace(key, std::move(entry));
     set_result_available(true);
     return true;
@@ -23,9 +23,11 @@
 #include "line_queue.h"
 
 #include <core/base.h>
+#include <core/globber.h>
 #include <core/log.h>
 #include <core/path.h>
 #include <core/settings.h>
+#include <core/str_pool.h>
 #include <core/debugheap.h>
 #include <terminal/wcwidth.h>
 #include <terminal/printer.h>
@@ -2716,6 +2718,8 @@ void terminal_file::write(const char* chars, int32 length)
 
 //------------------------------------------------------------------------------
 extern void task_manager_diagnostics();
+extern void lua_entry_point_diagnostics();
+extern void lua_memory_diagnostics();
 static void do_clink_diagnostics(bool include_settings=false)
 {
     static char bold[] = "\x1b[1m";
@@ -2769,6 +2773,11 @@ static void do_clink_diagnostics(bool include_settings=false)
     print_value("session", t.c_str());
     print_value("profile", context.profile.c_str());
     print_value("log", file_logger::get_path());    // ACTUAL FILE IN USE.
+    if (const uint32 dropped = file_logger::get_dropped())
+    {
+        t.format("%u", dropped);
+        print_value("log dropped lines", t.c_str());
+    }
     print_value("default_settings", context.default_settings.c_str());
 
     settings::get_settings_file(t);
@@ -2828,9 +2837,60 @@ static void do_clink_diagnostics(bool include_settings=false)
         }
     }
 
+    // Directory listing cache.
+
+    if (has_explicit_nonzero_arg)
+    {
+        globber::cache_stats stats;
+        globber::get_cache_stats(stats);
+        if (stats.lookups)
+        {
+            print_heading("directory cache");
+
+            t.format("%u of %u (%u%%)", stats.hits, stats.lookups, uint32(uint64(stats.hits) * 100 / stats.lookups));
+            print_value("hits", t.c_str());
+            t.format("%u", stats.invalidations);
+            print_value("invalidations", t.c_str());
+            t.format("%u (%u files)", stats.directories, stats.files);
+            print_value("cached", t.c_str());
+        }
+
+        command_line_snapshot::stats snapshot_stats;
+        command_line_snapshot::get_stats(snapshot_stats);
+        if (snapshot_stats.built)
+        {
+            print_heading("command line snapshots");
+
+            t.format("%u", snapshot_stats.built);
+            print_value("built", t.c_str());
+            t.format("%u", snapshot_stats.reused);
+            print_value("reused", t.c_str());
+        }
+
+        str_pool::stats pool_stats;
+        str_pool::get().get_stats(pool_stats);
+        if (pool_stats.requests)
+        {
+            print_heading("interned strings");
+
+            t.format("%u (%llu KB)", pool_stats.live_strings, pool_stats.live_bytes / 1024);
+            print_value("in use", t.c_str());
+            t.format("%llu KB in %u generations", pool_stats.pooled_bytes / 1024, pool_stats.generations);
+            print_value("pooled", t.c_str());
+            t.format("%llu of %llu (%u%%)", pool_stats.hits, pool_stats.requests, uint32(pool_stats.hits * 100 / pool_stats.requests));
+            print_value("shared", t.c_str());
+            t.format("%.2f:1 (%llu KB requested, %llu KB stored)",
+                     pool_stats.stored_bytes ? double(pool_stats.requested_bytes) / double(pool_stats.stored_bytes) : 1.0,
+                     pool_stats.requested_bytes / 1024, pool_stats.stored_bytes / 1024);
+            print_value("dedup ratio", t.c_str());
+        }
+    }
+
     host_call_lua_rl_global_function("clink._diagnostics");
 
     task_manager_diagnostics();
+    lua_entry_point_diagnostics();
+    lua_memory_diagnostics();
 
     // Check for known potential ambiguous character width issues.
 
@@ -1357,30 +1357,6 @@ static char* filename_menu_completion_function(const char *text, int32 state)
     return nullptr;
 }
 
-//------------------------------------------------------------------------------
-static bool ensure_matches_size(char**& matches, int32 count, int32& reserved)
-{
-    count += 2;
-    if (count > reserved)
-    {
-        int32 new_reserve = 64;
-        while (new_reserve < count)
-        {
-            int32 prev = new_reserve;
-            new_reserve <<= 1;
-            if (new_reserve < prev)
-                return false;
-        }
-        char **new_matches = (char **)realloc(matches, new_reserve * sizeof(matches[0]));
-        if (!new_matches)
-            return false;
-
-        matches = new_matches;
-        reserved = new_reserve;
-    }
-    return true;
-}
-
 //------------------------------------------------------------------------------
 static void buffer_changing(int32 event)
 {
@@ -1564,28 +1540,15 @@ stop:
         end_prefix = (char*)text + 2;
     int32 len_prefix = end_prefix ? end_prefix - text : 0;
 
-    // Deep copy of the generated matches.  Inefficient, but this is how
+    // Copy the generated matches into a single packed arena, which is how
     // readline wants them.
-    str<32> lcd;
-    int32 count = 0;
-    int32 reserved = 0;
-    char** matches = nullptr;
-    if (!ensure_matches_size(matches, s_matches->get_match_count(), reserved))
+    packed_match_list_builder builder(s_matches->get_match_count());
+    if (!builder.set_lcd(text, end - start))
         return nullptr;
-    matches[0] = (char*)malloc((end - start) + 1);
-    memcpy(matches[0], text, end - start);
-    matches[0][(end - start)] = '\0';
     do
     {
         match_type type = iter.get_match_type();
 
-        ++count;
-        if (!ensure_matches_size(matches, count, reserved))
-        {
-            --count;
-            break;
-        }
-
         // PACKED MATCH FORMAT is:
         //  - N bytes:  MATCH (nul terminated char string)
         //  - 1 byte:   TYPE (uint8)
@@ -1613,28 +1576,23 @@ stop:
         const char* const match = iter.get_match();
         const char* const display = iter.get_match_display();
         const char* const description = iter.get_match_description();
-        const size_t packed_size = calc_packed_size(match, display, description);
-        char* ptr = (char*)malloc(packed_size);
-
-        matches[count] = ptr;
-
-        if (!pack_match(ptr, packed_size, match, type, display, description, iter.get_match_append_char(), flags))
-        {
-            --count;
-            free(ptr);
+        if (!builder.add(match, type, display, description, iter.get_match_append_char(), flags))
             continue;
-        }
 
 #ifdef DEBUG
         // Set DEBUG_MATCHES=-5 to print the first 5 matches.
+        const int32 count = builder.get_count();
         if (debug_matches > 0 || (debug_matches < 0 && count - 1 < 0 - debug_matches))
-            printf("%u: %s, %04.4x => %s\n", count - 1, match, type, matches[count]);
+            printf("%u: %s, %04.4x => %s\n", count - 1, match, type, match);
 #endif
     }
     while (iter.next());
-    matches[count + 1] = nullptr;
 
-    create_matches_lookaside(matches);
+    const int32 count = builder.get_count();
+    char** matches = builder.detach();
+    if (!matches)
+        return nullptr;
+
     update_rl_modes_from_matches(s_matches, iter, count);
 
     return matches;
@@ -20,6 +20,7 @@
 #include "rl_integration.h"
 #include "suggestions.h"
 #include "slash_translation.h"
+#include "fuzzy_match.h"
 #ifdef SHOW_VERT_SCROLLBARS
 #include "scroll_car.h"
 #endif
@@ -64,6 +65,15 @@ static setting_int g_preview_rows(
     "when the selection is moved past the preview rows.",
     5);
 
+static setting_bool g_select_fuzzy(
+    "match.select_fuzzy",
+    "Fuzzy filtering in clink-select-complete",
+    "When enabled, typing while 'clink-select-complete' is active keeps the\n"
+    "matches that contain the typed characters in order, but not necessarily\n"
+    "adjacent, and sorts the best matches first.  When disabled, typing keeps\n"
+    "the matches that start with the typed text.",
+    false);
+
 static setting_int g_max_rows(
     "match.max_rows",
     "Max rows in clink-select-complete",
@@ -1233,6 +1243,7 @@ stop:
     else
     {
         assert(m_matches.get_matches() == m_init_matches);
+        // This shares the match strings rather than duplicating them.
         m_data.copy(static_cast<const matches_impl&>(*m_matches.get_matches()));
         m_matches.set_alt_matches(&m_data, false/*own*/);
     }
@@ -1286,8 +1297,15 @@ void selectcomplete_impl::update_matches()
     else
     {
         match_pipeline pipeline(m_data);
-        pipeline.select(m_needle.c_str());
-        pipeline.sort();
+        if (g_select_fuzzy.get())
+        {
+            pipeline.select_fuzzy(m_needle.c_str());
+        }
+        else
+        {
+            pipeline.select(m_needle.c_str());
+            pipeline.sort();
+        }
     }
 
     m_clear_display = m_any_displayed;
@@ -1940,6 +1958,8 @@ void selectcomplete_impl::insert_match(int32 final)
     uint32 needle_len = 0;
     if (final)
     {
+        // This is only whether the match differs from the needle, which holds
+        // for fuzzy needles too.
         int32 nontrivial_lcd = __compare_match(const_cast<char*>(m_needle.c_str()), match);
 
         bool append_space = false;
@@ -2010,15 +2030,10 @@ void selectcomplete_impl::insert_match(int32 final)
     }
     else
     {
+        const int32 match_end = m_buffer->get_cursor();
         m_buffer->insert(qs);
         m_point = m_anchor + strlen(qs);
-        str_iter lhs(m_needle);
-        str_iter rhs(m_buffer->get_buffer() + m_point, m_buffer->get_length() - m_point);
-        const int32 cmp_len = str_compare(lhs, rhs);
-        if (cmp_len < 0)
-            needle_len = m_needle.length();
-        else if (cmp_len == m_needle.length())
-            needle_len = cmp_len;
+        needle_len = get_needle_len_in_match(m_needle.c_str(), m_buffer->get_buffer() + m_point, match_end - m_point, g_select_fuzzy.get());
     }
 
     m_point += needle_len;
@@ -2128,6 +2143,34 @@ bool activate_select_complete(editor_module::result& result, bool reactivate)
     return s_selectcomplete->activate(result, reactivate);
 }
 
+//------------------------------------------------------------------------------
+// Returns how many bytes of the inserted match TEXT the needle covers; the
+// cursor goes there, and the rest of the match is shown as the selection.  A
+// needle that's a prefix of the match covers its own length.  Otherwise a
+// fuzzy needle covers the match through the last character of the first
+// place it occurs as a subsequence.
+uint32 get_needle_len_in_match(const char* needle, const char* text, uint32 text_len, bool fuzzy)
+{
+    const uint32 needle_len = uint32(strlen(needle));
+
+    str_iter lhs(needle, needle_len);
+    str_iter rhs(text, text_len);
+    const int32 cmp_len = str_compare(lhs, rhs);
+    if (cmp_len < 0 || cmp_len == int32(needle_len))
+        return needle_len;
+
+    if (fuzzy)
+    {
+        fuzzy_matcher matcher;
+        matcher.set_needle(needle, str_compare_scope::current(), str_compare_scope::current_fuzzy_accents());
+        const int32 end = matcher.match_end(text, text_len);
+        if (end > 0)
+            return uint32(end);
+    }
+
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 bool point_in_select_complete(int32 in)
 {
@@ -122,5 +122,6 @@ private:
 };
 
 //------------------------------------------------------------------------------
+uint32 get_needle_len_in_match(const char* needle, const char* text, uint32 text_len, bool fuzzy);
 bool point_in_select_complete(int32 in);
 bool is_select_complete_active();
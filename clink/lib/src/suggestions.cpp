@@ -116,8 +116,7 @@ suggestions& suggestions::operator = (const suggestions& other)
 {
     clear();
     m_line = other.m_line.c_str();
-    for (const auto& s : other.m_items)
-        add(s.m_suggestion.c_str(), s.m_suggestion_offset, s.m_source.c_str(), s.m_highlight_offset, s.m_highlight_length, s.m_tooltip.c_str(), s.m_history_index);
+    m_items = other.m_items; // Shares the interned strings.
     m_generation_id = other.m_generation_id;
     m_dirtied = other.m_dirtied;
     return *this;
@@ -526,7 +525,7 @@ malformed:
     }
     else
     {
-        new (&m_iter) str_iter(m_suggestions[0].m_suggestion);
+        new (&m_iter) str_iter(m_suggestions[0].m_suggestion.c_str(), m_suggestions[0].m_suggestion.length());
 
         // Do not allow relaxed comparison for suggestions, as it is too
         // confusing, as a result of the logic to respect original case.
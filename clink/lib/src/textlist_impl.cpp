@@ -36,6 +36,8 @@
 #include <signal.h>
 #include <shellapi.h>
 
+#include <algorithm>
+
 extern "C" {
 #include <readline/readline.h>
 #include <readline/rlprivate.h>
@@ -86,8 +88,10 @@ static setting_enum g_popup_search_mode(
     "clink.popup_search_mode",
     "Default search mode in popup lists",
     "When this is 'find', typing in popup lists moves to the next matching item.\n"
-    "When this is 'filter', typing in popup lists filters the list.",
-    "find,filter",
+    "When this is 'filter', typing in popup lists filters the list.\n"
+    "When this is 'fuzzy', typing in popup lists filters the list to fuzzy\n"
+    "matches and sorts them by how well they match.",
+    "find,filter,fuzzy",
     0);
 
 static setting_enum g_popup_delete_direction(
@@ -152,6 +156,20 @@ static int32 make_item(const char* in, str_base& out)
     return cells;
 }
 
+//------------------------------------------------------------------------------
+// Returns the number of cells make_item() would produce, without building the
+// text.
+static int32 measure_item(const char* in)
+{
+    int32 cells = 0;
+    for (wcwidth_iter iter(in); iter.next();)
+    {
+        const int32 width = iter.character_wcwidth_signed();
+        cells += (width < 0) ? 2 : width;
+    }
+    return cells;
+}
+
 //------------------------------------------------------------------------------
 static int32 make_column(const char* in, const char* end, str_base& out)
 {
@@ -411,17 +429,50 @@ const char* textlist_impl::addl_columns::add_entry(const char* ptr)
 void textlist_impl::addl_columns::add_columns(const char* ptr)
 {
     column_text column_text = {};
+    make_columns(ptr, column_text);
+    m_rows.emplace_back(std::move(column_text));
+}
+
+//------------------------------------------------------------------------------
+void textlist_impl::addl_columns::defer_rows(int32 count)
+{
+    // Rows are filled in later by set_columns().
+    m_rows.resize(m_rows.size() + count, column_text());
+}
+
+//------------------------------------------------------------------------------
+void textlist_impl::addl_columns::set_columns(int32 row, const char* ptr)
+{
+    assert(row >= 0 && row < m_rows.size());
+    make_columns(ptr, m_rows[row]);
+}
+
+//------------------------------------------------------------------------------
+void textlist_impl::addl_columns::pin_widths(const char* ptr)
+{
+    // The widths come from a representative row, and don't change as the
+    // deferred rows are filled in by set_columns().
+    column_text sample;
+    make_columns(ptr, sample);
+    m_pinned = true;
+}
+
+//------------------------------------------------------------------------------
+void textlist_impl::addl_columns::make_columns(const char* ptr, column_text& out)
+{
+    out = {};
     if (*ptr)
     {
         str<> tmp;
         int32 col = 0;
         bool any_tabs = false;
-        while (col < sizeof_array(column_text.column))
+        while (col < sizeof_array(out.column))
         {
             const char* tab = strchr(ptr, '\t');
             const int32 cells = make_column(ptr, tab, tmp);
-            column_text.column[col] = m_store.add(tmp.c_str());
-            m_longest[col] = max<int32>(m_longest[col], cells);
+            out.column[col] = m_store.add(tmp.c_str());
+            if (!m_pinned)
+                m_longest[col] = max<int32>(m_longest[col], cells);
             ptr = tab;
             if (!ptr)
                 break;
@@ -429,10 +480,9 @@ void textlist_impl::addl_columns::add_columns(const char* ptr)
             col++;
             ptr++;
         }
-        m_any_tabs |= any_tabs;
+        if (!m_pinned)
+            m_any_tabs |= any_tabs;
     }
-
-    m_rows.emplace_back(std::move(column_text));
 }
 
 //------------------------------------------------------------------------------
@@ -519,6 +569,7 @@ void textlist_impl::addl_columns::clear()
     memset(&m_longest, 0, sizeof(m_longest));
     memset(&m_layout_width, 0, sizeof(m_longest));
     m_any_tabs = false;
+    m_pinned = false;
 }
 
 
@@ -570,7 +621,9 @@ popup_results textlist_impl::activate(const char* title, const char** entries, i
     m_mode = mode;
     m_history_mode = is_history_mode(mode);
     m_was_default_search_mode = (!config || config->search_mode < 0);
-    m_filter = (m_was_default_search_mode ? s_default_popup_search_mode : config->search_mode) > 0;
+    const int32 search_mode = (m_was_default_search_mode ? s_default_popup_search_mode : config->search_mode);
+    m_filter = search_mode > 0;
+    m_fuzzy = search_mode == 2;
     m_show_numbers = m_history_mode;
     m_win_history = (mode == textlist_mode::win_history);
     m_del_callback = config ? config->del_callback : nullptr;
@@ -601,11 +654,9 @@ popup_results textlist_impl::activate(const char* title, const char** entries, i
     const bool history_timestamps = (m_history_mode &&
         ((g_history_timestamp.get() == 2 && (!rl_explicit_arg || rl_numeric_arg)) ||
          (g_history_timestamp.get() == 1 && rl_explicit_arg && rl_numeric_arg)));
-    const HIST_ENTRY* const* const histlist = history_list();
     assertimplies(history_timestamps, !has_columns);
-    history_timeformatter timeformatter;
     if (history_timestamps)
-        timeformatter.set_timeformat(nullptr, true);
+        m_timeformatter.set_timeformat(nullptr, true);
 
 #ifdef USE_MEMORY_TRACKING
     sane_alloc_config sane = dbggetsaneallocconfig();
@@ -614,34 +665,7 @@ popup_results textlist_impl::activate(const char* title, const char** entries, i
 #endif
 
     // Gather the items.
-    str<> tmp;
-    str<> tmp2;
-    for (int32 i = 0; i < count; i++)
-    {
-        const char* text;
-        if (has_columns)
-            text = m_columns.add_entry(m_entries[i]);
-        else
-        {
-            text = m_entries[i];
-            if (history_timestamps)
-            {
-                const int32 j = m_infos ? m_infos[i].index : i;
-                const char* timestamp = histlist[j]->timestamp;
-                tmp2.clear();
-                if (timestamp && *timestamp)
-                {
-                    const time_t tt = time_t(atoi(timestamp));
-                    timeformatter.format(tt, tmp);
-                    tmp2.format("%-*s\t", timeformatter.max_timelen(), tmp.c_str());
-                }
-                m_columns.add_columns(tmp2.c_str());
-            }
-        }
-        m_longest = max<int32>(m_longest, make_item(text, tmp));
-        m_items.push_back(m_store.add(tmp.c_str()));
-    }
-    m_has_columns = has_columns || history_timestamps;
+    init_items(has_columns, history_timestamps);
 
     if (title && *title)
         m_default_title = title;
@@ -983,25 +1007,7 @@ find:
 
             // Remove the item from the popup list.
             const int32 old_rows = min<int32>(m_visible_rows, m_count);
-            int32 move_count = (m_original_count - 1) - original_index;
-            memmove(m_entries + original_index, m_entries + original_index + 1, move_count * sizeof(m_entries[0]));
-            m_items.erase(m_items.begin() + original_index);
-            if (m_has_columns)
-                m_columns.erase_row(original_index);
-            if (m_infos)
-            {
-                memmove(m_infos + original_index, m_infos + original_index + 1, move_count * sizeof(m_infos[0]));
-                for (int32 i = m_original_count - 1; i-- > original_index;)
-                    m_infos[i].index--;
-            }
-            if (!m_filtered_items.empty())
-            {
-                m_filtered_items.erase(m_filtered_items.begin() + m_index);
-                for (int32 i = m_count - 1; i-- > m_index;)
-                    m_filtered_items[i]--;
-            }
-            m_count--;
-            m_original_count--;
+            remove_item(m_index);
             if (!m_original_count)
             {
                 cancel(popup_result::cancel);
@@ -1185,9 +1191,11 @@ do_insert:
         {
             if (m_filter)
                 clear_filter();
-            m_filter = !m_filter;
+            // Cycle find -> filter -> fuzzy -> find.
+            m_fuzzy = m_filter && !m_fuzzy;
+            m_filter = !m_filter || m_fuzzy;
             if (m_was_default_search_mode)
-                s_default_popup_search_mode = m_filter ? 1 : 0;
+                s_default_popup_search_mode = m_fuzzy ? 2 : m_filter ? 1 : 0;
             need_display = true;
             goto update_needle;
         }
@@ -1277,7 +1285,7 @@ update_needle:
                 advance_before_find = false;
                 m_override_title.clear();
                 if (m_needle.length())
-                    m_override_title.format("%s: %-10s", m_filter ? "filter" : "find", m_needle.c_str());
+                    m_override_title.format("%s: %-10s", m_fuzzy ? "fuzzy" : m_filter ? "filter" : "find", m_needle.c_str());
                 if (m_needle_not_found)
                 {
                     assert(!m_filter);
@@ -1590,6 +1598,16 @@ void textlist_impl::update_display()
         {
             update_top();
 
+            // The width was sampled when the popup opened; if a visible row
+            // is wider then the layout must be redone.
+            for (int32 i = m_top, end = min<int32>(count, m_top + m_visible_rows); i < end; ++i)
+                materialize_item(get_original_index(i));
+            if (m_widths_changed)
+            {
+                m_widths_changed = false;
+                m_prev_displayed = -1;
+            }
+
             const bool draw_border = (m_prev_displayed < 0) || m_override_title.length() || m_has_override_title;
             m_has_override_title = !m_override_title.empty();
 
@@ -1940,7 +1958,7 @@ bool textlist_impl::do_find(int32 direction, const bool from_begin, const bool a
                 if (m_has_columns)
                 {
                     for (int32 col = 0; !match && col < max_columns; col++)
-                        match = strstr_compare(m_needle, m_columns.get_col_text(i, col));
+                        match = strstr_compare(m_needle, get_col_text(i, col));
                 }
             }
 
@@ -2068,6 +2086,11 @@ void textlist_impl::reset()
     m_items = std::move(std::vector<const char*>());
     m_longest = 0;
     m_columns.clear();
+    m_timestamps = false;
+    m_widths_changed = false;
+    m_filter_index.clear();
+    m_fuzzy_masks = std::move(std::vector<uint64>());
+    m_fuzzy_masks_key = -1;
 
     m_filter_string.clear();
     m_filter_saved_index = -1;
@@ -2109,19 +2132,153 @@ int32 textlist_impl::get_original_index(int32 index) const
 }
 
 //------------------------------------------------------------------------------
-const char* textlist_impl::get_item_text(int32 index) const
+void textlist_impl::init_items(bool has_columns, bool history_timestamps)
 {
-    if (!m_filter_string.empty())
-        index = m_filtered_items[index];
-    return m_items[index];
+    if (has_columns)
+    {
+        str<> tmp;
+        for (int32 i = 0; i < m_count; i++)
+        {
+            const char* text = m_columns.add_entry(m_entries[i]);
+            m_longest = max<int32>(m_longest, make_item(text, tmp));
+            m_items.push_back(m_store.add(tmp.c_str()));
+        }
+    }
+    else
+    {
+        // Rows are materialized only as they're displayed or searched, so
+        // that opening a popup with a huge history list is fast.  The width
+        // comes from a bounded sample of rows, and grows as more rows are
+        // materialized.
+        const int32 c_eager_rows = 2000;
+        const int32 c_sample_rows = 1000;
+        m_items.resize(m_count, nullptr);
+        const int32 stride = (m_count <= c_eager_rows) ? 1 : m_count / c_sample_rows;
+        for (int32 i = m_count; i > 0;)
+        {
+            i -= stride;
+            m_longest = max<int32>(m_longest, measure_item(m_entries[max<int32>(i, 0)]));
+        }
+        m_widths_changed = false;
+
+        // Every timestamp is padded to the same width, so the first one is
+        // representative of all of them.
+        m_timestamps = history_timestamps;
+        if (history_timestamps)
+        {
+            m_columns.defer_rows(m_count);
+            str<> tmp;
+            for (int32 i = 0; i < m_count; i++)
+            {
+                if (format_timestamp(i, tmp))
+                {
+                    m_columns.pin_widths(tmp.c_str());
+                    break;
+                }
+            }
+        }
+    }
+    m_has_columns = has_columns || history_timestamps;
 }
 
 //------------------------------------------------------------------------------
-const char* textlist_impl::get_col_text(int32 index, int32 col) const
+bool textlist_impl::format_timestamp(int32 original_index, str_base& out)
 {
-    if (!m_filter_string.empty())
-        index = m_filtered_items[index];
-    return m_columns.get_col_text(index, col);
+    out.clear();
+
+    const HIST_ENTRY* const* const histlist = history_list();
+    const int32 j = m_infos ? m_infos[original_index].index : original_index;
+    const char* timestamp = (j >= 0 && j < history_length) ? histlist[j]->timestamp : nullptr;
+    if (!timestamp || !*timestamp)
+        return false;
+
+    str<> tmp;
+    const time_t tt = time_t(atoi(timestamp));
+    m_timeformatter.format(tt, tmp);
+    out.format("%-*s\t", m_timeformatter.max_timelen(), tmp.c_str());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void textlist_impl::remove_item(int32 index)
+{
+    assert(index >= 0 && index < m_count);
+    const int32 original_index = get_original_index(index);
+    int32 move_count = (m_original_count - 1) - original_index;
+    memmove(m_entries + original_index, m_entries + original_index + 1, move_count * sizeof(m_entries[0]));
+    m_items.erase(m_items.begin() + original_index);
+    m_filter_index.clear();
+    m_fuzzy_masks.clear();
+    if (m_has_columns)
+        m_columns.erase_row(original_index);
+    if (m_infos)
+    {
+        memmove(m_infos + original_index, m_infos + original_index + 1, move_count * sizeof(m_infos[0]));
+        for (int32 i = m_original_count - 1; i-- > original_index;)
+            m_infos[i].index--;
+    }
+    if (!m_filtered_items.empty())
+    {
+        // Fuzzy filtering orders the items by score, so any of them may
+        // follow the deleted item.
+        m_filtered_items.erase(m_filtered_items.begin() + index);
+        for (int32& filtered_index : m_filtered_items)
+        {
+            if (filtered_index > original_index)
+                filtered_index--;
+        }
+    }
+    m_count--;
+    m_original_count--;
+}
+
+//------------------------------------------------------------------------------
+void textlist_impl::materialize_item(int32 original_index)
+{
+    assert(original_index >= 0 && original_index < m_items.size());
+    if (m_items[original_index])
+        return;
+
+    str<> tmp;
+    const int32 cells = make_item(m_entries[original_index], tmp);
+    m_items[original_index] = m_store.add(tmp.c_str());
+    if (m_longest < cells)
+    {
+        m_longest = cells;
+        m_widths_changed = true;
+    }
+
+    if (m_timestamps)
+    {
+        format_timestamp(original_index, tmp);
+        m_columns.set_columns(original_index, tmp.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------
+const char* textlist_impl::get_original_text(int32 original_index)
+{
+    materialize_item(original_index);
+    return m_items[original_index];
+}
+
+//------------------------------------------------------------------------------
+const char* textlist_impl::get_original_col_text(int32 original_index, int32 col)
+{
+    materialize_item(original_index);
+    return m_columns.get_col_text(original_index, col);
+}
+
+//------------------------------------------------------------------------------
+const char* textlist_impl::get_item_text(int32 index)
+{
+    return get_original_text(get_original_index(index));
+}
+
+//------------------------------------------------------------------------------
+const char* textlist_impl::get_col_text(int32 index, int32 col)
+{
+    return get_original_col_text(get_original_index(index), col);
 }
 
 //------------------------------------------------------------------------------
@@ -2187,47 +2344,86 @@ bool textlist_impl::filter_items()
         return true;
     };
 
-    // Build new filtered list.
+    const bool fuzzy_accents = g_fuzzy_accent.get();
+    const bool refine = (!m_filter_string.empty() && strncmp(m_needle.c_str(), m_filter_string.c_str(), m_filter_string.length()) == 0);
+
     std::vector<int32> filtered_items;
-    if (!m_filter_string.empty() && strncmp(m_needle.c_str(), m_filter_string.c_str(), m_filter_string.length()) == 0)
+    if (m_fuzzy)
+    {
+        auto interrupted = [&]() {
+            return !defer_test-- && test_input();
+        };
+        if (!rank_fuzzy_items(refine, mode, fuzzy_accents, interrupted, filtered_items))
+            return false;
+    }
+    else
     {
-        // Further filter the filtered list.
-        for (size_t i = 0; i < m_filtered_items.size(); ++i)
+        // Index the rows the first time filtering needs them.  Building the
+        // index can be interrupted, and resumes where it left off.
+        if (!m_filter_index.is_built_for(mode, fuzzy_accents))
+            m_filter_index.begin(mode, fuzzy_accents);
+        while (m_filter_index.get_row_count() < int32(m_items.size()))
         {
             // Interrupt if more input is available.
             if (!defer_test-- && test_input())
                 return false;
 
-            const int32 original_index = m_filtered_items[i];
-
-            bool match = m_needle.empty() || strstr_compare(m_needle, m_items[original_index]);
+            const int32 row = m_filter_index.get_row_count();
+            m_filter_index.add_row();
+            m_filter_index.add_text(get_original_text(row));
             if (m_has_columns)
             {
-                for (int32 col = 0; !match && col < max_columns; col++)
-                    match = strstr_compare(m_needle, m_columns.get_col_text(original_index, col));
+                for (int32 col = 0; col < max_columns; col++)
+                {
+                    const char* col_text = get_original_col_text(row, col);
+                    if (col_text)
+                        m_filter_index.add_text(col_text);
+                }
             }
+        }
 
-            if (match)
-                filtered_items.push_back(original_index);
+        // The index narrows the rows to candidates that contain every
+        // trigram in the needle; short needles still test every row.  Either
+        // way the rows stay in their original order.
+        std::vector<int32> candidates;
+        const bool use_candidates = m_filter_index.get_candidates(m_needle.c_str(), candidates);
+        if (refine)
+        {
+            // Further filter the filtered list.
+            if (use_candidates)
+            {
+                std::vector<int32> tmp;
+                std::set_intersection(m_filtered_items.begin(), m_filtered_items.end(), candidates.begin(), candidates.end(), std::back_inserter(tmp));
+                candidates = std::move(tmp);
+            }
+            else
+            {
+                candidates = m_filtered_items;
+            }
         }
-    }
-    else
-    {
-        for (size_t i = 0; i < m_items.size(); ++i)
+        else if (!use_candidates)
+        {
+            candidates.resize(m_items.size());
+            for (size_t i = 0; i < candidates.size(); ++i)
+                candidates[i] = int32(i);
+        }
+
+        // Build new filtered list.
+        for (const int32 original_index : candidates)
         {
             // Interrupt if more input is available.
             if (!defer_test-- && test_input())
                 return false;
 
-            bool match = m_needle.empty() || strstr_compare(m_needle, m_items[i]);
+            bool match = strstr_compare(m_needle, get_original_text(original_index));
             if (m_has_columns)
             {
                 for (int32 col = 0; !match && col < max_columns; col++)
-                    match = strstr_compare(m_needle, m_columns.get_col_text(i, col));
+                    match = strstr_compare(m_needle, get_original_col_text(original_index, col));
             }
 
             if (match)
-                filtered_items.push_back(int32(i));
+                filtered_items.push_back(original_index);
         }
     }
 
@@ -2262,6 +2458,127 @@ bool textlist_impl::filter_items()
     return true;
 }
 
+//------------------------------------------------------------------------------
+bool textlist_impl::rank_fuzzy_items(bool refine, int32 mode, bool fuzzy_accents, const std::function<bool()>& interrupted, std::vector<int32>& out)
+{
+    // Only this many of the best matches are sorted by score.  The rest
+    // follow in their original order; they're far past anything that's
+    // likely to be looked at.
+    const size_t c_ranked_rows = 1000;
+    // In history mode, newer entries get up to this much extra score.
+    const int32 c_bonus_recency = 8;
+
+    m_fuzzy_matcher.set_needle(m_needle.c_str(), mode, fuzzy_accents);
+
+    const int32 masks_key = mode * 2 + fuzzy_accents;
+    if (m_fuzzy_masks_key != masks_key || m_fuzzy_masks.size() != m_items.size())
+    {
+        m_fuzzy_masks.clear();
+        m_fuzzy_masks.resize(m_items.size(), 0);
+        m_fuzzy_masks_key = masks_key;
+    }
+
+    // When the needle grows, only the previous matches can still match.
+    std::vector<int32> candidates;
+    if (refine)
+    {
+        candidates = m_filtered_items;
+        std::sort(candidates.begin(), candidates.end());
+    }
+    else
+    {
+        candidates.resize(m_items.size());
+        for (size_t i = 0; i < candidates.size(); ++i)
+            candidates[i] = int32(i);
+    }
+
+    struct ranked
+    {
+        int32 score;
+        int32 index;
+    };
+
+    const int32 count = int32(m_items.size());
+    std::vector<ranked> matches;
+    for (const int32 original_index : candidates)
+    {
+        // Interrupt if more input is available.
+        if (interrupted())
+            return false;
+
+        // Reject rows missing any of the needle's characters without
+        // scoring them.
+        uint64& mask = m_fuzzy_masks[original_index];
+        if (!mask)
+        {
+            mask = m_fuzzy_matcher.get_mask(get_original_text(original_index));
+            if (m_has_columns)
+            {
+                for (int32 col = 0; col < max_columns; col++)
+                {
+                    const char* col_text = get_original_col_text(original_index, col);
+                    if (col_text)
+                        mask |= m_fuzzy_matcher.get_mask(col_text);
+                }
+            }
+        }
+        if (!m_fuzzy_matcher.may_match(mask))
+            continue;
+
+        int32 score = m_fuzzy_matcher.score(get_original_text(original_index));
+        if (m_has_columns)
+        {
+            for (int32 col = 0; col < max_columns; col++)
+            {
+                const char* col_text = get_original_col_text(original_index, col);
+                if (col_text)
+                    score = max<int32>(score, m_fuzzy_matcher.score(col_text));
+            }
+        }
+        if (score == fuzzy_matcher::no_match)
+            continue;
+
+        if (m_history_mode)
+            score += int32((int64(c_bonus_recency) * original_index) / count);
+        matches.push_back({ score, original_index });
+    }
+
+    // Ties prefer the items nearest where the list starts.
+    const bool reverse = m_reverse;
+    auto better = [reverse](const ranked& a, const ranked& b) {
+        if (a.score != b.score)
+            return a.score > b.score;
+        return reverse ? a.index > b.index : a.index < b.index;
+    };
+
+    size_t ranked_count = matches.size();
+    if (ranked_count > c_ranked_rows)
+    {
+        // Find the worst of the top matches in linear time, then move the
+        // top matches to the front without disturbing the original order of
+        // the rest.
+        std::vector<ranked> tmp(matches);
+        std::nth_element(tmp.begin(), tmp.begin() + (c_ranked_rows - 1), tmp.end(), better);
+        const ranked pivot = tmp[c_ranked_rows - 1];
+        std::stable_partition(matches.begin(), matches.end(), [&](const ranked& r) {
+            return !better(pivot, r);
+        });
+        ranked_count = c_ranked_rows;
+        if (reverse)
+            std::reverse(matches.begin() + ranked_count, matches.end());
+    }
+    std::sort(matches.begin(), matches.begin() + ranked_count, better);
+
+    // The best match goes where the list starts.
+    out.clear();
+    out.reserve(matches.size());
+    for (const ranked& r : matches)
+        out.push_back(r.index);
+    if (reverse)
+        std::reverse(out.begin(), out.end());
+    return true;
+}
+
 
 
 //------------------------------------------------------------------------------
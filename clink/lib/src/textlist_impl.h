@@ -4,12 +4,16 @@
 #pragma once
 
 #include "editor_module.h"
+#include "fuzzy_match.h"
+#include "history_timeformatter.h"
 #include "input_dispatcher.h"
 #include "popup.h"
 #include "scroll_helper.h"
+#include "trigram_index.h"
 
 #include <core/str.h>
 
+#include <functional>
 #include <vector>
 
 class printer;
@@ -30,6 +34,7 @@ inline bool is_history_mode(textlist_mode mode) { return mode == textlist_mode::
 class textlist_impl
     : public editor_module
 {
+    friend struct test_textlist;
     class item_store;
 
     enum
@@ -51,16 +56,21 @@ class textlist_impl
         int32       get_col_layout_width(int32 col) const;
         const char* add_entry(const char* entry);
         void        add_columns(const char* columns);
+        void        defer_rows(int32 count);
+        void        set_columns(int32 row, const char* columns);
+        void        pin_widths(const char* columns);
         void        erase_row(int32 row);
         int32       calc_widths(int32 available);
         bool        get_any_tabs() const;
         void        clear();
     private:
+        void        make_columns(const char* columns, column_text& out);
         textlist_impl::item_store& m_store;
         std::vector<column_text> m_rows;
         int32       m_longest[max_columns] = {};
         int32       m_layout_width[max_columns] = {};
         bool        m_any_tabs = false;
+        bool        m_pinned = false;
     };
 
 public:
@@ -93,13 +103,22 @@ private:
     void            init_colors(const popup_config* config);
     void            reset();
 
+    // Rows are materialized on demand.
+    void            init_items(bool has_columns, bool history_timestamps);
+    bool            format_timestamp(int32 original_index, str_base& out);
+    void            materialize_item(int32 original_index);
+    const char*     get_original_text(int32 original_index);
+    const char*     get_original_col_text(int32 original_index, int32 col);
+
     // Filtering.
     int32           get_original_index(int32 index) const;
-    const char*     get_item_text(int32 index) const;
-    const char*     get_col_text(int32 index, int32 col) const;
+    const char*     get_item_text(int32 index);
+    const char*     get_col_text(int32 index, int32 col);
     const entry_info& get_item_info(int32 index) const;
     void            clear_filter();
+    void            remove_item(int32 index);
     bool            filter_items();
+    bool            rank_fuzzy_items(bool refine, int32 mode, bool fuzzy_accents, const std::function<bool()>& interrupted, std::vector<int32>& out);
 
     // Result.
     popup_results   m_results;
@@ -140,9 +159,12 @@ private:
     int32           m_count = 0;
     const char**    m_entries = nullptr;    // Original entries from caller.
     entry_info*     m_infos = nullptr;      // Original entry numbers/etc from caller.
-    std::vector<const char*> m_items;       // Escaped entries for display.
+    std::vector<const char*> m_items;       // Escaped entries for display (nullptr until materialized).
     int32           m_longest = 0;
     addl_columns    m_columns;
+    history_timeformatter m_timeformatter;
+    bool            m_timestamps = false;   // Materializing a row formats its timestamp.
+    bool            m_widths_changed = false; // Materializing rows found longer text.
 
     // Filtering.
     str_moveable    m_filter_string;
@@ -150,6 +172,10 @@ private:
     int32           m_filter_saved_top = -1;
     int32           m_original_count = 0;   // Original count of items from caller.
     std::vector<int32> m_filtered_items;    // Maps filtered index to original index.
+    trigram_index   m_filter_index;         // Built when filtering starts.
+    fuzzy_matcher   m_fuzzy_matcher;
+    std::vector<uint64> m_fuzzy_masks;      // Per original index; 0 until computed.
+    int32           m_fuzzy_masks_key = -1; // Compare mode the masks were computed for.
 
     // Display.
     int32           m_prev_content_width = 0;
@@ -182,6 +208,7 @@ private:
     bool            m_history_mode = false;
     bool            m_was_default_search_mode = false;
     bool            m_filter = false;
+    bool            m_fuzzy = false;        // Filter ranks fuzzy matches.
     bool            m_show_numbers = false;
     bool            m_win_history = false;
     bool            m_has_columns = false;
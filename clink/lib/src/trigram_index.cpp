@@ -0,0 +1,140 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "trigram_index.h"
+
+#include <core/base.h>
+#include <core/str_compare.h>
+#include <core/str_iter.h>
+
+#include <algorithm>
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+void trigram_index::clear()
+{
+    std::unordered_map<uint64, std::vector<int32>> zap;
+    m_postings = std::move(zap);
+    m_rows = 0;
+    m_mode = -1;
+    m_fuzzy_accents = false;
+}
+
+//------------------------------------------------------------------------------
+void trigram_index::begin(int32 mode, bool fuzzy_accents)
+{
+    clear();
+    m_mode = mode;
+    m_fuzzy_accents = fuzzy_accents;
+}
+
+//------------------------------------------------------------------------------
+bool trigram_index::is_built_for(int32 mode, bool fuzzy_accents) const
+{
+    return m_mode == mode && m_fuzzy_accents == fuzzy_accents;
+}
+
+//------------------------------------------------------------------------------
+void trigram_index::add_row()
+{
+    assert(m_mode >= 0);
+    ++m_rows;
+}
+
+//------------------------------------------------------------------------------
+// Adds TEXT to the row most recently started by add_row().  A row can have
+// several texts (e.g. additional columns).
+void trigram_index::add_text(const char* text)
+{
+    assert(m_rows > 0);
+    const int32 row = m_rows - 1;
+    for_each_trigram(text, [&](uint64 key) {
+        std::vector<int32>& rows = m_postings[key];
+        if (rows.empty() || rows.back() != row)
+            rows.push_back(row);
+    });
+}
+
+//------------------------------------------------------------------------------
+// Returns false if NEEDLE is too short to narrow the search; the caller must
+// then test every row.  Otherwise OUT receives the candidate rows, in
+// ascending order.
+bool trigram_index::get_candidates(const char* needle, std::vector<int32>& out) const
+{
+    out.clear();
+
+    std::vector<uint64> keys;
+    for_each_trigram(needle, [&](uint64 key) {
+        keys.push_back(key);
+    });
+    if (keys.empty())
+        return false;
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    // Intersect starting from the shortest posting list, so the candidate
+    // set shrinks as quickly as possible.
+    std::vector<const std::vector<int32>*> lists;
+    for (uint64 key : keys)
+    {
+        const auto iter = m_postings.find(key);
+        if (iter == m_postings.end())
+            return true;
+        lists.push_back(&iter->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const std::vector<int32>* a, const std::vector<int32>* b) {
+        return a->size() < b->size();
+    });
+
+    out = *lists[0];
+    std::vector<int32> tmp;
+    for (size_t i = 1; i < lists.size() && !out.empty(); ++i)
+    {
+        tmp.clear();
+        std::set_intersection(out.begin(), out.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(tmp));
+        out.swap(tmp);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Must stay consistent with str_compare_impl().
+int32 trigram_index::fold(int32 c) const
+{
+    if (m_mode > str_compare_scope::exact)
+        c = (c > 0xffff) ? c : int32(uintptr_t(CharLowerW(LPWSTR(uintptr_t(c)))));
+    if (m_mode > str_compare_scope::caseless && c == '-')
+        c = '_';
+    if (c == '\\')
+        c = '/';
+    if (m_fuzzy_accents)
+        c = normalize_accent(c);
+    return c;
+}
+
+//------------------------------------------------------------------------------
+template <typename F>
+void trigram_index::for_each_trigram(const char* text, F&& func) const
+{
+    // Consecutive path separators compare equal to a single separator, so
+    // runs are collapsed.
+    uint64 key = 0;
+    int32 len = 0;
+    bool prev_sep = false;
+    str_iter iter(text);
+    while (int32 c = iter.next())
+    {
+        c = fold(c);
+        const bool sep = (c == '/');
+        if (sep && prev_sep)
+            continue;
+        prev_sep = sep;
+
+        // Codepoints fit in 21 bits, so three fit in a uint64.
+        key = ((key << 21) | uint64(c & 0x1fffff)) & ((uint64(1) << 63) - 1);
+        if (++len >= 3)
+            func(key);
+    }
+}
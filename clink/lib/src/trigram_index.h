@@ -0,0 +1,35 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Index of the character trigrams in a list of rows, for narrowing substring
+// searches.  Characters are folded the same way str_compare() folds them for
+// the str_compare_scope mode and fuzzy accent setting the index was built
+// with, so every row that str_compare() can match is among the candidates.
+// Candidates still need to be verified with the real comparison.
+class trigram_index
+{
+public:
+    void            clear();
+    void            begin(int32 mode, bool fuzzy_accents);
+    bool            is_built_for(int32 mode, bool fuzzy_accents) const;
+    int32           get_row_count() const { return m_rows; }
+    void            add_row();
+    void            add_text(const char* text);
+    bool            get_candidates(const char* needle, std::vector<int32>& out) const;
+
+private:
+    int32           fold(int32 c) const;
+    template <typename F>
+    void            for_each_trigram(const char* text, F&& func) const;
+
+    std::unordered_map<uint64, std::vector<int32>> m_postings; // Rows in ascending order.
+    int32           m_rows = 0;
+    int32           m_mode = -1;
+    bool            m_fuzzy_accents = false;
+};
@@ -555,6 +555,41 @@ void command_line_states::set(const line_buffer& buffer,
     set(buffer.get_buffer(), buffer.get_length(), buffer.get_cursor(), words, mode, commands);
 }
 
+//------------------------------------------------------------------------------
+void command_line_states::set(const char* line_buffer, const line_states& lines)
+{
+    clear_internal();
+
+    if (lines.empty())
+    {
+        clear();
+        return;
+    }
+
+    // Pre-allocate words_storage so that emplace_back() doesn't invalidate
+    // pointers (references) stored in linestates.
+    m_words_storage.reserve(lines.size());
+
+    for (const auto& line : lines)
+    {
+        m_words_storage.emplace_back(line.get_words());
+        m_linestates.emplace_back(std::move(line_state(
+            line_buffer,
+            line.get_length(),
+            line.get_cursor(),
+            line.get_words_limit(),
+            line.get_command_offset(),
+            line.get_range_offset(),
+            line.get_range_length(),
+            m_words_storage.back()
+        )));
+    }
+
+    // Guarantee room for get_word_break_info() to append an empty end word.
+    ::words& last = m_words_storage.back();
+    last.reserve(last.size() + 1);
+}
+
 //------------------------------------------------------------------------------
 uint32 command_line_states::break_end_word(uint32 truncate, uint32 keep, bool discard)
 {
@@ -742,3 +777,61 @@ const line_state& command_line_states::get_linestate(const line_buffer& buffer)
 {
     return get_linestate(buffer.get_buffer(), buffer.get_length());
 }
+
+
+
+//------------------------------------------------------------------------------
+static command_line_snapshot::stats s_snapshot_stats = {};
+
+//------------------------------------------------------------------------------
+command_line_snapshot::command_line_snapshot(const line_states& lines)
+{
+    if (!lines.empty() && lines.front().get_line())
+        m_line.concat(lines.front().get_line(), lines.front().get_length());
+    m_states.set(m_line.c_str(), lines);
+    ++s_snapshot_stats.built;
+}
+
+//------------------------------------------------------------------------------
+bool command_line_snapshot::is_line(const char* line, uint32 length) const
+{
+    return (length == m_line.length() && memcmp(line, m_line.c_str(), length) == 0);
+}
+
+//------------------------------------------------------------------------------
+const line_states& command_line_snapshot::get_linestates() const
+{
+    return m_states.get_linestates(m_line.c_str(), m_line.length());
+}
+
+//------------------------------------------------------------------------------
+const line_state& command_line_snapshot::get_linestate() const
+{
+    return m_states.get_linestate(m_line.c_str(), m_line.length());
+}
+
+//------------------------------------------------------------------------------
+const line_state& command_line_snapshot::get_hinter_linestate() const
+{
+    // The hinter needs the last command split at the cursor; build that the
+    // first time it's needed.
+    if (!m_hinter_states)
+    {
+        m_hinter_states = std::make_unique<command_line_states>();
+        m_hinter_states->set(m_line.c_str(), get_linestates());
+        m_hinter_states->split_for_hinter();
+    }
+    return m_hinter_states->get_linestate(m_line.c_str(), m_line.length());
+}
+
+//------------------------------------------------------------------------------
+void command_line_snapshot::note_reused()
+{
+    ++s_snapshot_stats.reused;
+}
+
+//------------------------------------------------------------------------------
+void command_line_snapshot::get_stats(stats& out)
+{
+    out = s_snapshot_stats;
+}
@@ -0,0 +1,163 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "benchmark.h"
+#include "fuzzy_match.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <core/str_compare.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Fuzzy match")
+{
+    fuzzy_matcher matcher;
+
+    SECTION("Subsequence")
+    {
+        matcher.set_needle("gcm", str_compare_scope::caseless, false);
+        REQUIRE(matcher.score("git commit -m fix") >= 0);
+        REQUIRE(matcher.score("GIT COMMIT") >= 0);
+        REQUIRE(matcher.score("git status") == fuzzy_matcher::no_match);
+        REQUIRE(matcher.score("mcg") == fuzzy_matcher::no_match);
+        REQUIRE(matcher.score("") == fuzzy_matcher::no_match);
+
+        matcher.set_needle("GCM", str_compare_scope::exact, false);
+        REQUIRE(matcher.score("git commit") == fuzzy_matcher::no_match);
+        REQUIRE(matcher.score("Git Commit Message") >= 0);
+    }
+
+    SECTION("Folding")
+    {
+        matcher.set_needle("my-t", str_compare_scope::relaxed, false);
+        REQUIRE(matcher.score("make MY_TARGET") >= 0);
+        matcher.set_needle("my-t", str_compare_scope::caseless, false);
+        REQUIRE(matcher.score("make MY_TARGET") == fuzzy_matcher::no_match);
+
+        matcher.set_needle("c:/repo", str_compare_scope::caseless, false);
+        REQUIRE(matcher.score("cd c:\\repo") >= 0);
+
+        matcher.set_needle("cafe", str_compare_scope::caseless, true);
+        REQUIRE(matcher.score("echo Caf\xc3\xa9") >= 0);
+        matcher.set_needle("cafe", str_compare_scope::caseless, false);
+        REQUIRE(matcher.score("echo Caf\xc3\xa9") == fuzzy_matcher::no_match);
+    }
+
+    SECTION("Ranking")
+    {
+        matcher.set_needle("stat", str_compare_scope::caseless, false);
+
+        // Contiguous beats scattered.
+        REQUIRE(matcher.score("git status") > matcher.score("git stash list"));
+        REQUIRE(matcher.score("git stash list") >= 0);
+
+        // Word starts beat the middle of words.
+        REQUIRE(matcher.score("netstat -an") < matcher.score("git status"));
+
+        // camelCase boundaries count as word starts.
+        matcher.set_needle("fb", str_compare_scope::caseless, false);
+        REQUIRE(matcher.score("fooBar") > matcher.score("foobar"));
+        REQUIRE(matcher.score("foo bar") > matcher.score("foobar"));
+
+        // The shortest window is scored.
+        matcher.set_needle("ab", str_compare_scope::caseless, false);
+        REQUIRE(matcher.score("a x x x ab") == matcher.score("ab"));
+    }
+
+    SECTION("Match end")
+    {
+        matcher.set_needle("gcm", str_compare_scope::caseless, false);
+        REQUIRE(matcher.match_end("git-commit") == 7);
+        REQUIRE(matcher.match_end("GIT COMMIT -m") == 7);
+        REQUIRE(matcher.match_end("git-commit", 6) == fuzzy_matcher::no_match);
+        REQUIRE(matcher.match_end("git status") == fuzzy_matcher::no_match);
+
+        matcher.set_needle("", str_compare_scope::caseless, false);
+        REQUIRE(matcher.match_end("abc") == 0);
+    }
+
+    SECTION("Mask")
+    {
+        matcher.set_needle("gcm", str_compare_scope::caseless, false);
+        REQUIRE(matcher.may_match(matcher.get_mask("Git Commit -m")));
+        REQUIRE(!matcher.may_match(matcher.get_mask("git status")));
+
+        matcher.set_needle("", str_compare_scope::caseless, false);
+        REQUIRE(matcher.empty());
+        REQUIRE(matcher.may_match(0));
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Fuzzy match benchmark")
+{
+    if (!g_run_benchmarks)
+        return;
+
+    // A synthetic 100k line history.
+    static const char* const c_commands[] =
+    {
+        "git commit -m \"fix %u\"",
+        "git status",
+        "cd c:\\src\\project\\module%u",
+        "dir /s /b *.cpp",
+        "premake5 vs2022 --file=build%u.lua",
+        "msbuild .build\\vs2022\\clink.sln /p:Configuration=Release /m",
+        "findstr /s /i \"needle%u\" *.h",
+        "echo %u > out.txt",
+    };
+    const uint32 rows = 100000;
+    std::vector<str_moveable> history;
+    history.reserve(rows);
+    str<> line;
+    for (uint32 i = 0; i < rows; ++i)
+    {
+        line.format(c_commands[i % sizeof_array(c_commands)], i);
+        history.emplace_back(line.c_str());
+    }
+
+    // Score every row for each keystroke, rejecting rows by mask first; the
+    // masks are computed once, as the popup list caches them.
+    const char* const needle = "msbrel";
+    fuzzy_matcher matcher;
+    matcher.set_needle(needle, str_compare_scope::caseless, false);
+    std::vector<uint64> masks;
+    masks.reserve(rows);
+    {
+        benchmark_timer timer("fuzzy: masks", rows);
+        for (const auto& h : history)
+            masks.push_back(matcher.get_mask(h.c_str()));
+    }
+
+    std::vector<uint32> candidates;
+    for (uint32 i = 0; i < rows; ++i)
+        candidates.push_back(i);
+
+    str<> typed;
+    str<> name;
+    for (const char* p = needle; *p; ++p)
+    {
+        typed.concat(p, 1);
+        matcher.set_needle(typed.c_str(), str_compare_scope::caseless, false);
+
+        // Typing more characters only rescores the previous matches.
+        std::vector<uint32> matches;
+        name.format("fuzzy: keystroke \"%s\"", typed.c_str());
+        {
+            benchmark_timer timer(name.c_str(), uint32(candidates.size()));
+            for (const uint32 i : candidates)
+            {
+                if (matcher.may_match(masks[i]) && matcher.score(history[i].c_str()) >= 0)
+                    matches.push_back(i);
+            }
+        }
+        candidates = std::move(matches);
+    }
+
+    REQUIRE(candidates.size() == rows / sizeof_array(c_commands));
+}
@@ -0,0 +1,203 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "benchmark.h"
+
+#include <core/str.h>
+#include <core/str_compare.h>
+#include <lib/matches.h>
+#include <matches_impl.h>
+#include <match_pipeline.h>
+#include <selectcomplete_impl.h>
+
+//------------------------------------------------------------------------------
+static void build_matches(matches_impl& matches, uint32 count)
+{
+    str<32> match;
+    str<32> display;
+    match_builder builder(matches);
+    for (uint32 i = 0; i < count; ++i)
+    {
+        match.format("m%07u", count - 1 - i);
+        display.format("d%07u", count - 1 - i);
+        match_desc desc(match.c_str(), display.c_str(), nullptr, match_type::word);
+        builder.add_match(desc, true);
+    }
+    matches.done_building();
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Matches count")
+{
+    // More than 65535 matches must not wrap or truncate.
+    const uint32 count = 70000;
+
+    matches_impl matches;
+    build_matches(matches, count);
+    REQUIRE(matches.get_match_count() == count);
+    REQUIRE(strcmp(matches.get_match(count - 1), "m0000000") == 0);
+    REQUIRE(strcmp(matches.get_match_display(count - 1), "d0000000") == 0);
+
+    SECTION("Select")
+    {
+        match_pipeline pipeline(matches);
+        pipeline.select("m001");
+        REQUIRE(matches.get_match_count() == 10000);
+
+        // Cold fields must follow their hot fields after selecting.
+        for (uint32 i = 0; i < matches.get_match_count(); ++i)
+        {
+            const char* m = matches.get_match(i);
+            const char* d = matches.get_match_display(i);
+            REQUIRE(strcmp(m + 1, d + 1) == 0);
+        }
+
+        SECTION("Sort")
+        {
+            pipeline.set_no_sort();
+            pipeline.sort();
+            REQUIRE(matches.get_match_count() == 10000);
+            REQUIRE(strcmp(matches.get_match(0), "m0019999") == 0);
+            REQUIRE(strcmp(matches.get_match_display(0), "d0019999") == 0);
+            REQUIRE(strcmp(matches.get_match(9999), "m0010000") == 0);
+            REQUIRE(strcmp(matches.get_match_display(9999), "d0010000") == 0);
+        }
+    }
+
+    SECTION("Copy")
+    {
+        matches_impl copy;
+        copy.copy(matches);
+        REQUIRE(copy.get_match_count() == count);
+        REQUIRE(strcmp(copy.get_match(count - 1), "m0000000") == 0);
+        REQUIRE(strcmp(copy.get_match_display(count - 1), "d0000000") == 0);
+
+        // The copy shares strings with the source.
+        REQUIRE(copy.get_match(0) == matches.get_match(0));
+
+        // Selecting in the copy must not affect the source.
+        match_pipeline pipeline(copy);
+        pipeline.select("m002");
+        REQUIRE(copy.get_match_count() == 10000);
+        REQUIRE(matches.get_match_count() == count);
+
+        // The copy must survive the source being cleared.
+        matches.clear();
+        for (uint32 i = 0; i < copy.get_match_count(); ++i)
+        {
+            const char* m = copy.get_match(i);
+            const char* d = copy.get_match_display(i);
+            REQUIRE(strncmp(m, "m002", 4) == 0);
+            REQUIRE(strcmp(m + 1, d + 1) == 0);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Matches fuzzy select")
+{
+    matches_impl matches;
+    {
+        match_builder builder(matches);
+        const char* const words[] = { "checkout", "cleanup", "commit", "check", "cherry-pick" };
+        for (const char* word : words)
+        {
+            match_desc desc(word, nullptr, nullptr, match_type::word);
+            builder.add_match(desc, true);
+        }
+        matches.done_building();
+    }
+
+    match_pipeline pipeline(matches);
+
+    SECTION("Rank")
+    {
+        // The contiguous match at the start of a word ranks first.
+        pipeline.select_fuzzy("co");
+        REQUIRE(matches.get_match_count() == 2);
+        REQUIRE(strcmp(matches.get_match(0), "commit") == 0);
+        REQUIRE(strcmp(matches.get_match(1), "checkout") == 0);
+    }
+
+    SECTION("Reselect")
+    {
+        // Each selection starts over from all of the matches.
+        pipeline.select_fuzzy("cko");
+        REQUIRE(matches.get_match_count() == 1);
+        REQUIRE(strcmp(matches.get_match(0), "checkout") == 0);
+
+        pipeline.select_fuzzy("chk");
+        REQUIRE(matches.get_match_count() == 3);
+
+        pipeline.select_fuzzy("xyz");
+        REQUIRE(matches.get_match_count() == 0);
+    }
+
+    SECTION("Needle in match")
+    {
+        str_compare_scope _(str_compare_scope::caseless, false);
+
+        // A prefix covers its own length, fuzzy or not.
+        REQUIRE(get_needle_len_in_match("ch", "checkout", 8, false) == 2);
+        REQUIRE(get_needle_len_in_match("CH", "checkout", 8, true) == 2);
+
+        // A fuzzy needle covers the match through its last matched
+        // character, and the rest of the match is the selection.
+        REQUIRE(get_needle_len_in_match("cko", "checkout", 8, true) == 6);
+        REQUIRE(get_needle_len_in_match("gcm", "git-commit", 10, true) == 7);
+        REQUIRE(get_needle_len_in_match("gcm", "git-commit", 10, false) == 0);
+
+        // Only the inserted match counts, not what follows it in the line.
+        REQUIRE(get_needle_len_in_match("gcmx", "git-commit x", 10, true) == 0);
+        REQUIRE(get_needle_len_in_match("commit x", "commit x", 6, false) == 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Matches scaling benchmark")
+{
+    if (!g_run_benchmarks)
+        return;
+
+    for (uint32 count = 1000; count <= 1000000; count *= 10)
+    {
+        matches_impl matches;
+        match_pipeline pipeline(matches);
+
+        {
+            benchmark_timer timer("matches: build", count);
+            build_matches(matches, count);
+        }
+        REQUIRE(matches.get_match_count() == count);
+
+        {
+            benchmark_timer timer("matches: select", count);
+            pipeline.select("m0");
+        }
+        REQUIRE(matches.get_match_count() == count);
+
+        {
+            benchmark_timer timer("matches: sort (ordinal)", count);
+            pipeline.set_no_sort();
+            pipeline.sort();
+        }
+
+        {
+            benchmark_timer timer("matches: copy", count);
+            matches_impl copy;
+            copy.copy(matches);
+            REQUIRE(copy.get_match_count() == count);
+        }
+
+        {
+            benchmark_timer timer("matches: iterate", count);
+            uint32 n = 0;
+            for (matches_iter iter = matches.get_iter(); iter.next();)
+                n += !!iter.get_match_display();
+            REQUIRE(n == count);
+        }
+    }
+}
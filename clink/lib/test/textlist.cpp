@@ -0,0 +1,251 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "textlist_impl.h"
+
+#include <core/base.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+struct test_textlist : public input_dispatcher
+{
+                    test_textlist(std::vector<const char*>&& entries);
+
+    // input_dispatcher
+    void            dispatch(int32 bind_group) override {}
+    bool            available(uint32 timeout) override { return false; }
+    uint8           peek() override { return 0; }
+
+    int32           count() const { return m_textlist.m_count; }
+    int32           longest() const { return m_textlist.m_longest; }
+    bool            widths_changed() const { return m_textlist.m_widths_changed; }
+    bool            is_materialized(int32 original_index) const { return m_textlist.m_items[original_index] != nullptr; }
+    int32           num_materialized() const;
+    const char*     get_item_text(int32 index) { return m_textlist.get_item_text(index); }
+    void            set_fuzzy(bool reverse);
+    bool            filter(const char* needle);
+    int32           get_original_index(int32 index) const { return m_textlist.get_original_index(index); }
+    void            remove_item(int32 index) { m_textlist.remove_item(index); }
+
+    std::vector<const char*> m_entries;
+    textlist_impl   m_textlist;
+};
+
+//------------------------------------------------------------------------------
+test_textlist::test_textlist(std::vector<const char*>&& entries)
+: m_entries(std::move(entries))
+, m_textlist(*this)
+{
+    m_textlist.m_entries = m_entries.data();
+    m_textlist.m_count = int32(m_entries.size());
+    m_textlist.m_original_count = int32(m_entries.size());
+    m_textlist.m_visible_rows = 10;
+    m_textlist.init_items(false, false);
+}
+
+//------------------------------------------------------------------------------
+int32 test_textlist::num_materialized() const
+{
+    int32 num = 0;
+    for (const char* item : m_textlist.m_items)
+        num += (item != nullptr);
+    return num;
+}
+
+//------------------------------------------------------------------------------
+void test_textlist::set_fuzzy(bool reverse)
+{
+    m_textlist.m_fuzzy = true;
+    m_textlist.m_reverse = reverse;
+}
+
+//------------------------------------------------------------------------------
+bool test_textlist::filter(const char* needle)
+{
+    m_textlist.m_needle = needle;
+    return m_textlist.filter_items();
+}
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("Textlist rows")
+{
+    SECTION("Lazy")
+    {
+        test_textlist t({ "abc", "a\x01" "bcdefgh", "xyz" });
+
+        // Nothing is built up front, but short lists measure the widths from
+        // every row, including the control character that displays as ^A.
+        REQUIRE(t.num_materialized() == 0);
+        REQUIRE(t.longest() == 10);
+
+        // Rows are built as they're needed.
+        REQUIRE(strcmp(t.get_item_text(2), "xyz") == 0);
+        REQUIRE(t.is_materialized(2));
+        REQUIRE(t.num_materialized() == 1);
+
+        REQUIRE(strcmp(t.get_item_text(1), "a^Abcdefgh") == 0);
+        REQUIRE(t.num_materialized() == 2);
+        REQUIRE(t.longest() == 10);
+    }
+
+    SECTION("Sampled width")
+    {
+        // Large lists measure only a sample of rows up front.  Row 3 isn't
+        // in the sample, so the width grows when it's built.
+        std::vector<const char*> entries(5000, "short");
+        entries[3] = "a much longer row";
+        test_textlist t(std::move(entries));
+        REQUIRE(t.num_materialized() == 0);
+        REQUIRE(t.longest() == 5);
+        REQUIRE(!t.widths_changed());
+
+        t.get_item_text(2);
+        REQUIRE(!t.widths_changed());
+
+        REQUIRE(strcmp(t.get_item_text(3), "a much longer row") == 0);
+        REQUIRE(t.longest() == 17);
+        REQUIRE(t.widths_changed());
+    }
+
+    SECTION("Delete")
+    {
+        test_textlist t({ "one", "two", "three", "four", "five" });
+        t.get_item_text(3);
+
+        t.remove_item(1);
+        REQUIRE(t.count() == 4);
+        REQUIRE(t.num_materialized() == 1);
+        REQUIRE(t.is_materialized(2));
+
+        const char* const expected[] = { "one", "three", "four", "five" };
+        for (int32 i = 0; i < sizeof_array(expected); ++i)
+            REQUIRE(strcmp(t.get_item_text(i), expected[i]) == 0);
+    }
+
+    SECTION("Filter")
+    {
+        test_textlist t({ "alpha", "beta", "gamma", "delta", "epsilon" });
+
+        // Filtering builds the rows it needs to search.
+        REQUIRE(t.filter("l"));
+        REQUIRE(t.count() == 3);
+        REQUIRE(t.num_materialized() == 5);
+        REQUIRE(strcmp(t.get_item_text(0), "alpha") == 0);
+        REQUIRE(strcmp(t.get_item_text(1), "delta") == 0);
+        REQUIRE(strcmp(t.get_item_text(2), "epsilon") == 0);
+
+        // Deleting a filtered row removes it from the original rows too.
+        t.remove_item(1);
+        REQUIRE(t.count() == 2);
+        REQUIRE(strcmp(t.get_item_text(0), "alpha") == 0);
+        REQUIRE(strcmp(t.get_item_text(1), "epsilon") == 0);
+
+        // Refining searches only the remaining filtered rows.
+        REQUIRE(t.filter("lon"));
+        REQUIRE(t.count() == 1);
+        REQUIRE(strcmp(t.get_item_text(0), "epsilon") == 0);
+
+        REQUIRE(t.filter("lonx"));
+        REQUIRE(t.count() == 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Textlist fuzzy")
+{
+    SECTION("Ranked")
+    {
+        // More matches than are sorted by score:  900 best, then 300 good
+        // and 300 poor, interleaved.
+        std::vector<const char*> entries;
+        for (int32 i = 0; i < 1500; ++i)
+        {
+            switch (i % 5)
+            {
+            case 3:     entries.push_back("axbc"); break;
+            case 4:     entries.push_back("axxxxbxxxxc"); break;
+            default:    entries.push_back("abc"); break;
+            }
+        }
+
+        // The top 1000 are the best 900, then the first 100 good ones.  The
+        // rest keep their original order.
+        std::vector<int32> expected;
+        for (int32 i = 0; i < 1500; ++i)
+            if (i % 5 < 3)
+                expected.push_back(i);
+        for (int32 i = 3; i < 500; i += 5)
+            expected.push_back(i);
+        for (int32 i = 0; i < 1500; ++i)
+            if (i % 5 == 4 || (i % 5 == 3 && i >= 500))
+                expected.push_back(i);
+
+        SECTION("Forward")
+        {
+            test_textlist t(std::move(entries));
+            t.set_fuzzy(false);
+            REQUIRE(t.filter("abc"));
+            REQUIRE(t.count() == 1500);
+            for (int32 i = 0; i < 1500; ++i)
+                REQUIRE(t.get_original_index(i) == expected[i]);
+        }
+
+        SECTION("Reverse")
+        {
+            // The best match goes where the list starts, at the end.  Ties
+            // prefer the items nearest there, so the top 1000 are the best
+            // 900 and the last 100 good ones.
+            expected.clear();
+            for (int32 i = 0; i < 1000; ++i)
+                if (i % 5 >= 3)
+                    expected.push_back(i);
+            for (int32 i = 1000; i < 1500; i += 5)
+                expected.push_back(i + 4);
+            for (int32 i = 1003; i < 1500; i += 5)
+                expected.push_back(i);
+            for (int32 i = 0; i < 1500; ++i)
+                if (i % 5 < 3)
+                    expected.push_back(i);
+
+            test_textlist t(std::move(entries));
+            t.set_fuzzy(true);
+            REQUIRE(t.filter("abc"));
+            REQUIRE(t.count() == 1500);
+            for (int32 i = 0; i < 1500; ++i)
+                REQUIRE(t.get_original_index(i) == expected[i]);
+        }
+    }
+
+    SECTION("Delete and refine")
+    {
+        test_textlist t({ "axxxxxxbxxxxxxc", "ab", "abc", "x abc", "qq" });
+        t.set_fuzzy(false);
+
+        // Ranking leaves the filtered items out of their original order.
+        REQUIRE(t.filter("ab"));
+        REQUIRE(t.count() == 4);
+        REQUIRE(t.get_original_index(0) == 1);
+        REQUIRE(t.get_original_index(1) == 2);
+        REQUIRE(t.get_original_index(2) == 3);
+        REQUIRE(t.get_original_index(3) == 0);
+
+        // Delete "abc".
+        t.remove_item(1);
+        REQUIRE(t.count() == 3);
+        REQUIRE(strcmp(t.get_item_text(0), "ab") == 0);
+        REQUIRE(strcmp(t.get_item_text(1), "x abc") == 0);
+        REQUIRE(strcmp(t.get_item_text(2), "axxxxxxbxxxxxxc") == 0);
+
+        // Refining searches the remaining filtered items.
+        REQUIRE(t.filter("abc"));
+        REQUIRE(t.count() == 2);
+        REQUIRE(strcmp(t.get_item_text(0), "x abc") == 0);
+        REQUIRE(strcmp(t.get_item_text(1), "axxxxxxbxxxxxxc") == 0);
+    }
+}
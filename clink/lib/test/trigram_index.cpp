@@ -0,0 +1,108 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "trigram_index.h"
+
+#include <core/base.h>
+#include <core/str_compare.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static void build(trigram_index& index, int32 mode, bool fuzzy_accents, const std::vector<std::vector<const char*>>& rows)
+{
+    index.begin(mode, fuzzy_accents);
+    for (const auto& row : rows)
+    {
+        index.add_row();
+        for (const char* text : row)
+            index.add_text(text);
+    }
+}
+
+//------------------------------------------------------------------------------
+static bool candidates_are(const trigram_index& index, const char* needle, const std::vector<int32>& expected)
+{
+    std::vector<int32> out;
+    return index.get_candidates(needle, out) && out == expected;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Trigram index")
+{
+    static const std::vector<std::vector<const char*>> c_rows =
+    {
+        { "git commit -m fix" },                // 0
+        { "cd c:\\repo\\clink" },               // 1
+        { "dir /s *.cpp" },                     // 2
+        { "git status", "12:34" },              // 3
+        { "echo Caf\xc3\xa9" },                 // 4
+        { "make my_target" },                   // 5
+    };
+
+    trigram_index index;
+    std::vector<int32> out;
+
+    SECTION("Exact")
+    {
+        build(index, str_compare_scope::exact, false, c_rows);
+        REQUIRE(index.get_row_count() == 6);
+        REQUIRE(candidates_are(index, "git", { 0, 3 }));
+        REQUIRE(candidates_are(index, "GIT", {}));
+        REQUIRE(candidates_are(index, "status", { 3 }));
+        REQUIRE(candidates_are(index, "12:3", { 3 }));     // Columns are indexed.
+        REQUIRE(candidates_are(index, "xyz", {}));
+        REQUIRE(candidates_are(index, "my-target", {}));
+
+        // Too short to narrow the search.
+        REQUIRE(!index.get_candidates("gi", out));
+        REQUIRE(!index.get_candidates("", out));
+    }
+
+    SECTION("Caseless")
+    {
+        build(index, str_compare_scope::caseless, false, c_rows);
+        REQUIRE(candidates_are(index, "GIT", { 0, 3 }));
+        REQUIRE(candidates_are(index, "CLINK", { 1 }));
+        REQUIRE(candidates_are(index, "my-target", {}));
+    }
+
+    SECTION("Relaxed")
+    {
+        build(index, str_compare_scope::relaxed, false, c_rows);
+        REQUIRE(candidates_are(index, "MY-TARGET", { 5 }));
+        REQUIRE(candidates_are(index, "-m f", { 0 }));
+    }
+
+    SECTION("Separators")
+    {
+        build(index, str_compare_scope::exact, false, c_rows);
+        REQUIRE(candidates_are(index, "c:/repo/clink", { 1 }));
+        REQUIRE(candidates_are(index, "repo\\\\clink", { 1 }));
+        REQUIRE(candidates_are(index, "/s *", { 2 }));
+    }
+
+    SECTION("Accents")
+    {
+        build(index, str_compare_scope::caseless, false, c_rows);
+        REQUIRE(candidates_are(index, "cafe", {}));
+        REQUIRE(candidates_are(index, "caf\xc3\xa9", { 4 }));
+
+        build(index, str_compare_scope::caseless, true, c_rows);
+        REQUIRE(index.is_built_for(str_compare_scope::caseless, true));
+        REQUIRE(!index.is_built_for(str_compare_scope::caseless, false));
+        REQUIRE(candidates_are(index, "cafe", { 4 }));
+        REQUIRE(candidates_are(index, "CAF\xc3\x89", { 4 }));
+    }
+
+    SECTION("Clear")
+    {
+        build(index, str_compare_scope::exact, false, c_rows);
+        index.clear();
+        REQUIRE(index.get_row_count() == 0);
+        REQUIRE(!index.is_built_for(str_compare_scope::exact, false));
+    }
+}
@@ -12,6 +12,7 @@
 #include <core/str_compare.h>
 #include <core/settings.h>
 #include <lib/cmd_tokenisers.h>
+#include <lib/word_collector.h>
 #include <lua/lua_match_generator.h>
 #include <lua/lua_script_loader.h>
 #include <lua/lua_state.h>
@@ -72,3 +73,59 @@ TEST_CASE("Word collection")
     tester.set_expected_words("abc", "hi^", "x", "");
     tester.run();
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("Command line snapshot")
+{
+    cmd_command_tokeniser command_tokeniser;
+    cmd_word_tokeniser word_tokeniser;
+    word_collector collector(&command_tokeniser, &word_tokeniser, "\"");
+
+    str<> line("abc def & xyz qr");
+    const uint32 cursor = 15; // Between 'q' and 'r'.
+
+    words words;
+    commands commands;
+    collector.collect_words(line.c_str(), line.length(), cursor, words, collect_words_mode::whole_command, &commands);
+
+    command_line_states states;
+    states.set(line.c_str(), line.length(), cursor, words, collect_words_mode::whole_command, commands);
+
+    command_line_snapshot::stats before;
+    command_line_snapshot::get_stats(before);
+
+    command_line_snapshot snapshot(states.get_linestates(line.c_str(), line.length()));
+
+    command_line_snapshot::stats after;
+    command_line_snapshot::get_stats(after);
+    REQUIRE(after.built == before.built + 1);
+
+    // The snapshot owns its copy of the line.
+    line.clear();
+    line << "something else entirely";
+    states.clear();
+
+    REQUIRE(snapshot.is_line("abc def & xyz qr", 16));
+    REQUIRE(!snapshot.is_line(line.c_str(), line.length()));
+
+    const line_states& lines = snapshot.get_linestates();
+    REQUIRE(lines.size() == 2);
+    REQUIRE(&lines.back() == &snapshot.get_linestate());
+
+    str<> word;
+    REQUIRE(lines[0].get_word_count() == 2);
+    lines[0].get_word(1, word);
+    REQUIRE(word.equals("def"));
+    REQUIRE(lines[1].get_word_count() == 2);
+    lines[1].get_end_word(word);
+    REQUIRE(word.equals("qr"));
+
+    // The hinter line state stops at the cursor, without changing the
+    // shared line states.
+    const line_state& hinter = snapshot.get_hinter_linestate();
+    REQUIRE(hinter.get_word_count() == 2);
+    hinter.get_end_word(word);
+    REQUIRE(word.equals("q"));
+    lines[1].get_end_word(word);
+    REQUIRE(word.equals("qr"));
+}
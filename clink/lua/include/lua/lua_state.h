@@ -8,6 +8,8 @@
 
 #include <functional>
 #include <list>
+#include <memory>
+#include <vector>
 
 extern "C" {
 #include <readline/readline.h>
@@ -15,6 +17,7 @@ extern "C" {
 }
 
 struct lua_State;
+class lua_allocator;
 class str_base;
 class line_state;
 class terminal_in;
@@ -71,8 +74,14 @@ public:
     void            shutdown();
     bool            do_string(const char* string, int32 length=-1, str_base* error=nullptr, const char* name=nullptr);
     bool            do_file(const char* path);
+    bool            do_file(const char* path, const char* chunk, uint32 chunk_len, std::vector<char>* compiled);
+    static bool     do_file(lua_State* L, const char* path, const char* chunk, uint32 chunk_len, std::vector<char>* compiled);
     lua_State*      get_state() const;
 
+    void            begin_edit();
+    bool            has_idle_gc_work() const;
+    void            idle_gc_step();
+
     static bool     push_named_function(lua_State* L, const char* func_name, str_base* error=nullptr);
 
     static int32    pcall(lua_State* L, int32 nargs, int32 nresults, str_base* error=nullptr);
@@ -112,6 +121,7 @@ public:
 private:
     static bool     send_event_internal(lua_State* L, const char* event_name, const char* event_mechanism, int32 nargs=0, int32 nret=0);
     lua_State*      m_state;
+    std::unique_ptr<lua_allocator> m_allocator;
 
     static bool     s_internal;
     static bool     s_interpreter;
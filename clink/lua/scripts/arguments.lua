@@ -33,6 +33,8 @@ local _clear_onuse_coroutine = {}
 local _clear_delayinit_coroutine = {}
 local _argmatcher_loaders = {}
 local _argmatcher_loaders_unsorted = false
+local _builtin_glob_matches = {}
+local file_matches_impl
 
 --------------------------------------------------------------------------------
 clink.onbeginedit(function ()
@@ -240,15 +242,54 @@ local function do_onuse_callback(argmatcher, command_word)
 end
 
 --------------------------------------------------------------------------------
-local function is_word_present(word, arg, t, arg_match_type)
-    for _, i in ipairs(arg) do
-        local it = type(i)
-        if it == "function" then
-            t = 'o' --other (placeholder; superseded by :classifyword).
-        elseif i == word or (it == "table" and i.match == word) then
-            return arg_match_type, true, i.arginfo
+-- Argument lists can have hundreds of entries (e.g. the flags for git or
+-- kubectl), so looking up words goes through an index that's built the first
+-- time a list is used.  Lists only grow (see _argmatcher:_add), so the index is
+-- rebuilt whenever the length of the list changes.
+local _word_indexes = setmetatable({}, { __mode = "k" })
+
+local function get_word_index(arg)
+    local n = #arg
+    local index = _word_indexes[arg]
+    if index and index.n == n then
+        return index
+    end
+
+    local words = {}    -- Word -> position of first entry that matches it.
+    local plain = {}    -- Words that appear as plain string entries.
+    local has_func
+    for i = 1, n do
+        local v = arg[i]
+        local vt = type(v)
+        if vt == "string" then
+            words[v] = words[v] or i
+            plain[v] = true
+        elseif vt == "table" then
+            local m = v.match
+            if type(m) == "string" then
+                words[m] = words[m] or i
+            end
+        elseif vt == "function" then
+            has_func = true
         end
     end
+
+    index = { n=n, words=words, plain=plain, has_func=has_func }
+    _word_indexes[arg] = index
+    return index
+end
+
+--------------------------------------------------------------------------------
+local function is_word_present(word, arg, t, arg_match_type)
+    local index = get_word_index(arg)
+    local i = index.words[word]
+    if i then
+        local v = arg[i]
+        return arg_match_type, true, type(v) == "table" and v.arginfo or nil
+    end
+    if index.has_func then
+        t = 'o' --other (placeholder; superseded by :classifyword).
+    end
     return t, false
 end
 
@@ -1029,13 +1070,10 @@ function _argreader:classify_word(is_flag, arg_index, realmatcher, word, word_in
                         local next_info = line_state:getwordinfo(word_index + 1)
                         if this_info and next_info and this_info.offset + this_info.length == next_info.offset then
                             local combined_word = word..line_state:getword(word_index + 1)
-                            for _, i in ipairs(arg) do
-                                if type(i) ~= "function" and i == combined_word then
-                                    t = arg_match_type
-                                    self._word_classifier:classifyword(word_index + 1, t, false)
-                                    matched = true
-                                    break
-                                end
+                            if get_word_index(arg).plain[combined_word] then
+                                t = arg_match_type
+                                self._word_classifier:classifyword(word_index + 1, t, false)
+                                matched = true
                             end
                         end
                     end
@@ -2154,9 +2192,18 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
         for _, i in ipairs(arg) do
             local t = type(i)
             if t == "function" then
-                local j = i(word, word_index, line_state, match_builder, reader._user_data)
-                if type(j) ~= "table" then
-                    return j or false
+                local j
+                local builtin = _builtin_glob_matches[i]
+                if builtin then
+                    -- Add file or dir matches directly into the builder when
+                    -- possible.  Any that are returned instead go through the
+                    -- same steps as matches from other functions.
+                    j = builtin(word, match_builder)
+                else
+                    j = i(word, word_index, line_state, match_builder, reader._user_data)
+                    if type(j) ~= "table" then
+                        return j or false
+                    end
                 end
 
                 apply_options_to_builder(reader, j, match_builder)
@@ -2196,7 +2243,7 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
     if info.redir then
         -- The word is an argument to a redirection symbol, so generate file
         -- matches.
-        match_builder:addmatches(clink.filematches(line_state:getendword()))
+        file_matches_impl(line_state:getendword(), nil, match_builder)
         clink._why_argmatcher_stopped = "redirection"
         return true
     elseif not reader._noflags and matcher._flags and matcher:_is_flag(line_state:getendword()) then
@@ -2209,7 +2256,7 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
     elseif reader._phantomposition then
         -- Generate file matches for phantom positions, i.e. any flag ending
         -- with : or = that does not explicitly link to another matcher.
-        match_builder:addmatches(clink.filematches(line_state:getendword()))
+        file_matches_impl(line_state:getendword(), nil, match_builder)
         clink._why_argmatcher_stopped = "phantom position"
         return true
     else
@@ -2379,6 +2426,195 @@ local function get_creation_srcinfo()
     return first or "?"
 end
 
+--------------------------------------------------------------------------------
+-- Scripts whose only effect is registering argmatchers can be deferred until
+-- one of their commands is looked up.  The host records what each script does
+-- while it loads, and caches that in a manifest so later sessions can skip
+-- loading such scripts at startup.
+local _deferred_pending = {}    -- File name -> deferred script not loaded yet.
+local _deferred_by_name = {}    -- Command name -> list of deferred scripts.
+local _deferred_count = 0
+local _deferred_loaded = 0
+local _loading_deferred
+
+local function load_deferred_scripts(name)
+    if _loading_deferred or not _deferred_by_name[name] then
+        return
+    end
+
+    -- Gather the scripts for the name plus any that share names with them,
+    -- so that merged argmatchers are built in the original load order.
+    local scripts = {}
+    local names = { name }
+    local i = 1
+    while names[i] do
+        local list = _deferred_by_name[names[i]]
+        if list then
+            _deferred_by_name[names[i]] = nil
+            for _, file in ipairs(list) do
+                local d = _deferred_pending[file]
+                if d then
+                    _deferred_pending[file] = nil
+                    table.insert(scripts, d)
+                    for _, n in ipairs(d.names) do
+                        table.insert(names, n)
+                    end
+                end
+            end
+        end
+        i = i + 1
+    end
+    table.sort(scripts, function(a, b) return a.order < b.order end)
+
+    -- Load them the same way as scripts loaded at startup, which reports any
+    -- errors.
+    _loading_deferred = true
+    for _, d in ipairs(scripts) do
+        _deferred_loaded = _deferred_loaded + 1
+        clink._load_deferred_script(d.file)
+    end
+    _loading_deferred = nil
+end
+
+--------------------------------------------------------------------------------
+-- UNDOCUMENTED; internal use only.
+function clink._defer_script(file, ...)
+    _deferred_count = _deferred_count + 1
+    local d = { file=file, order=_deferred_count, names={} }
+    for _, name in ipairs({...}) do
+        name = path.normalise(clink.lower(name))
+        table.insert(d.names, name)
+        local list = _deferred_by_name[name]
+        if not list then
+            list = {}
+            _deferred_by_name[name] = list
+        end
+        table.insert(list, file)
+    end
+    _deferred_pending[file] = d
+end
+
+--------------------------------------------------------------------------------
+-- Anything other than registering argmatchers keeps a script from being
+-- deferred.  These are the registration functions that are watched, plus any
+-- changes to globals or to these tables.
+local _recording
+local _record_functions = {
+    clink = { "generator", "classifier", "hinter", "promptfilter", "suggester",
+              "argmatcherloader", "register_match_generator", "addcoroutine",
+              "runonmain", "promptcoroutine" },
+    os = { "setenv", "setalias", "chdir" },
+    rl = { "setbinding", "setvariable" },
+    settings = { "add", "set" },
+}
+local _record_tables = { "clink", "console", "io", "log", "os", "path", "rl",
+                         "settings", "string", "table", "unicode" }
+
+local function shallow_copy(t)
+    local copy = {}
+    for k, v in pairs(t) do
+        copy[k] = v
+    end
+    return copy
+end
+
+local function is_changed(t, copy)
+    for k, v in pairs(t) do
+        if copy[k] ~= v then
+            return true
+        end
+    end
+    for k in pairs(copy) do
+        if t[k] == nil then
+            return true
+        end
+    end
+end
+
+local function add_record_wrapper(wrappers, tname, t, k)
+    local func = t[k]
+    if type(func) == "function" then
+        local kind = tname.."."..k
+        local wrapper = function(...)
+            if _recording then
+                _recording.kinds[kind] = true
+            end
+            return func(...) -- Tail call, so srcinfo levels are unaffected.
+        end
+        t[k] = wrapper
+        table.insert(wrappers, { t=t, k=k, func=func, wrapper=wrapper })
+    end
+end
+
+--------------------------------------------------------------------------------
+-- UNDOCUMENTED; internal use only.
+function clink._begin_script_record()
+    local wrappers = {}
+    for tname, list in pairs(_record_functions) do
+        local t = _G[tname]
+        if type(t) == "table" then
+            for _, k in ipairs(list) do
+                add_record_wrapper(wrappers, tname, t, k)
+            end
+        end
+    end
+    for k in pairs(shallow_copy(clink)) do
+        if k:find("^on%a") then
+            add_record_wrapper(wrappers, "clink", clink, k)
+        end
+    end
+
+    local copies = { _G=shallow_copy(_G), ["package.loaded"]=shallow_copy(package.loaded) }
+    for _, tname in ipairs(_record_tables) do
+        if type(_G[tname]) == "table" then
+            copies[tname] = shallow_copy(_G[tname])
+        end
+    end
+
+    _recording = { kinds={}, names={}, seen={}, wrappers=wrappers, copies=copies }
+end
+
+--------------------------------------------------------------------------------
+-- UNDOCUMENTED; internal use only.
+-- Returns a comma separated list of what else the script did (empty when it
+-- only registered argmatchers), and a table of the argmatcher names it
+-- registered.
+function clink._end_script_record()
+    local rec = _recording
+    _recording = nil
+    if not rec then
+        return
+    end
+
+    for tname, copy in pairs(rec.copies) do
+        local t = (tname == "package.loaded") and package.loaded or _G[tname]
+        if type(t) ~= "table" or is_changed(t, copy) then
+            rec.kinds["modified "..tname] = true
+        end
+    end
+
+    for _, w in ipairs(rec.wrappers) do
+        if w.t[w.k] == w.wrapper then
+            w.t[w.k] = w.func
+        end
+    end
+
+    local kinds = {}
+    for kind in pairs(rec.kinds) do
+        table.insert(kinds, kind)
+    end
+    table.sort(kinds)
+
+    return table.concat(kinds, ","), rec.names
+end
+
+local function record_argmatcher_name(name)
+    if _recording and not _recording.seen[name] then
+        _recording.seen[name] = true
+        table.insert(_recording.names, name)
+    end
+end
+
 --------------------------------------------------------------------------------
 --- -name:  clink.argmatcher
 --- -ver:   1.0.0
@@ -2426,6 +2662,14 @@ function clink.argmatcher(...)
         table.remove(input, 1)
     end
 
+    -- Load any deferred scripts for the commands first, so that merging
+    -- happens in the same order as if they were loaded at startup.
+    for _, i in ipairs(input) do
+        local name = path.normalise(clink.lower(i))
+        load_deferred_scripts(name)
+        record_argmatcher_name(name)
+    end
+
     -- If multiple commands are listed, merging isn't supported.
     local matcher = nil
     for _, i in ipairs(input) do
@@ -2469,17 +2713,60 @@ function clink.argmatcher(...)
 end
 
 --------------------------------------------------------------------------------
-local function dir_matches_impl(match_word, exact)
+local function collect_glob_matches(pattern, root, dirs_only, flags, builder)
+    local c, ismain = coroutine.running()
+    if ismain then
+        -- Use a fully native implementation for higher performance.  When a
+        -- builder is available, stream matches straight into it.
+        if builder then
+            builder:_addglobmatches(pattern, root, dirs_only, flags)
+            return
+        end
+        return os._globmatches(pattern, root, dirs_only, flags)
+    end
+
+    -- Yield periodically.
+    local matches = {}
+    if not clink._is_coroutine_canceled(c) then
+        local g = os._makematchglobber(pattern, root, dirs_only, flags)
+        while g:next(matches) do
+            coroutine.yield()
+            if clink._is_coroutine_canceled(c) then
+                matches = {}
+                break
+            end
+        end
+        g:close()
+    end
+
+    if builder then
+        builder:addmatches(matches)
+        return
+    end
+    return matches
+end
+
+--------------------------------------------------------------------------------
+local function share_matches(server, hidden, builder)
+    local matches = {}
+    for share, special in os.enumshares(server, hidden) do
+        table.insert(matches, { match = string.format("\\\\%s\\%s\\", server, share), type = special and "dir,hidden" or "dir" })
+    end
+    if builder then
+        builder:addmatches(matches)
+        return
+    end
+    return matches
+end
+
+--------------------------------------------------------------------------------
+local function dir_matches_impl(match_word, exact, builder)
     local word, expanded = rl.expandtilde(match_word or "")
     local hidden = settings.get("files.hidden") and rl.isvariabletrue("match-hidden-files")
 
     local server = word:match("^\\\\([^\\]+)\\[^\\]*$")
     if server then
-        local matches = {}
-        for share, special in os.enumshares(server, hidden) do
-            table.insert(matches, { match = string.format("\\\\%s\\%s\\", server, share), type = special and "dir,hidden" or "dir" })
-        end
-        return matches
+        return share_matches(server, hidden, builder)
     end
 
     local root = (path.getdirectory(word) or ""):gsub("/", "\\")
@@ -2487,36 +2774,22 @@ local function dir_matches_impl(match_word, exact)
         root = rl.collapsetilde(root)
     end
 
-    local _, ismain = coroutine.running()
-
     local flags = {
         hidden=hidden,
         system=settings.get("files.system"),
     }
 
-    local matches = {}
-    for _, i in ipairs(os.globdirs(word..(exact and "" or "*"), true, flags)) do
-        local m = path.join(root, i.name)
-        table.insert(matches, { match = m, type = i.type })
-        if not ismain and _ % 250 == 0 then
-            coroutine.yield()
-        end
-    end
-    return matches
+    return collect_glob_matches(word..(exact and "" or "*"), root, true, flags, builder)
 end
 
 --------------------------------------------------------------------------------
-local function file_matches_impl(match_word, exact)
+file_matches_impl = function(match_word, exact, builder)
     local word, expanded = rl.expandtilde(match_word or "")
     local hidden = settings.get("files.hidden") and rl.isvariabletrue("match-hidden-files")
 
     local server = word:match("^[/\\][/\\]([^/\\]+)[/\\][^/\\]*$")
     if server then
-        local matches = {}
-        for share, special in os.enumshares(server, hidden) do
-            table.insert(matches, { match = string.format("\\\\%s\\%s\\", server, share), type = special and "dir,hidden" or "dir" })
-        end
-        return matches
+        return share_matches(server, hidden, builder)
     end
 
     local root = (path.getdirectory(word) or "")
@@ -2528,22 +2801,12 @@ local function file_matches_impl(match_word, exact)
         root = rl.collapsetilde(root)
     end
 
-    local _, ismain = coroutine.running()
-
     local flags = {
         hidden=hidden,
         system=settings.get("files.system"),
     }
 
-    local matches = {}
-    for _, i in ipairs(os.globfiles(word..(exact and "" or "*"), true, flags)) do
-        local m = path.join(root, i.name)
-        table.insert(matches, { match = m, type = i.type })
-        if not ismain and _ % 100 == 0 then
-            coroutine.yield()
-        end
-    end
-    return matches
+    return collect_glob_matches(word..(exact and "" or "*"), root, false, flags, builder)
 end
 
 --------------------------------------------------------------------------------
@@ -2617,6 +2880,29 @@ function clink.filematchesexact(match_word)
     return file_matches_impl(match_word, true)
 end
 
+--------------------------------------------------------------------------------
+local function builtin_glob_matches(impl, exact)
+    return function (word, builder)
+        -- Only the main coroutine streams matches into the builder; otherwise
+        -- the matches are returned, the same as calling the function.
+        local _, ismain = coroutine.running()
+        return impl(word, exact, ismain and builder or nil) or {}
+    end
+end
+
+_builtin_glob_matches = {
+    [clink.dirmatches] = builtin_glob_matches(dir_matches_impl),
+    [clink.dirmatchesexact] = builtin_glob_matches(dir_matches_impl, true),
+    [clink.filematches] = builtin_glob_matches(file_matches_impl),
+    [clink.filematchesexact] = builtin_glob_matches(file_matches_impl, true),
+}
+
+--------------------------------------------------------------------------------
+-- UNDOCUMENTED; internal use only.
+function clink._addfilematches(builder, match_word)
+    file_matches_impl(match_word, nil, builder)
+end
+
 --------------------------------------------------------------------------------
 --- -name:  clink.argmatcherloader
 --- -ver:   1.8.6
@@ -2675,6 +2961,12 @@ end
 local function _is_argmatcher_loaded(command_word, quoted, no_cmd)
     local argmatcher
 
+    load_deferred_scripts(command_word)
+    load_deferred_scripts(path.getname(command_word))
+    if path.isexecext(command_word) then
+        load_deferred_scripts(path.getbasename(command_word))
+    end
+
     repeat
         -- Check for an exact match.
         argmatcher = _argmatchers[command_word]
@@ -3779,6 +4071,12 @@ function clink._diag_completions_dirs(arg)
     clink.print("", "commands searched:", attempted)
     clink.print("", "Lua scripts loaded:", loaded)
     clink.print("", "argmatchers loaded:", found)
+
+    if _deferred_count > 0 then
+        clink.print("  deferred scripts:")
+        clink.print("", "deferred at startup:", _deferred_count)
+        clink.print("", "loaded on demand:", _deferred_loaded)
+    end
 end
 
 
@@ -3890,6 +4188,8 @@ end
 --- -show:  -- having both "old_second" and "new_second" as a second argument.
 function clink.arg.register_parser(cmd, parser)
     cmd = path.normalise(clink.lower(cmd))
+    load_deferred_scripts(cmd)
+    record_argmatcher_name(cmd)
 
     if not parser or getmetatable(parser) ~= _argmatcher then
         local p = clink.arg.new_parser()
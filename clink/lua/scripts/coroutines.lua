@@ -11,6 +11,11 @@ local _coroutines_resumable = false     -- When false, coroutines will no longer
 local _coroutine_yieldguard = {}        -- Which coroutine is yielding inside popenyield, for a given category of coroutines.
 local _coroutine_context = nil          -- Context for queuing io.popenyield calls from a same source.
 local _coroutine_generation = 0         -- ID for current generation of coroutines.
+local _coroutine_ids = {}               -- Map from scheduler id to entry in _coroutines.
+local _next_coroutine_id = 0            -- Last scheduler id assigned.
+local _queued = {}                      -- Entries queued behind a yieldguard, in order, for a given category.
+local _resuming = nil                   -- Coroutine being resumed by _resume_coroutines.
+local _scheduler = clink._make_coroutine_scheduler()
 
 local _dead = nil                       -- List of dead coroutines (only when "lua.debug" is set, or in DEBUG builds).
 local _trimmed = 0                      -- Number of coroutines discarded from the dead list (overflow).
@@ -38,6 +43,7 @@ local print = clink.print
 --      state:          Global state context for the coroutine (contains variables that are swapped).
 --      co_state:       Global state context for the coroutine (the table itself is swapped).
 --      src:            The source code file and line for the coroutine function.
+--      id:             Identifies the coroutine to the scheduler.
 --
 --  Updated by the coroutine management system:
 --      resumed:        Number of times the coroutine has been resumed.
@@ -48,6 +54,44 @@ local print = clink.print
 --      queued:         Use INFINITE wait for this coroutine; it's queued inside popenyield.
 --      yieldguard:     Yielding due to io.popen, os.execute, etc.
 --      asyncyield:     Yielding due to an async_lua_task.
+--
+-- The scheduler only hands back coroutines that are due:  each coroutine is
+-- either timed (due at next_entry_target()), waiting (woken when its yieldguard
+-- is released or its asyncyield completes), or ready.  Whenever a coroutine's
+-- state may have changed it is rescheduled via schedule_entry().
+
+--------------------------------------------------------------------------------
+local next_entry_target
+
+--------------------------------------------------------------------------------
+local function schedule_entry(entry, now)
+    local id = entry.id
+    if coroutine.status(entry.coroutine) == "dead" then
+        -- Make it due right away, so the next pass removes it.
+        _scheduler:schedule(id, 0)
+    elseif entry.yieldguard or entry.queued then
+        -- Woken when its yieldguard (or the one it's queued behind) is released.
+        _scheduler:wait(id)
+    elseif entry.asyncyield and not entry.asyncyield:ready() then
+        -- Woken when the asyncyield completes or expires.
+        _scheduler:wait(id, entry.asyncyield)
+    else
+        _scheduler:schedule(id, next_entry_target(entry, now or os.clock()))
+    end
+end
+
+--------------------------------------------------------------------------------
+local function unqueue_entry(entry)
+    local queued = entry.yield_category and _queued[entry.yield_category]
+    if queued then
+        for i, e in ipairs(queued) do
+            if e == entry then
+                table.remove(queued, i)
+                break
+            end
+        end
+    end
+end
 
 --------------------------------------------------------------------------------
 local function clear_coroutines()
@@ -65,6 +109,8 @@ local function clear_coroutines()
     end
 
     _coroutines = {}
+    _coroutine_ids = {}
+    _queued = {}
     _after_coroutines = {}
     _coroutines_resumable = false
     -- Don't touch _coroutine_yieldguard; it only gets cleared when the thread finishes.
@@ -79,9 +125,18 @@ local function clear_coroutines()
         _throttle_interval = nil
     end
 
+    _scheduler:clear()
     for _, entry in ipairs(preserve) do
-        _coroutines[entry.coroutine] = entry
-        _coroutines_resumable = true
+        if not _coroutine_ids[entry.id] then
+            _coroutines[entry.coroutine] = entry
+            _coroutine_ids[entry.id] = entry
+            if entry.queued and entry.yield_category then
+                _queued[entry.yield_category] = _queued[entry.yield_category] or {}
+                table.insert(_queued[entry.yield_category], entry)
+            end
+            schedule_entry(entry)
+            _coroutines_resumable = true
+        end
     end
 end
 clink.onbeginedit(clear_coroutines)
@@ -96,12 +151,13 @@ local function release_coroutine_yieldguard()
                 entry.throttleclock = os.clock()
                 entry.yieldguard = nil
                 table.insert(nil_cats, category)
-                -- TODO: This is an arbitrary order, but the dequeue order
-                -- should ideally be FIFO.
-                for _,e in pairs(_coroutines) do
-                    if e.queued and e.category == category then
-                        e.queued = nil
-                        break
+                schedule_entry(entry)
+                -- Wake the coroutines queued behind the yieldguard, in the
+                -- order they queued; the first one to run claims the category.
+                local queued = _queued[category]
+                if queued then
+                    for _, e in ipairs(queued) do
+                        _scheduler:wake(e.id)
                     end
                 end
             end
@@ -148,8 +204,18 @@ end
 --------------------------------------------------------------------------------
 local function set_coroutine_queued(queued)
     local t = coroutine.running()
-    if t and _coroutines[t] then
-        _coroutines[t].queued = queued and true or nil
+    local entry = t and _coroutines[t]
+    if entry then
+        if queued and not entry.queued then
+            local category = entry.yield_category
+            if category then
+                _queued[category] = _queued[category] or {}
+                table.insert(_queued[category], entry)
+            end
+        elseif not queued and entry.queued then
+            unqueue_entry(entry)
+        end
+        entry.queued = queued and true or nil
     end
 end
 
@@ -172,7 +238,7 @@ local function check_generation(c)
 end
 
 --------------------------------------------------------------------------------
-local function next_entry_target(entry, now)
+next_entry_target = function(entry, now)
     if not entry.lastclock then
         return 0
     else
@@ -202,7 +268,7 @@ local function next_entry_target(entry, now)
         --
         -- UPDATE:  Throttling is now disabled by default, but can be enabled
         -- via the lua.throttle_interval setting.
-        local interval = entry.interval
+        local interval = entry.interval or 0
         if _throttle_interval and now and interval < _throttle_interval then
             local throttleclock = entry.throttleclock or entry.firstclock
             if throttleclock and now - throttleclock > 5 then
@@ -215,16 +281,6 @@ local function next_entry_target(entry, now)
     end
 end
 
---------------------------------------------------------------------------------
-local function is_entry_ready(entry, now)
-    if not entry.asyncyield or entry.asyncyield:ready() then
-        return true
-    else
-        local expiration = entry.asyncyield:getexpiration()
-        return (expiration and expiration <= now)
-    end
-end
-
 --------------------------------------------------------------------------------
 function clink._after_coroutines(func)
     if type(func) ~= "function" then
@@ -241,25 +297,8 @@ end
 --------------------------------------------------------------------------------
 function clink._wait_duration()
     if _coroutines_resumable then
-        local target
-        local now = os.clock()
         release_coroutine_yieldguard()  -- Dequeue next if necessary.
-        for _,entry in pairs(_coroutines) do
-            local this_target = next_entry_target(entry, now)
-            if entry.yieldguard or entry.queued then -- luacheck: ignore 542
-                -- Yield until output is ready; don't influence the timeout.
-            elseif entry.asyncyield and
-                    not entry.asyncyield:ready() and
-                    not entry.asyncyield:getexpiration() then -- luacheck: ignore 542
-                -- Don't resume until asyncyield says it's ready; don't
-                -- influence the timeout.
-            elseif not target or target > this_target then
-                target = this_target
-            end
-        end
-        if target then
-            return target - now
-        end
+        return _scheduler:duration(os.clock())
     end
 end
 
@@ -284,37 +323,38 @@ function clink._resume_coroutines()
         return
     end
 
-    local remove
-
     -- Prepare.
     _coroutines_resumable = false
     _coroutines_fallback_state = {}
     clink._set_coroutine_context(nil)
 
-    -- Remove dead/obsolete coroutines.  Must remove old gen coroutines first,
-    -- since removing them may free up new gen coroutines to be resumable.
-    remove = {}
-    for c,entry in pairs(_coroutines) do
-        if coroutine.status(c) == "dead" then
-            table.insert(remove, c)
-        elseif not check_generation(c) and (not entry.yieldguard or entry.yieldguard:ready()) then
-            entry.canceled = true
-            table.insert(remove, c)
-        end
-    end
-    for _,c in ipairs(remove) do
-        clink.removecoroutine(c)
-    end
+    -- Releasing a finished yieldguard wakes its coroutine and any coroutines
+    -- queued behind it.
+    release_coroutine_yieldguard()
+
+    -- Only coroutines that are due or have been woken are visited.
+    local due = _scheduler:due(os.clock())
 
     -- Protected call to resume coroutines.
     local co
-    remove = {}
+    local index = 0
     local impl = function()
-        for c,entry in pairs(_coroutines) do
+        while index < #due do
+            index = index + 1
+            local entry = _coroutine_ids[due[index]]
+            local c = entry and entry.coroutine
             co = c
-            _coroutines_resumable = true
-            local now = os.clock()
-            if next_entry_target(entry, now) <= now and is_entry_ready(entry, now) then
+            if not entry or _coroutines[c] ~= entry then -- luacheck: ignore 542
+                -- Already removed.
+            elseif coroutine.status(c) == "dead" then
+                clink.removecoroutine(c)
+            elseif not check_generation(c) and (not entry.yieldguard or entry.yieldguard:ready()) then
+                -- Remove obsolete coroutines; this may free up new generation
+                -- coroutines to be resumable.
+                entry.canceled = true
+                clink.removecoroutine(c)
+            else
+                local now = os.clock()
                 if not entry.firstclock then
                     entry.firstclock = now
                 end
@@ -323,12 +363,16 @@ function clink._resume_coroutines()
                 end
                 entry.resumed = entry.resumed + 1
                 clink._set_coroutine_context(entry.context)
+                _coroutines_resumable = true
+                local prev_resuming = _resuming
+                _resuming = c
                 local ok, ret
                 if entry.isprompt or entry.isgenerator then
                     ok, ret = coroutine.resume(c, true--[[async]])
                 else
                     ok, ret = coroutine.resume(c)
                 end
+                _resuming = prev_resuming
                 if ok then
                     -- Use live clock so the interval excludes the execution
                     -- time of the coroutine.
@@ -342,7 +386,9 @@ function clink._resume_coroutines()
                     end
                 end
                 if coroutine.status(c) == "dead" then
-                    table.insert(remove, c)
+                    clink.removecoroutine(c)
+                else
+                    schedule_entry(entry, entry.lastclock)
                 end
             end
         end
@@ -354,15 +400,20 @@ function clink._resume_coroutines()
         print("")
         print("coroutine failed:")
         _co_error_handler(co, ret)
-        -- Don't return yet!  Need to do cleanup.
+        -- Don't return yet!  Need to do cleanup.  The coroutines that didn't
+        -- get visited were already taken from the scheduler; put them back.
+        for i = index, #due, 1 do
+            local entry = _coroutine_ids[due[i]]
+            if entry and _coroutines[entry.coroutine] == entry then
+                schedule_entry(entry)
+            end
+        end
     end
 
     -- Cleanup.
     _coroutines_fallback_state = {}
     clink._set_coroutine_context(nil)
-    for _,c in ipairs(remove) do
-        clink.removecoroutine(c)
-    end
+    _coroutines_resumable = next(_coroutines) and true or false
     if _dead and #_dead > 20 then
         -- Trim the dead list to 20 entries.
         local t = {}
@@ -588,6 +639,8 @@ function clink._diag_coroutines()
         end
         print("  resumable", _coroutines_resumable)
         print("  wait_duration", clink._wait_duration())
+        local stats = _scheduler:stats()
+        print("  scheduled", string.format("timed %d, waiting %d, ready %d", stats.timed, stats.waiting, stats.ready))
         for category, cyg in spairs(_coroutine_yieldguard) do
             local yg = cyg.yieldguard
             print("  "..category)
@@ -696,8 +749,10 @@ function clink.addcoroutine(c, interval)
     end
 
     -- Change the interval for a coroutine.
-    if _coroutines[c] and not _coroutines[c].throttled then
-        _coroutines[c].interval = interval
+    local entry = _coroutines[c]
+    if entry and not entry.throttled then
+        entry.interval = interval
+        schedule_entry(entry)
     end
 end
 
@@ -721,6 +776,14 @@ function clink.removecoroutine(c)
                 table.insert(_dead, entry)
             end
         end
+        local entry = _coroutines[c]
+        if entry then
+            if entry.queued then
+                unqueue_entry(entry)
+            end
+            _coroutine_ids[entry.id] = nil
+            _scheduler:remove(entry.id)
+        end
         _coroutines[c] = nil
         _coroutines_resumable = false
         for _ in pairs(_coroutines) do -- luacheck: ignore 512
@@ -767,7 +830,9 @@ function clink.setcoroutineinterval(c, interval)
     -- Override the interval.  The scheduler never trusts the interval, so it's
     -- ok to blindly set the interval here even if the coroutine is currently
     -- being throttled.
-    _coroutines[c].interval = interval
+    local entry = _coroutines[c]
+    entry.interval = interval
+    schedule_entry(entry)
 end
 
 --------------------------------------------------------------------------------
@@ -1104,8 +1169,12 @@ function coroutine.create(func) -- luacheck: ignore 122
     save_coroutine_state(entry)
 
     local thread = orig_coroutine_create(func)
+    _next_coroutine_id = _next_coroutine_id + 1
     entry.coroutine = thread
+    entry.id = _next_coroutine_id
     _coroutines[thread] = entry
+    _coroutine_ids[entry.id] = entry
+    _scheduler:schedule(entry.id, 0)
 
     -- Wake up idle processing.
     _coroutines_resumable = true
@@ -1138,6 +1207,12 @@ function coroutine.resume(co, ...) -- luacheck: ignore 122
     clink.co_state = old_co_state
     save_coroutine_state(entry, co)
 
+    -- Coroutines resumed outside of _resume_coroutines (e.g. to run them up to
+    -- the first yield) may have changed what they're waiting for.
+    if entry and co ~= _resuming and _coroutines[co] == entry then
+        schedule_entry(entry)
+    end
+
     if _pending_on_main then
         local _, ismain = coroutine.running()
         if ismain then
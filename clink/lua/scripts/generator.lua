@@ -113,7 +113,7 @@ end
 --------------------------------------------------------------------------------
 function file_match_generator:generate(line_state, match_builder) -- luacheck: no self
     local root = line_state:getendword()
-    match_builder:addmatches(clink.filematches(root))
+    clink._addfilematches(match_builder, root)
     return true
 end
 
@@ -6,6 +6,7 @@
 #include "lua_input_idle.h"
 #include "lua_task_manager.h"
 #include "async_lua_task.h"
+#include "coroutine_scheduler.h"
 
 #include <core/os.h>
 #include <core/str_unordered_set.h>
@@ -339,6 +340,28 @@ async_yield_lua::~async_yield_lua()
 {
 }
 
+//------------------------------------------------------------------------------
+void async_yield_lua::set_ready()
+{
+    std::lock_guard<std::mutex> lock(m_waker_mutex);
+    m_ready = true;
+    if (m_waker)
+        m_waker->post(m_waker_id, m_waker_seq);
+}
+
+//------------------------------------------------------------------------------
+void async_yield_lua::set_waker(const std::shared_ptr<coroutine_wake_queue>& waker, int32 id, uint32 seq)
+{
+    std::lock_guard<std::mutex> lock(m_waker_mutex);
+    m_waker = waker;
+    m_waker_id = id;
+    m_waker_seq = seq;
+
+    // Already ready; wake the coroutine right away.
+    if (m_ready && m_waker)
+        m_waker->post(m_waker_id, m_waker_seq);
+}
+
 //------------------------------------------------------------------------------
 int32 async_yield_lua::get_name(lua_State* state)
 {
@@ -6,9 +6,11 @@
 #include <core/str.h>
 
 #include <memory>
+#include <mutex>
 #include <thread>
 
 class lua_state;
+class coroutine_wake_queue;
 
 //------------------------------------------------------------------------------
 struct callback_ref
@@ -26,8 +28,10 @@ public:
                             ~async_yield_lua();
 
     bool                    is_expired() const;
-    void                    set_ready() { m_ready = true; }
+    double                  get_expiration_time() const { return m_expiration; }
+    void                    set_ready();
     void                    clear_ready() { m_ready = false; }
+    void                    set_waker(const std::shared_ptr<coroutine_wake_queue>& waker, int32 id, uint32 seq);
 
 protected:
     int32                   get_name(lua_State* state);
@@ -39,6 +43,13 @@ private:
     double                  m_expiration = 0.0;
     bool                    m_ready = false;
 
+    // Wakes the waiting coroutine in the scheduler; set_ready() may be called
+    // from a background thread.
+    std::mutex              m_waker_mutex;
+    std::shared_ptr<coroutine_wake_queue> m_waker;
+    int32                   m_waker_id = 0;
+    uint32                  m_waker_seq = 0;
+
     friend class lua_bindable<async_yield_lua>;
     static const char* const c_name;
     static const method c_methods[];
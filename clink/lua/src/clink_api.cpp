@@ -8,6 +8,7 @@
 #include "line_states_lua.h"
 #include "prompt.h"
 #include "async_lua_task.h"
+#include "coroutine_scheduler.h"
 #include "command_link_dialog.h"
 #include "sessionstream.h"
 #include "../../app/src/version.h" // Ugh.
@@ -744,7 +745,7 @@ static bool popup_del_callback(int32 index)
 /// -show:      height          = 20,       -- Preferred height, not counting the border.
 /// -show:      width           = 60,       -- Preferred width, not counting the border.
 /// -show:      reverse         = true,     -- Start at bottom; search upwards.
-/// -show:      searchmode      = "filter", -- Use "find" or "filter" to override the default search mode (in v1.6.13 and higher).
+/// -show:      searchmode      = "filter", -- Use "find", "filter", or "fuzzy" to override the default search mode (in v1.6.13 and higher; "fuzzy" in v1.9.23 and higher).
 /// -show:      colors = {                  -- Override the popup colors using any colors in this table.
 /// -show:          items       = "97;44",  -- The items color (e.g. bright white on blue).
 /// -show:          desc        = "...",    -- The description color.
@@ -898,6 +899,8 @@ static int32 popup_list(lua_State* state)
                 config.search_mode = 0;
             else if (stricmp(searchmode, "filter") == 0)
                 config.search_mode = 1;
+            else if (stricmp(searchmode, "fuzzy") == 0)
+                config.search_mode = 2;
         }
     }
     lua_pop(state, 1);
@@ -1595,6 +1598,19 @@ again:
     return 0;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// The host replaces this with a version that can use precompiled bytecode.
+static int32 load_deferred_script(lua_State* state)
+{
+    const char* file = checkstring(state, 1);
+    if (!file)
+        return 0;
+
+    lua_pushboolean(state, lua_state::do_file(state, file, nullptr, 0, nullptr));
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 // UNDOCUMENTED; internal use only.
 static int32 set_suggestion_started(lua_State* state)
@@ -2757,9 +2773,11 @@ void clink_lua_initialise(lua_state& lua, bool lua_interpreter)
         { 0,    "_acquire_updater_mutex", &acquire_updater_mutex },
         { 0,    "_release_updater_mutex", &release_updater_mutex },
         { 0,    "_get_scripts_path",      &get_scripts_path },
+        { 1,    "_load_deferred_script",  &load_deferred_script },
         { 1,    "_is_break_on_error",     &is_break_on_error },
         { 1,    "_unzip_internal",        &_unzip_internal },
         { 0,    "_make_ftsc",             &_make_ftsc },
+        { 0,    "_make_coroutine_scheduler", &coroutine_scheduler::make },
 #if defined(DEBUG) && defined(_MSC_VER)
 #if defined(USE_MEMORY_TRACKING)
         { 0,    "last_allocation_number", &last_allocation_number },
@@ -0,0 +1,375 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "coroutine_scheduler.h"
+#include "async_lua_task.h"
+#include "lua_state.h"
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+static const char c_registry_key[] = "clink_coroutine_scheduler";
+
+enum : uint8
+{
+    state_none,     // Not scheduled; e.g. currently being resumed.
+    state_timed,
+    state_waiting,
+    state_ready,
+};
+
+
+
+//------------------------------------------------------------------------------
+void coroutine_wake_queue::post(int32 id, uint32 seq)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_signals.emplace_back(id, seq);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_wake_queue::take(std::vector<std::pair<int32, uint32>>& out)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out.swap(m_signals);
+}
+
+
+
+//------------------------------------------------------------------------------
+const char* const coroutine_scheduler::c_name = "coroutine_scheduler";
+const coroutine_scheduler::method coroutine_scheduler::c_methods[] = {
+    { "schedule",       &schedule },
+    { "wait",           &wait },
+    { "wake",           &wake },
+    { "remove",         &remove },
+    { "clear",          &clear },
+    { "due",            &due },
+    { "duration",       &duration },
+    { "stats",          &stats },
+    {}
+};
+
+//------------------------------------------------------------------------------
+coroutine_scheduler::coroutine_scheduler()
+: m_wake_queue(std::make_shared<coroutine_wake_queue>())
+{
+}
+
+//------------------------------------------------------------------------------
+coroutine_scheduler* coroutine_scheduler::find(lua_State* state)
+{
+    save_stack_top ss(state);
+    lua_getfield(state, LUA_REGISTRYINDEX, c_registry_key);
+    return test(state, -1);
+}
+
+//------------------------------------------------------------------------------
+int32 coroutine_scheduler::make(lua_State* state)
+{
+    make_new(state);
+
+    // The registry reference lets the idle loop reach the scheduler without
+    // calling into Lua.
+    lua_pushvalue(state, -1);
+    lua_setfield(state, LUA_REGISTRYINDEX, c_registry_key);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+bool coroutine_scheduler::later(const timer& a, const timer& b)
+{
+    // Orders the heap by earliest time, then by first scheduled.
+    if (a.when != b.when)
+        return a.when > b.when;
+    return a.order > b.order;
+}
+
+//------------------------------------------------------------------------------
+coroutine_scheduler::slot& coroutine_scheduler::reset_slot(int32 id)
+{
+    slot& s = m_slots[id];
+    ++s.seq;
+    return s;
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::push_timer(int32 id, uint32 seq, double when)
+{
+    // Rescheduling leaves stale timers behind; purge them if they start to
+    // outnumber the live ones.
+    if (m_heap.size() >= 64 && m_heap.size() > m_slots.size() * 2)
+    {
+        m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(), [this](const timer& t) {
+            return !is_live(t);
+        }), m_heap.end());
+        std::make_heap(m_heap.begin(), m_heap.end(), &later);
+    }
+
+    m_heap.push_back({ when, m_order++, id, seq });
+    std::push_heap(m_heap.begin(), m_heap.end(), &later);
+}
+
+//------------------------------------------------------------------------------
+bool coroutine_scheduler::is_live(const timer& t) const
+{
+    const auto iter = m_slots.find(t.id);
+    if (iter == m_slots.end() || iter->second.seq != t.seq)
+        return false;
+    return iter->second.state == state_timed || iter->second.state == state_waiting;
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::schedule(int32 id, double when)
+{
+    slot& s = reset_slot(id);
+    s.state = state_timed;
+    push_timer(id, s.seq, when);
+}
+
+//------------------------------------------------------------------------------
+uint32 coroutine_scheduler::wait(int32 id)
+{
+    slot& s = reset_slot(id);
+    s.state = state_waiting;
+    return s.seq;
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::wake(int32 id)
+{
+    const auto iter = m_slots.find(id);
+    if (iter == m_slots.end() || iter->second.state == state_ready)
+        return;
+
+    slot& s = iter->second;
+    ++s.seq;
+    s.state = state_ready;
+    m_ready.emplace_back(id, s.seq);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::remove(int32 id)
+{
+    m_slots.erase(id);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::clear()
+{
+    m_slots.clear();
+    m_heap.clear();
+    m_ready.clear();
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::drain_signals()
+{
+    m_wake_queue->take(m_signals);
+
+    for (const auto& signal : m_signals)
+    {
+        const auto iter = m_slots.find(signal.first);
+        if (iter != m_slots.end() &&
+            iter->second.seq == signal.second &&
+            iter->second.state == state_waiting)
+            wake(signal.first);
+    }
+
+    m_signals.clear();
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::take_due(double now, std::vector<int32>& out)
+{
+    drain_signals();
+
+    // Ready coroutines go first, in the order they became ready.
+    for (const auto& ready : m_ready)
+    {
+        const auto iter = m_slots.find(ready.first);
+        if (iter != m_slots.end() &&
+            iter->second.seq == ready.second &&
+            iter->second.state == state_ready)
+        {
+            iter->second.state = state_none;
+            out.push_back(ready.first);
+        }
+    }
+    m_ready.clear();
+
+    while (!m_heap.empty() && m_heap.front().when <= now)
+    {
+        const timer t = m_heap.front();
+        std::pop_heap(m_heap.begin(), m_heap.end(), &later);
+        m_heap.pop_back();
+
+        if (is_live(t))
+        {
+            m_slots[t.id].state = state_none;
+            out.push_back(t.id);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+bool coroutine_scheduler::get_wait(double now, double& wait)
+{
+    drain_signals();
+
+    for (const auto& ready : m_ready)
+    {
+        const auto iter = m_slots.find(ready.first);
+        if (iter != m_slots.end() &&
+            iter->second.seq == ready.second &&
+            iter->second.state == state_ready)
+        {
+            wait = 0;
+            return true;
+        }
+    }
+
+    // Discard stale timers so the top of the heap is meaningful.
+    while (!m_heap.empty() && !is_live(m_heap.front()))
+    {
+        std::pop_heap(m_heap.begin(), m_heap.end(), &later);
+        m_heap.pop_back();
+    }
+
+    if (m_heap.empty())
+        return false;
+
+    wait = m_heap.front().when - now;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+int32 coroutine_scheduler::schedule(lua_State* state)
+{
+    const auto id = checkinteger(state, LUA_SELF + 1);
+    const auto when = checknumber(state, LUA_SELF + 2);
+    if (!id.isnum() || !when.isnum())
+        return 0;
+
+    schedule(id, when);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Optional arg #2 is an asyncyield; when it signals completion the coroutine
+// becomes ready, and if it has an expiration then the coroutine is also due
+// at that time.
+int32 coroutine_scheduler::wait(lua_State* state)
+{
+    const auto id = checkinteger(state, LUA_SELF + 1);
+    if (!id.isnum())
+        return 0;
+
+    const uint32 seq = wait(id);
+
+    if (async_yield_lua* asyncyield = async_yield_lua::test(state, LUA_SELF + 2))
+    {
+        const double expiration = asyncyield->get_expiration_time();
+        if (expiration > 0)
+            push_timer(id, seq, expiration);
+        asyncyield->set_waker(m_wake_queue, id, seq);
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int32 coroutine_scheduler::wake(lua_State* state)
+{
+    const auto id = checkinteger(state, LUA_SELF + 1);
+    if (!id.isnum())
+        return 0;
+
+    wake(id);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int32 coroutine_scheduler::remove(lua_State* state)
+{
+    const auto id = checkinteger(state, LUA_SELF + 1);
+    if (!id.isnum())
+        return 0;
+
+    remove(id);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int32 coroutine_scheduler::clear(lua_State* state)
+{
+    clear();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int32 coroutine_scheduler::due(lua_State* state)
+{
+    const auto now = checknumber(state, LUA_SELF + 1);
+    if (!now.isnum())
+        return 0;
+
+    std::vector<int32> ids;
+    take_due(now, ids);
+
+    lua_createtable(state, int32(ids.size()), 0);
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        lua_pushinteger(state, ids[i]);
+        lua_rawseti(state, -2, int32(i + 1));
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int32 coroutine_scheduler::duration(lua_State* state)
+{
+    const auto now = checknumber(state, LUA_SELF + 1);
+    if (!now.isnum())
+        return 0;
+
+    double wait;
+    if (!get_wait(now, wait))
+        return 0;
+
+    lua_pushnumber(state, wait);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int32 coroutine_scheduler::stats(lua_State* state)
+{
+    uint32 timed = 0;
+    uint32 waiting = 0;
+    uint32 ready = 0;
+    for (const auto& s : m_slots)
+    {
+        switch (s.second.state)
+        {
+        case state_timed:   ++timed; break;
+        case state_waiting: ++waiting; break;
+        case state_ready:   ++ready; break;
+        }
+    }
+
+    lua_createtable(state, 0, 4);
+
+    lua_pushinteger(state, timed);
+    lua_setfield(state, -2, "timed");
+
+    lua_pushinteger(state, waiting);
+    lua_setfield(state, -2, "waiting");
+
+    lua_pushinteger(state, ready);
+    lua_setfield(state, -2, "ready");
+
+    lua_pushinteger(state, int32(m_heap.size()));
+    lua_setfield(state, -2, "heap");
+
+    return 1;
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "lua_bindable.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Collects wake signals for coroutines.  Signals may be posted from any
+// thread; the scheduler drains them on the main thread.
+class coroutine_wake_queue
+{
+public:
+    void                    post(int32 id, uint32 seq);
+    void                    take(std::vector<std::pair<int32, uint32>>& out);
+
+private:
+    std::mutex              m_mutex;
+    std::vector<std::pair<int32, uint32>> m_signals;
+};
+
+//------------------------------------------------------------------------------
+// Schedules coroutines by wake time instead of by polling.  Each coroutine is
+// identified by an id assigned by coroutines.lua, and is in one of these
+// states:
+//
+//  - Timed:    in a min-heap keyed by the clock time when it's due.
+//  - Waiting:  blocked until something wakes it (a yieldguard is released or
+//              an asyncyield signals completion).
+//  - Ready:    in a FIFO queue, due immediately.
+//
+// Rescheduling a coroutine bumps its sequence number, which lazily invalidates
+// any older heap entries or wake signals for it.
+class coroutine_scheduler
+    : public lua_bindable<coroutine_scheduler>
+{
+    struct slot
+    {
+        uint32              seq = 0;
+        uint8               state = 0;
+    };
+
+    struct timer
+    {
+        double              when;
+        uint64              order;
+        int32               id;
+        uint32              seq;
+    };
+
+public:
+                            coroutine_scheduler();
+                            ~coroutine_scheduler() = default;
+
+    static coroutine_scheduler* find(lua_State* state);
+    static int32            make(lua_State* state);
+
+    void                    schedule(int32 id, double when);
+    uint32                  wait(int32 id);
+    void                    wake(int32 id);
+    void                    remove(int32 id);
+    void                    clear();
+    void                    take_due(double now, std::vector<int32>& out);
+    bool                    get_wait(double now, double& wait);
+    const std::shared_ptr<coroutine_wake_queue>& get_wake_queue() const { return m_wake_queue; }
+
+protected:
+    int32                   schedule(lua_State* state);
+    int32                   wait(lua_State* state);
+    int32                   wake(lua_State* state);
+    int32                   remove(lua_State* state);
+    int32                   clear(lua_State* state);
+    int32                   due(lua_State* state);
+    int32                   duration(lua_State* state);
+    int32                   stats(lua_State* state);
+
+private:
+    static bool             later(const timer& a, const timer& b);
+    slot&                   reset_slot(int32 id);
+    void                    drain_signals();
+    void                    push_timer(int32 id, uint32 seq, double when);
+    bool                    is_live(const timer& t) const;
+
+    std::unordered_map<int32, slot> m_slots;
+    std::vector<timer>      m_heap;
+    std::vector<std::pair<int32, uint32>> m_ready;
+    std::vector<std::pair<int32, uint32>> m_signals;
+    std::shared_ptr<coroutine_wake_queue> m_wake_queue;
+    uint64                  m_order = 0;
+
+    friend class lua_bindable<coroutine_scheduler>;
+    static const char* const c_name;
+    static const method c_methods[];
+};
@@ -8,6 +8,7 @@
 #include <core/array.h>
 #include <lib/line_state.h>
 #include <lib/cmd_tokenisers.h>
+#include <lib/word_collector.h>
 
 //------------------------------------------------------------------------------
 const char* const line_state_lua::c_name = "line_state_lua";
@@ -189,6 +190,15 @@ line_state_lua::line_state_lua(line_state_copy* copy, uint32 shift)
     m_tested_cmd_builtin = copy->is_tested_cmd_builtin();
 }
 
+//------------------------------------------------------------------------------
+line_state_lua::line_state_lua(std::shared_ptr<const command_line_snapshot> snapshot, uint32 index)
+{
+    // Shares the snapshot instead of copying the line and words.
+    m_line = &snapshot->get_linestates()[index];
+    m_copy = nullptr;
+    m_snapshot = std::move(snapshot);
+}
+
 //------------------------------------------------------------------------------
 line_state_lua::~line_state_lua()
 {
@@ -660,6 +670,17 @@ int32 line_state_lua::overwrite_from(lua_State* state)
     if (!from)
         return 0;
 
+    // A snapshot is shared by every line_state object made from it (e.g. the
+    // "line" and "lines" arguments), so detach to a private copy before
+    // overwriting it.
+    if (m_snapshot)
+    {
+        assert(!m_copy);
+        m_copy = make_line_state_copy(*m_line);
+        m_line = m_copy->get_line();
+        m_snapshot.reset();
+    }
+
     const bool ok = const_cast<line_state*>(m_line)->overwrite_from(from->m_line);
     assert(ok);
     lua_pushboolean(state, ok);
@@ -5,7 +5,10 @@
 
 #include "lua_bindable.h"
 
+#include <memory>
+
 class line_state;
+class command_line_snapshot;
 class line_state_copy;
 struct lua_State;
 
@@ -19,6 +22,7 @@ class line_state_lua
 public:
                         line_state_lua(const line_state& line);
                         line_state_lua(line_state_copy* copy, uint32 shift);
+                        line_state_lua(std::shared_ptr<const command_line_snapshot> snapshot, uint32 index);
                         ~line_state_lua();
 
     const line_state*   get_line_state() const { return m_line; }
@@ -47,6 +51,7 @@ protected:
 private:
     const line_state*   m_line;
     line_state_copy*    m_copy;
+    std::shared_ptr<const command_line_snapshot> m_snapshot;
     uint32              m_shift = 0;
     bool                m_tested_cmd_builtin = false;
 
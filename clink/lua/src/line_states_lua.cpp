@@ -11,6 +11,7 @@
 #include <core/base.h>
 #include <lib/line_state.h>
 #include <lib/word_classifications.h>
+#include <lib/word_collector.h>
 
 #include <assert.h>
 
@@ -80,3 +81,21 @@ void line_states_lua::make_new(lua_State* state, const line_states& lines)
         lua_rawseti(state, -2, int32(++ii));
     }
 }
+
+//------------------------------------------------------------------------------
+void line_states_lua::make_new(lua_State* state, const std::shared_ptr<const command_line_snapshot>& snapshot)
+{
+    // Package the lua objects into a table; they share the snapshot.
+    const line_states& lines = snapshot->get_linestates();
+    lua_createtable(state, int32(lines.size()), 0);
+    for (size_t ii = 0; ii < lines.size();)
+    {
+        lua_createtable(state, 0, 2);
+
+        lua_pushliteral(state, "line_state");
+        line_state_lua::make_new(state, snapshot, uint32(ii));
+        lua_rawset(state, -3);
+
+        lua_rawseti(state, -2, int32(++ii));
+    }
+}
@@ -6,9 +6,11 @@
 #include "line_state_lua.h"
 #include "lua_word_classifications.h"
 
+#include <memory>
 #include <vector>
 
 class line_states;
+class command_line_snapshot;
 
 //------------------------------------------------------------------------------
 class line_states_lua
@@ -19,6 +21,7 @@ public:
                         ~line_states_lua() = default;
     void                push(lua_State* state);
     static void         make_new(lua_State* state, const line_states& lines);
+    static void         make_new(lua_State* state, const std::shared_ptr<const command_line_snapshot>& snapshot);
 private:
     std::vector<line_state_lua> m_lines;
     std::vector<lua_word_classifications> m_classifications;
@@ -0,0 +1,218 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_allocator.h"
+
+#include <core/base.h>
+#include <core/debugheap.h>
+
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+// Allocating this many bytes since the last idle collection finished makes
+// another one worthwhile.
+static const uint64 c_gc_work_threshold = 256 * 1024;
+
+//------------------------------------------------------------------------------
+#ifdef USE_MEMORY_TRACKING
+extern "C" DECLALLOCATOR DECLRESTRICT void* __cdecl dbgluarealloc(void* pv, size_t size);
+#endif
+
+//------------------------------------------------------------------------------
+static void* heap_realloc(void* ptr, size_t size)
+{
+#ifdef USE_MEMORY_TRACKING
+    return dbgluarealloc(ptr, size);
+#else
+    return realloc(ptr, size);
+#endif
+}
+
+
+
+//------------------------------------------------------------------------------
+lua_allocator::~lua_allocator()
+{
+    for (void* chunk : m_chunks)
+        free(chunk);
+}
+
+//------------------------------------------------------------------------------
+// The lua_Alloc function.  When ptr is nullptr, osize is a type code rather
+// than a size.
+void* lua_allocator::alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+    lua_allocator* self = static_cast<lua_allocator*>(ud);
+
+    if (!ptr)
+        return nsize ? self->allocate(nsize) : nullptr;
+
+    if (!nsize)
+    {
+        self->deallocate(ptr, osize);
+        return nullptr;
+    }
+
+    return self->reallocate(ptr, osize, nsize);
+}
+
+//------------------------------------------------------------------------------
+uint32 lua_allocator::size_class(size_t size)
+{
+    assert(size);
+    const size_t sc = (size - 1) / c_granularity;
+    return (sc < c_num_classes) ? uint32(sc) : c_num_classes;
+}
+
+//------------------------------------------------------------------------------
+bool lua_allocator::grow_pool(uint32 sc)
+{
+    char* chunk = static_cast<char*>(heap_realloc(nullptr, c_chunk_size));
+    if (!chunk)
+        return false;
+
+    m_chunks.push_back(chunk);
+
+    // Thread the chunk's blocks onto the free list.
+    const uint32 block_size = (sc + 1) * c_granularity;
+    const uint32 count = c_chunk_size / block_size;
+    for (uint32 i = count; i--;)
+    {
+        free_block* block = reinterpret_cast<free_block*>(chunk + i * block_size);
+        block->next = m_free[sc];
+        m_free[sc] = block;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void* lua_allocator::allocate(size_t size)
+{
+    void* ptr;
+    const uint32 sc = size_class(size);
+    if (sc < c_num_classes)
+    {
+        if (!m_free[sc] && !grow_pool(sc))
+            return nullptr;
+        free_block* block = m_free[sc];
+        m_free[sc] = block->next;
+        ptr = block;
+    }
+    else
+    {
+        ptr = heap_realloc(nullptr, size);
+        if (!ptr)
+            return nullptr;
+    }
+
+    m_in_use += size;
+    m_allocated += size;
+    return ptr;
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator::deallocate(void* ptr, size_t size)
+{
+    const uint32 sc = size_class(size);
+    if (sc < c_num_classes)
+    {
+        free_block* block = static_cast<free_block*>(ptr);
+        block->next = m_free[sc];
+        m_free[sc] = block;
+    }
+    else
+    {
+        free(ptr);
+    }
+
+    assert(m_in_use >= size);
+    m_in_use -= size;
+}
+
+//------------------------------------------------------------------------------
+void* lua_allocator::reallocate(void* ptr, size_t osize, size_t nsize)
+{
+    const uint32 osc = size_class(osize);
+    const uint32 nsc = size_class(nsize);
+
+    if (osc == nsc)
+    {
+        // Pooled blocks already have room for anything in their size class.
+        if (nsc == c_num_classes && !(ptr = heap_realloc(ptr, nsize)))
+            return nullptr;
+
+        m_in_use += nsize - osize;
+        if (nsize > osize)
+            m_allocated += nsize - osize;
+        return ptr;
+    }
+
+    void* moved = allocate(nsize);
+    if (!moved)
+    {
+        // Lua assumes shrinking never fails.  If the pool can't grow, then
+        // keep the block; its size class is determined by the size Lua passes
+        // when freeing it, so it simply joins the smaller size class's pool.
+        if (nsize < osize)
+        {
+            m_in_use -= osize - nsize;
+            return ptr;
+        }
+        return nullptr;
+    }
+
+    memcpy(moved, ptr, min(osize, nsize));
+    deallocate(ptr, osize);
+
+    // allocate() counted the whole new block; only growth is new allocation.
+    m_allocated -= min(osize, nsize);
+    return moved;
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator::begin_edit()
+{
+    m_prev_allocated = m_allocated - m_edit_mark;
+    m_edit_mark = m_allocated;
+    m_gc_steps = 0;
+    m_gc_cycles = 0;
+    m_gc_pause = 0;
+    m_gc_max_pause = 0;
+}
+
+//------------------------------------------------------------------------------
+bool lua_allocator::has_gc_work() const
+{
+    return m_gc_in_cycle || m_allocated - m_gc_mark >= c_gc_work_threshold;
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator::on_gc_step(double seconds, bool finished)
+{
+    ++m_gc_steps;
+    m_gc_pause += seconds;
+    if (m_gc_max_pause < seconds)
+        m_gc_max_pause = seconds;
+
+    m_gc_in_cycle = !finished;
+    if (finished)
+    {
+        ++m_gc_cycles;
+        m_gc_mark = m_allocated;
+    }
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator::get_stats(stats& out) const
+{
+    out.in_use = m_in_use;
+    out.pooled = m_chunks.size() * c_chunk_size;
+    out.allocated = m_allocated;
+    out.edit_allocated = m_allocated - m_edit_mark;
+    out.prev_allocated = m_prev_allocated;
+    out.gc_steps = m_gc_steps;
+    out.gc_cycles = m_gc_cycles;
+    out.gc_pause = m_gc_pause;
+    out.gc_max_pause = m_gc_max_pause;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Allocator for a Lua state.  Small blocks come from per-size-class pools, so
+// the many short-lived strings, tables, and userdata created for each
+// keystroke don't each round trip through the heap.  Larger blocks go to the
+// heap.  Pooled memory is reused by later allocations of the same size class,
+// and is returned to the heap when the allocator is destroyed (after the Lua
+// state is closed).
+//
+// The allocator also tracks the bookkeeping for running garbage collection
+// steps while idle; lua_state performs the actual steps.
+class lua_allocator
+{
+public:
+    struct stats
+    {
+        size_t              in_use;         // Bytes currently allocated.
+        size_t              pooled;         // Bytes reserved by the pools.
+        uint64              allocated;      // Total bytes ever allocated.
+        uint64              edit_allocated; // Bytes allocated in this edit.
+        uint64              prev_allocated; // Bytes allocated in the previous edit.
+        uint32              gc_steps;       // Idle GC steps in this edit.
+        uint32              gc_cycles;      // Idle GC cycles finished in this edit.
+        double              gc_pause;       // Seconds spent in idle GC steps in this edit.
+        double              gc_max_pause;   // Longest idle GC step in this edit.
+    };
+
+                            lua_allocator() = default;
+                            ~lua_allocator();
+                            lua_allocator(const lua_allocator&) = delete;
+
+    static void*            alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+    void                    begin_edit();
+    bool                    has_gc_work() const;
+    void                    on_gc_step(double seconds, bool finished);
+    void                    get_stats(stats& out) const;
+
+private:
+    struct free_block { free_block* next; };
+
+    static const uint32     c_granularity = 16;
+    static const uint32     c_num_classes = 16;     // Up to 256 bytes.
+    static const uint32     c_chunk_size = 16384;
+
+    static uint32           size_class(size_t size);
+    void*                   allocate(size_t size);
+    void                    deallocate(void* ptr, size_t size);
+    void*                   reallocate(void* ptr, size_t osize, size_t nsize);
+    bool                    grow_pool(uint32 sc);
+
+    free_block*             m_free[c_num_classes] = {};
+    std::vector<void*>      m_chunks;
+    size_t                  m_in_use = 0;
+    uint64                  m_allocated = 0;
+
+    uint64                  m_edit_mark = 0;
+    uint64                  m_prev_allocated = 0;
+    uint64                  m_gc_mark = 0;
+    bool                    m_gc_in_cycle = false;
+    uint32                  m_gc_steps = 0;
+    uint32                  m_gc_cycles = 0;
+    double                  m_gc_pause = 0;
+    double                  m_gc_max_pause = 0;
+};
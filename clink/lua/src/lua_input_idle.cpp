@@ -6,11 +6,15 @@
 #include "lua_state.h"
 #include "lua_task_manager.h"
 #include "async_lua_task.h"
+#include "coroutine_scheduler.h"
 
 #include <core/base.h>
+#include <core/globber.h>
+#include <core/os.h>
 #include <lib/reclassify.h>
 #include <lib/line_editor_integration.h>
 #include <lib/display_readline.h>
+#include <terminal/terminal.h>
 
 #include <assert.h>
 
@@ -40,6 +44,19 @@ static DWORD s_terminal_resized = 0;    // Tick count of most recent resize.
 // automatically rerunning the prompt filters.
 const DWORD c_terminal_resize_refilter_delay = 500;
 
+// Wait for this many milliseconds without input before running garbage
+// collection steps.
+const DWORD c_idle_gc_delay = 100;
+
+//------------------------------------------------------------------------------
+// Returns how many more milliseconds to wait before garbage collection steps
+// may run, or 0 if they may run now.
+static DWORD get_idle_gc_wait()
+{
+    const DWORD elapsed = GetTickCount() - get_last_input_tick();
+    return (elapsed < c_idle_gc_delay) ? c_idle_gc_delay - elapsed : 0;
+}
+
 //------------------------------------------------------------------------------
 lua_input_idle::lua_input_idle(lua_state& state)
 : m_state(state)
@@ -62,6 +79,8 @@ void lua_input_idle::reset()
 
     m_enabled = true;
     m_iterations = 0;
+
+    m_state.begin_edit();
 }
 
 //------------------------------------------------------------------------------
@@ -95,27 +114,26 @@ uint32 lua_input_idle::get_timeout()
         timeout = min(timeout, t);
     }
 
+    if (m_state.has_idle_gc_work())
+        timeout = min(timeout, get_idle_gc_wait());
+
+    // Close cached directory listings as they expire, so an idle prompt
+    // doesn't keep directories open.
+    timeout = min(timeout, DWORD(globber::sweep_cache()));
+
     if (is_enabled())
     {
         m_iterations++;
 
-        lua_State* state = m_state.get_state();
-        save_stack_top ss(state);
-
-        // Call to Lua to check for coroutines.
-        lua_getglobal(state, "clink");
-        lua_pushliteral(state, "_wait_duration");
-        lua_rawget(state, -2);
-
-        if (m_state.pcall(state, 0, 1) == 0)
+        // Ask the scheduler directly; yieldguards and asyncyields signal the
+        // idle event when they complete, so there's no need to call into Lua
+        // to poll them.
+        double sec;
+        coroutine_scheduler* scheduler = coroutine_scheduler::find(m_state.get_state());
+        if (scheduler && scheduler->get_wait(os::clock(), sec))
         {
-            int32 isnum;
-            double sec = lua_tonumberx(state, -1, &isnum);
-            if (isnum)
-            {
-                const DWORD t = (sec > 0) ? uint32(sec * 1000) : 0;
-                timeout = min(timeout, t);
-            }
+            const DWORD t = (sec > 0) ? uint32(sec * 1000) : 0;
+            timeout = min(timeout, t);
         }
     }
 
@@ -217,6 +235,12 @@ void lua_input_idle::on_idle()
             host_clear_input_hint_timeout();
         reclassify(reason);
     }
+
+    // Collect garbage last, so it includes garbage from the work above.  Other
+    // idle work can wake this sooner, so check how long it's been since the
+    // last input.
+    if (m_state.has_idle_gc_work() && !get_idle_gc_wait())
+        m_state.idle_gc_step();
 }
 
 //------------------------------------------------------------------------------
@@ -59,9 +59,8 @@ bool lua_match_generator::generate(const line_states& lines, match_builder& buil
     save_stack_top ss(state);
 
     // Call to Lua to generate matches.
-    lua_getglobal(state, "clink");
-    lua_pushliteral(state, "_generate");
-    lua_rawget(state, -2);
+    if (!lua_state::push_named_function(state, "clink._generate"))
+        return false;
 
     line_state_lua line_lua(lines.back());
     line_lua.push(state);
@@ -90,9 +89,11 @@ void lua_match_generator::get_word_break_info(const line_state& line, word_break
     save_stack_top ss(state);
 
     // Call to Lua to calculate prefix length.
-    lua_getglobal(state, "clink");
-    lua_pushliteral(state, "_get_word_break_info");
-    lua_rawget(state, -2);
+    if (!lua_state::push_named_function(state, "clink._get_word_break_info"))
+    {
+        info.clear();
+        return;
+    }
 
     line_state_lua line_lua(line);
     line_lua.push(state);
@@ -521,7 +522,7 @@ bool lua_match_generator::filter_matches(char** matches, char completion_type, b
         if (keep_typeless.find(*read) == keep_typeless.end())
         {
             discarded = true;
-            free(*read);
+            free_match(*read);
         }
         else
         {
@@ -541,7 +542,7 @@ bool lua_match_generator::filter_matches(char** matches, char completion_type, b
     // If no matches, free the lcd as well.
     if (!matches[1])
     {
-        free(matches[0]);
+        free_match(matches[0]);
         matches[0] = nullptr;
     }
 
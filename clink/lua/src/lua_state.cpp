@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "lua_state.h"
+#include "lua_allocator.h"
 #include "lua_script_loader.h"
 #include "lua_task_manager.h"
 #include "rl_buffer_lua.h"
@@ -11,6 +12,7 @@
 #include <core/settings.h>
 #include <core/str.h>
 #include <core/str_tokeniser.h>
+#include <core/str_unordered_set.h>
 #include <core/os.h>
 #include <core/cwd_restorer.h>
 #include <core/debugheap.h>
@@ -23,7 +25,9 @@
 #include <terminal/terminal_helpers.h>
 #include <terminal/printer.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include <assert.h>
 
 extern "C" {
@@ -93,6 +97,14 @@ static setting_int g_lua_throttle_coroutines(
     "default value was 5 seconds, but now it's 0 (no throttling).",
     0);
 
+static setting_int g_lua_idle_gc_step(
+    "lua.idle_gc_step",
+    "Garbage collection step size while idle",
+    "While waiting for input, Clink runs incremental Lua garbage collection in\n"
+    "steps of this many kilobytes, so that less collection happens while typing.\n"
+    "Set this to 0 to leave garbage collection to Lua's automatic schedule.",
+    64);
+
 extern setting_bool g_debug_log_terminal;
 #ifdef _MSC_VER
 extern setting_bool g_debug_log_output_callstacks;
@@ -185,6 +197,161 @@ const char* optstring(lua_State* L, int32 index, const char* default_value)
 
 
 
+//------------------------------------------------------------------------------
+// Resolved names for push_named_function().  Each dotted name is split once
+// into interned Lua strings held by registry refs, so later lookups don't
+// tokenise the name or hash its parts.  The tables are still walked on every
+// lookup, so reassigning a global or a table field takes effect immediately.
+// The cache belongs to one Lua state; its refs are released when it switches
+// to a different state or before the owning state closes.
+struct named_function
+{
+    str_moveable        name;
+    std::vector<int32>  keys;
+    uint32              calls = 0;
+    double              seconds = 0;
+};
+
+static lua_allocator* s_allocator = nullptr;  // For diagnostics.
+static lua_State* s_named_functions_owner = nullptr; // Main thread.
+static str_unordered_map<named_function*> s_named_functions;
+static std::vector<std::unique_ptr<named_function>> s_named_function_list;
+static named_function* s_pending_named_function = nullptr;
+static const void* s_pending_named_function_ptr = nullptr;
+
+//------------------------------------------------------------------------------
+static void clear_named_functions()
+{
+    if (s_named_functions_owner)
+    {
+        for (const auto& nf : s_named_function_list)
+            for (int32 key : nf->keys)
+                luaL_unref(s_named_functions_owner, LUA_REGISTRYINDEX, key);
+    }
+
+    s_named_functions_owner = nullptr;
+    s_named_functions.clear();
+    s_named_function_list.clear();
+    s_pending_named_function = nullptr;
+    s_pending_named_function_ptr = nullptr;
+}
+
+//------------------------------------------------------------------------------
+static named_function* find_named_function(lua_State* L, const char* func_name)
+{
+    lua_State* const main = G(L)->mainthread;
+    if (s_named_functions_owner != main)
+    {
+        clear_named_functions();
+        s_named_functions_owner = main;
+    }
+
+    const auto iter = s_named_functions.find(func_name);
+    if (iter != s_named_functions.end())
+        return iter->second;
+
+    auto nf = std::make_unique<named_function>();
+    nf->name = func_name;
+
+    str_iter part;
+    str_tokeniser name_parts(func_name, ".");
+    while (name_parts.next(part))
+    {
+        lua_pushlstring(L, part.get_pointer(), part.length());
+        nf->keys.push_back(luaL_ref(L, LUA_REGISTRYINDEX));
+    }
+
+    named_function* const ret = nf.get();
+    s_named_functions.emplace(ret->name.c_str(), ret);
+    s_named_function_list.emplace_back(std::move(nf));
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// Leaves the same values on the stack as push_named_function():  each parent
+// table, followed by the function.
+static bool push_resolved_function(lua_State* L, const named_function& nf)
+{
+    if (nf.keys.empty())
+        return false;
+
+    // The first part is looked up like lua_getglobal(), honoring metamethods.
+    lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, nf.keys[0]);
+    lua_gettable(L, -2);
+    lua_remove(L, -2);
+
+    for (size_t i = 1; i < nf.keys.size(); ++i)
+    {
+        if (!lua_istable(L, -1))
+            return false;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, nf.keys[i]);
+        lua_rawget(L, -2);
+    }
+
+    return lua_isfunction(L, -1);
+}
+
+//------------------------------------------------------------------------------
+void lua_memory_diagnostics()
+{
+    if (!s_allocator || !rl_explicit_arg)
+        return;
+
+    static char bold[] = "\x1b[1m";
+    static char norm[] = "\x1b[m";
+
+    lua_allocator::stats stats;
+    s_allocator->get_stats(stats);
+
+    str<> s;
+    s.format("%slua memory:%s\n", bold, norm);
+    g_printer->print(s.c_str(), s.length());
+
+    s.format("  %-16s  %zu KB (%zu KB pooled)\n", "in use", stats.in_use / 1024, stats.pooled / 1024);
+    g_printer->print(s.c_str(), s.length());
+    s.format("  %-16s  %llu KB\n", "this edit", stats.edit_allocated / 1024);
+    g_printer->print(s.c_str(), s.length());
+    s.format("  %-16s  %llu KB\n", "previous edit", stats.prev_allocated / 1024);
+    g_printer->print(s.c_str(), s.length());
+    s.format("  %-16s  %u steps, %u cycles, %.3f ms total, %.3f ms max\n", "idle gc",
+             stats.gc_steps, stats.gc_cycles, stats.gc_pause * 1000, stats.gc_max_pause * 1000);
+    g_printer->print(s.c_str(), s.length());
+}
+
+//------------------------------------------------------------------------------
+void lua_entry_point_diagnostics()
+{
+    if (s_named_function_list.empty() || !rl_explicit_arg)
+        return;
+
+    static char bold[] = "\x1b[1m";
+    static char norm[] = "\x1b[m";
+
+    std::vector<const named_function*> sorted;
+    for (const auto& nf : s_named_function_list)
+        if (nf->calls)
+            sorted.push_back(nf.get());
+    if (sorted.empty())
+        return;
+
+    std::sort(sorted.begin(), sorted.end(), [](const named_function* a, const named_function* b) {
+        return a->seconds > b->seconds;
+    });
+
+    str<> s;
+    s.format("%slua entry points:%s\n", bold, norm);
+    g_printer->print(s.c_str(), s.length());
+
+    for (const auto* nf : sorted)
+    {
+        s.format("  %-32s  %8u calls  %10.3f ms\n", nf->name.c_str(), nf->calls, nf->seconds * 1000);
+        g_printer->print(s.c_str(), s.length());
+    }
+}
+
+
+
 //------------------------------------------------------------------------------
 enum class global_state : uint32
 {
@@ -232,7 +399,10 @@ void lua_state::initialise(lua_state_flags flags)
     s_interpreter = interpreter;
 
     // Create a new Lua state.
-    m_state = luaL_newstate();
+    m_allocator = std::make_unique<lua_allocator>();
+    m_state = luaL_newstatex(&lua_allocator::alloc, m_allocator.get());
+    if (!interpreter)
+        s_allocator = m_allocator.get();
 
     // Suspend collection during initialization.
     lua_gc(m_state, LUA_GCSTOP, 0);
@@ -318,9 +488,18 @@ void lua_state::shutdown()
 
     shutdown_task_manager(false/*final*/);
 
+    // Release the cached names while the state is still alive, so a later
+    // state at the same address can't inherit them.
+    if (s_named_functions_owner == m_state)
+        clear_named_functions();
+
     lua_close(m_state);
     m_state = nullptr;
 
+    if (s_allocator == m_allocator.get())
+        s_allocator = nullptr;
+    m_allocator.reset();
+
     s_interpreter = false;
 }
 
@@ -333,6 +512,41 @@ lua_State* lua_state::get_state() const
 }
 #endif
 
+//------------------------------------------------------------------------------
+void lua_state::begin_edit()
+{
+    if (m_allocator)
+        m_allocator->begin_edit();
+}
+
+//------------------------------------------------------------------------------
+bool lua_state::has_idle_gc_work() const
+{
+    return m_allocator && g_lua_idle_gc_step.get() > 0 && m_allocator->has_gc_work();
+}
+
+//------------------------------------------------------------------------------
+// Runs incremental garbage collection steps, so that the collector has less
+// work left to do on the input path.  Each call is limited to a small time
+// budget, so typing isn't delayed if a key arrives during collection.
+void lua_state::idle_gc_step()
+{
+    const int32 step = g_lua_idle_gc_step.get();
+    if (!m_state || !m_allocator || step <= 0)
+        return;
+
+    const double c_budget = 0.002;
+    const double begin = os::clock();
+    bool finished;
+    do
+    {
+        const double started = os::clock();
+        finished = !!lua_gc(m_state, LUA_GCSTEP, step);
+        m_allocator->on_gc_step(os::clock() - started, finished);
+    }
+    while (!finished && os::clock() - begin < c_budget);
+}
+
 //------------------------------------------------------------------------------
 bool lua_state::do_string(const char* string, int32 length, str_base* error, const char* name)
 {
@@ -366,14 +580,60 @@ bool lua_state::do_string(const char* string, int32 length, str_base* error, con
     return true;
 }
 
+//------------------------------------------------------------------------------
+static int32 chunk_writer(lua_State* L, const void* p, size_t sz, void* ud)
+{
+    std::vector<char>* out = static_cast<std::vector<char>*>(ud);
+    const char* bytes = static_cast<const char*>(p);
+    out->insert(out->end(), bytes, bytes + sz);
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 bool lua_state::do_file(const char* path)
 {
-    lua_State* L = get_state();
+    return do_file(path, nullptr, 0, nullptr);
+}
 
+//------------------------------------------------------------------------------
+// Runs a script from its precompiled bytecode when a chunk is provided, else
+// from its source.  When the source is compiled and compiled is not nullptr,
+// it receives the bytecode so the caller can cache it for later sessions.
+bool lua_state::do_file(const char* path, const char* chunk, uint32 chunk_len, std::vector<char>* compiled)
+{
+    return do_file(get_state(), path, chunk, chunk_len, compiled);
+}
+
+//------------------------------------------------------------------------------
+bool lua_state::do_file(lua_State* L, const char* path, const char* chunk, uint32 chunk_len, std::vector<char>* compiled)
+{
     save_stack_top ss(L);
 
-    int32 err = luaL_loadfile(L, path);
+    int32 err = LUA_ERRFILE;
+    if (chunk && chunk_len)
+    {
+        str<280> name;
+        name << "@" << path;
+        err = luaL_loadbufferx(L, chunk, chunk_len, name.c_str(), "b");
+        if (err)
+        {
+            // The cached bytecode is unusable; fall back to the source.
+            LOG("Unable to load cached bytecode for '%s'", path);
+            lua_pop(L, 1);
+        }
+    }
+
+    if (err)
+    {
+        err = luaL_loadfile(L, path);
+        if (!err && compiled)
+        {
+            compiled->clear();
+            if (lua_dump(L, chunk_writer, compiled) != 0)
+                compiled->clear();
+        }
+    }
+
     if (err)
     {
         if (g_lua_debug.get())
@@ -392,7 +652,7 @@ bool lua_state::do_file(const char* path)
 }
 
 //------------------------------------------------------------------------------
-bool lua_state::push_named_function(lua_State* L, const char* func_name, str_base* e)
+static bool push_named_function_slow(lua_State* L, const char* func_name, str_base* e)
 {
     bool first = true;
     str_iter part;
@@ -452,6 +712,39 @@ report_error:
     return true;
 }
 
+//------------------------------------------------------------------------------
+bool lua_state::push_named_function(lua_State* L, const char* func_name, str_base* e)
+{
+    const int32 top = lua_gettop(L);
+    named_function* nf = find_named_function(L, func_name);
+    if (push_resolved_function(L, *nf))
+    {
+        ++nf->calls;
+        s_pending_named_function = nf;
+        s_pending_named_function_ptr = lua_topointer(L, -1);
+        if (e)
+            e->clear();
+        return true;
+    }
+
+    // Fall back to the slow path to report what went wrong.  Without an
+    // error string, report it the same way pcall() reports errors, as calling
+    // a missing entry point used to.
+    lua_settop(L, top);
+    str<> tmp;
+    if (push_named_function_slow(L, func_name, e ? e : &tmp))
+        return true;
+
+    if (!e)
+    {
+        tmp.trim();
+        LOG("%s", tmp.c_str());
+        puts("");
+        puts(tmp.c_str());
+    }
+    return false;
+}
+
 //------------------------------------------------------------------------------
 int32 lua_state::pcall_silent(lua_State* L, int32 nargs, int32 nresults)
 {
@@ -469,6 +762,14 @@ int32 lua_state::pcall_silent(lua_State* L, int32 nargs, int32 nresults)
     // Calculate stack position for message handler.
     int32 hpos = lua_gettop(L) - nargs;
 
+    // Attribute the time to the named function, if that's what is called.
+    named_function* const timed = ((s_pending_named_function &&
+                                    s_pending_named_function_ptr == lua_topointer(L, hpos)) ?
+                                   s_pending_named_function : nullptr);
+    s_pending_named_function = nullptr;
+    s_pending_named_function_ptr = nullptr;
+    const double started = timed ? os::clock() : 0;
+
     // Push our error message handler.
     lua_getglobal(L, "_error_handler");
 
@@ -481,6 +782,9 @@ int32 lua_state::pcall_silent(lua_State* L, int32 nargs, int32 nresults)
     // Remove custom error message handler from stack.
     lua_remove(L, hpos);
 
+    if (timed)
+        timed->seconds += os::clock() - started;
+
     // Restore the console mode.
     bool different = false;
     if (has_modeOut)
@@ -670,10 +974,11 @@ bool lua_state::send_event_internal(lua_State* L, const char* event_name, const
     assert(pos >= 0);
 
     // Push the global _send_event function.
-    lua_getglobal(L, "clink");
-    lua_pushstring(L, event_mechanism);
-    lua_rawget(L, -2);
-    if (lua_isnil(L, -1))
+    // A missing event mechanism isn't an error, so don't report it.
+    str<64> func_name;
+    str<> unused;
+    func_name << "clink." << event_mechanism;
+    if (!push_named_function(L, func_name.c_str(), &unused))
     {
         lua_settop(L, top);
         lua_pop(L, nargs);
@@ -848,9 +1153,8 @@ bool lua_state::get_command_word(line_state& line, str_base& command_word, bool&
     file.clear();
 
     // Call to Lua to calculate prefix length.
-    lua_getglobal(L, "clink");
-    lua_pushliteral(L, "_get_command_word");
-    lua_rawget(L, -2);
+    if (!push_named_function(L, "clink._get_command_word"))
+        return false;
 
     line_state_lua line_lua(line);
     line_lua.push(L);
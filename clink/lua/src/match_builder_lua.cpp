@@ -9,6 +9,9 @@
 #include <core/str.h>
 #include <lib/matches.h>
 
+//------------------------------------------------------------------------------
+extern int32 add_glob_matches(lua_State* state, match_builder& builder, int32 first_arg);
+
 //------------------------------------------------------------------------------
 const char* const match_builder_lua::c_name = "match_builder_lua";
 const match_builder_lua::method match_builder_lua::c_methods[] = {
@@ -31,6 +34,7 @@ const match_builder_lua::method match_builder_lua::c_methods[] = {
     { "_matches_ready",     &matches_ready },
     { "_get_generation_id", &get_generation_id },
     { "_log_matches",       &log_matches },
+    { "_addglobmatches",    &add_glob_matches },
     {}
 };
 
@@ -405,6 +409,16 @@ int32 match_builder_lua::log_matches(lua_State* state)
     return 0;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// builder:_addglobmatches(pattern, root, dirs_only, flags) adds file or dir
+// matches directly from the file system, the same as builder:addmatches() with
+// the table os._globmatches() would return.
+int32 match_builder_lua::add_glob_matches(lua_State* state)
+{
+    return ::add_glob_matches(state, *m_builder, LUA_SELF + 1);
+}
+
 //------------------------------------------------------------------------------
 /// -name:  builder:addmatches
 /// -ver:   1.0.0
@@ -6,7 +6,10 @@
 #include "lua_bindable.h"
 #include "yield.h"
 
+#include <core/alias_snapshot.h>
 #include <core/base.h>
+#include <core/env_snapshot.h>
+#include <core/exec_index.h>
 #include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
@@ -14,6 +17,7 @@
 #include <core/str.h>
 #include <core/str_iter.h>
 #include <lib/doskey.h>
+#include <lib/matches.h>
 #include <lib/clink_ctrlevent.h>
 #include <terminal/terminal_helpers.h>
 #include <terminal/printer.h>
@@ -118,6 +122,7 @@ class globber_lua
 {
 public:
                         globber_lua(const char* pattern, int32 extrainfo, const glob_flags& flags, bool dirs_only, bool back_compat=false);
+                        globber_lua(const char* pattern, const char* root, const glob_flags& flags, bool dirs_only);
 
 protected:
     int32               next(lua_State* state);
@@ -126,8 +131,10 @@ protected:
 private:
     globber             m_globber;
     str<288>            m_parent;
+    str_moveable        m_root;
     int32               m_extrainfo;
     int32               m_index = 1;
+    bool                m_as_matches = false;
 
     friend class lua_bindable<globber_lua>;
     static const char* const c_name;
@@ -144,7 +151,7 @@ const globber_lua::method globber_lua::c_methods[] = {
 
 //------------------------------------------------------------------------------
 globber_lua::globber_lua(const char* pattern, int32 extrainfo, const glob_flags& flags, bool dirs_only, bool back_compat)
-: m_globber(pattern)
+: m_globber(pattern, !back_compat/*cached*/)
 , m_parent(pattern)
 , m_extrainfo(extrainfo)
 {
@@ -157,8 +164,24 @@ globber_lua::globber_lua(const char* pattern, int32 extrainfo, const glob_flags&
         m_globber.suffix_dirs(false);
 }
 
+//------------------------------------------------------------------------------
+globber_lua::globber_lua(const char* pattern, const char* root, const glob_flags& flags, bool dirs_only)
+: m_globber(pattern, true/*cached*/)
+, m_parent(pattern)
+, m_root(root)
+, m_extrainfo(1)
+, m_as_matches(true)
+{
+    path::to_parent(m_parent, nullptr);
+
+    m_globber.files(!dirs_only);
+    m_globber.hidden(flags.hidden);
+    m_globber.system(flags.system);
+}
+
 //------------------------------------------------------------------------------
 static bool glob_next(lua_State* state, globber& globber, str_base& parent, int32* index, int32 extrainfo);
+static bool glob_next_match(lua_State* state, globber& globber, str_base& parent, const char* root, int32* index);
 int32 globber_lua::next(lua_State* state)
 {
     // Arg is table into which to glob files/dirs; glob_next appends into it.
@@ -170,7 +193,10 @@ int32 globber_lua::next(lua_State* state)
     bool ret = false;
     for (size_t c = 0; c < num_max; c++)
     {
-        ret = glob_next(state, m_globber, m_parent, &m_index, m_extrainfo);
+        if (m_as_matches)
+            ret = glob_next_match(state, m_globber, m_parent, m_root.c_str(), &m_index);
+        else
+            ret = glob_next(state, m_globber, m_parent, &m_index, m_extrainfo);
         if (!ret)
             break;
         if (GetTickCount() - tick > ms_max)
@@ -991,6 +1017,41 @@ static void add_type_tag(str_base& out, const char* tag)
     out << tag;
 }
 
+//------------------------------------------------------------------------------
+static bool is_glob_link(const globber::extrainfo& info)
+{
+#ifdef S_ISLNK
+    return S_ISLNK(info.st_mode);
+#else
+    return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+static void get_glob_type(str_base& type, const globber::extrainfo& info, str_base& parent, const char* file)
+{
+    add_type_tag(type, (info.attr & FILE_ATTRIBUTE_DIRECTORY) ? "dir" : "file");
+    if (is_glob_link(info))
+    {
+        uint32 len = parent.length();
+        path::append(parent, file);
+
+        add_type_tag(type, "link");
+        wstr<288> wfile(parent.c_str());
+        struct _stat64 st;
+        if (_wstat64(wfile.c_str(), &st) < 0)
+            add_type_tag(type, "orphaned");
+
+        parent.truncate(len);
+    }
+    if (info.attr & FILE_ATTRIBUTE_HIDDEN)
+        add_type_tag(type, "hidden");
+    if (info.attr & FILE_ATTRIBUTE_SYSTEM)
+        add_type_tag(type, "system");
+    if (info.attr & FILE_ATTRIBUTE_READONLY)
+        add_type_tag(type, "readonly");
+}
+
 //------------------------------------------------------------------------------
 static bool glob_next(lua_State* state, globber& globber, str_base& parent, int32* index, int32 extrainfo)
 {
@@ -1013,28 +1074,7 @@ static bool glob_next(lua_State* state, globber& globber, str_base& parent, int3
         lua_rawset(state, -3);
 
         str<32> type;
-        add_type_tag(type, (info.attr & FILE_ATTRIBUTE_DIRECTORY) ? "dir" : "file");
-#ifdef S_ISLNK
-        if (S_ISLNK(info.st_mode))
-        {
-            uint32 len = parent.length();
-            path::append(parent, file.c_str());
-
-            add_type_tag(type, "link");
-            wstr<288> wfile(parent.c_str());
-            struct _stat64 st;
-            if (_wstat64(wfile.c_str(), &st) < 0)
-                add_type_tag(type, "orphaned");
-
-            parent.truncate(len);
-        }
-#endif
-        if (info.attr & FILE_ATTRIBUTE_HIDDEN)
-            add_type_tag(type, "hidden");
-        if (info.attr & FILE_ATTRIBUTE_SYSTEM)
-            add_type_tag(type, "system");
-        if (info.attr & FILE_ATTRIBUTE_READONLY)
-            add_type_tag(type, "readonly");
+        get_glob_type(type, info, parent, file.c_str());
 
         lua_pushliteral(state, "type");
         lua_pushlstring(state, type.c_str(), type.length());
@@ -1065,6 +1105,36 @@ static bool glob_next(lua_State* state, globber& globber, str_base& parent, int3
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Appends a { match=, type= } table for the next file, in the same form that
+// clink.filematches() returns, without building an intermediate table.
+static bool glob_next_match(lua_State* state, globber& globber, str_base& parent, const char* root, int32* index)
+{
+    str<288> file;
+    globber::extrainfo info;
+    if (!globber.next(file, false, &info))
+        return false;
+
+    str<288> match;
+    path::join(root, file.c_str(), match);
+
+    str<32> type;
+    get_glob_type(type, info, parent, file.c_str());
+
+    lua_createtable(state, 0, 2);
+
+    lua_pushliteral(state, "match");
+    lua_pushlstring(state, match.c_str(), match.length());
+    lua_rawset(state, -3);
+
+    lua_pushliteral(state, "type");
+    lua_pushlstring(state, type.c_str(), type.length());
+    lua_rawset(state, -3);
+
+    lua_rawseti(state, -2, (*index)++);
+    return true;
+}
+
 //------------------------------------------------------------------------------
 static void get_glob_flags(lua_State* state, int32 index, glob_flags& out, bool back_compat)
 {
@@ -1121,7 +1191,7 @@ int32 glob_impl(lua_State* state, bool dirs_only, bool back_compat=false)
 
     lua_createtable(state, 0, 0);
 
-    globber globber(mask);
+    globber globber(mask, !back_compat/*cached*/);
     globber.files(!dirs_only);
     globber.hidden(flags.hidden);
     globber.system(flags.system);
@@ -1152,6 +1222,111 @@ int32 glob_impl(lua_State* state, bool dirs_only, bool back_compat=false)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// os._globmatches(pattern, root, dirs_only, flags) globs directly into a table
+// of matches for clink.filematches() and clink.dirmatches().
+static int32 glob_matches(lua_State* state)
+{
+    const char* mask = checkstring(state, 1);
+    const char* root = checkstring(state, 2);
+    if (!mask || !root)
+        return 0;
+
+    const bool dirs_only = !!lua_toboolean(state, 3);
+
+    glob_flags flags;
+    get_glob_flags(state, 4, flags, false);
+
+    lua_createtable(state, 0, 0);
+
+    globber globber(mask, true/*cached*/);
+    globber.files(!dirs_only);
+    globber.hidden(flags.hidden);
+    globber.system(flags.system);
+
+    str_moveable parent(mask);
+    path::to_parent(parent, nullptr);
+
+    int32 i = 1;
+    while (glob_next_match(state, globber, parent, root, &i))
+    {
+        if (!(i & 0x03) && clink_is_signaled())
+            break;
+    }
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// os._makematchglobber(pattern, root, dirs_only, flags) is like
+// os._globmatches(), but returns a globber for use in coroutines.
+static int32 make_match_globber(lua_State* state)
+{
+    const char* mask = checkstring(state, 1);
+    const char* root = checkstring(state, 2);
+    if (!mask || !root)
+        return 0;
+
+    const bool dirs_only = !!lua_toboolean(state, 3);
+
+    glob_flags flags;
+    get_glob_flags(state, 4, flags, false);
+
+    if (!globber_lua::make_new(state, mask, root, flags, dirs_only))
+        return 0;
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// Streams globbed files straight into a match_builder, skipping the Lua tables
+// entirely.  Args start at first_arg and are the same as os._globmatches().
+int32 add_glob_matches(lua_State* state, match_builder& builder, int32 first_arg)
+{
+    const char* mask = checkstring(state, first_arg);
+    const char* root = checkstring(state, first_arg + 1);
+    if (!mask || !root)
+        return 0;
+
+    const bool dirs_only = !!lua_toboolean(state, first_arg + 2);
+
+    glob_flags flags;
+    get_glob_flags(state, first_arg + 3, flags, false);
+
+    globber globber(mask, true/*cached*/);
+    globber.files(!dirs_only);
+    globber.hidden(flags.hidden);
+    globber.system(flags.system);
+
+    str_moveable parent(mask);
+    path::to_parent(parent, nullptr);
+    const uint32 parent_len = parent.length();
+
+    str<288> file;
+    str<288> match;
+    globber::extrainfo info;
+    int32 count = 0;
+    for (uint32 i = 1; globber.next(file, false, &info); ++i)
+    {
+        path::join(root, file.c_str(), match);
+
+        path::append(parent, file.c_str());
+        const match_type type = to_match_type(info.attr, parent.c_str(), is_glob_link(info));
+        parent.truncate(parent_len);
+
+        match_desc desc(match.c_str(), nullptr, nullptr, type);
+        count += !!builder.add_match(desc);
+
+        if (!(i & 0x03) && clink_is_signaled())
+            break;
+    }
+
+    lua_pushinteger(state, count);
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 int32 globber_impl(lua_State* state, bool dirs_only, bool back_compat=false)
 {
@@ -1302,6 +1477,94 @@ int32 has_file_association(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// Returns the %PATH% directories from the shared environment snapshot, each
+// with a trailing path separator.
+int32 get_path_dirs(lua_State* state)
+{
+    const std::shared_ptr<const env_snapshot> env = env_snapshot::get();
+    const auto& dirs = env->get_paths();
+
+    str<> dir;
+    lua_createtable(state, int32(dirs.size()), 0);
+    for (size_t i = 0; i < dirs.size(); ++i)
+    {
+        dir = dirs[i].c_str();
+        path::append(dir, "");
+        lua_pushlstring(state, dir.c_str(), dir.length());
+        lua_rawseti(state, -2, int32(i + 1));
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// Returns the %PATHEXT% extensions from the shared environment snapshot, in
+// lowercase.
+int32 get_path_exts(lua_State* state)
+{
+    const std::shared_ptr<const env_snapshot> env = env_snapshot::get();
+    const auto& exts = env->get_pathexts();
+
+    lua_createtable(state, int32(exts.size()), 0);
+    for (size_t i = 0; i < exts.size(); ++i)
+    {
+        lua_pushlstring(state, exts[i].c_str(), exts[i].length());
+        lua_rawseti(state, -2, int32(i + 1));
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// Returns a table of { match=name, type=type } for the executables in the
+// %PATH% directories, from the executables index.  Names shadowed by an
+// earlier directory are omitted.  Returns nil if the index isn't current, in
+// which case the caller must glob the directories itself.
+int32 get_exec_matches(lua_State* state)
+{
+    const std::shared_ptr<const exec_index> index = exec_index::get();
+    if (!index)
+        return 0;
+
+    glob_flags flags;
+    get_glob_flags(state, 1, flags, false);
+
+    std::vector<const exec_index::entry*> entries;
+    index->find_prefix("", entries);
+
+    str<288> parent;
+    str<32> type;
+    globber::extrainfo info = {};
+    int32 i = 0;
+
+    lua_createtable(state, int32(entries.size()), 0);
+    for (const exec_index::entry* entry : entries)
+    {
+        if ((entry->attr & FILE_ATTRIBUTE_HIDDEN) && !flags.hidden)
+            continue;
+        if ((entry->attr & FILE_ATTRIBUTE_SYSTEM) && !flags.system)
+            continue;
+
+        parent = index->get_dir(entry->dir);
+        info.attr = entry->attr;
+        info.st_mode = entry->st_mode;
+        type.clear();
+        get_glob_type(type, info, parent, entry->name);
+
+        lua_createtable(state, 0, 2);
+
+        lua_pushliteral(state, "match");
+        lua_pushstring(state, entry->name);
+        lua_rawset(state, -3);
+
+        lua_pushliteral(state, "type");
+        lua_pushlstring(state, type.c_str(), type.length());
+        lua_rawset(state, -3);
+
+        lua_rawseti(state, -2, ++i);
+    }
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 int32 win_verify_trust(lua_State* state)
 {
@@ -2474,6 +2737,19 @@ int32 get_alias(lua_State* state)
 /// Returns doskey alias names in a table of strings.
 int32 get_aliases(lua_State* state)
 {
+    // During an edit session the alias table is fetched once in bulk.
+    if (std::shared_ptr<const alias_snapshot> snapshot = alias_snapshot::get())
+    {
+        const uint32 count = snapshot->get_count();
+        lua_createtable(state, count, 0);
+        for (uint32 i = 0; i < count; ++i)
+        {
+            lua_pushstring(state, snapshot->get_name(i));
+            lua_rawseti(state, -2, i + 1);
+        }
+        return 1;
+    }
+
     lua_createtable(state, 0, 0);
 
     // Not const because Windows' alias API won't accept it.
@@ -3553,7 +3829,12 @@ void os_lua_initialise(lua_state& lua)
         { "_globfiles",  &glob_files }, // Public os.globfiles method is in core.lua.
         { "_makedirglobber", &make_dir_globber },
         { "_makefileglobber", &make_file_globber },
+        { "_globmatches", &glob_matches },
+        { "_makematchglobber", &make_match_globber },
         { "_hasfileassociation", &has_file_association },
+        { "_getpathdirs", &get_path_dirs },
+        { "_getpathexts", &get_path_exts },
+        { "_getexecmatches", &get_exec_matches },
         { "_win_verify_trust", &win_verify_trust },
         { "_verify_from_catalog", &verify_from_catalog },
     };
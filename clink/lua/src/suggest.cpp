@@ -13,6 +13,7 @@
 #include <lib/line_state.h>
 #include <lib/matches.h>
 #include <lib/suggestions.h>
+#include <lib/word_collector.h>
 #include "lua_script_loader.h"
 #include "lua_state.h"
 #include "line_state_lua.h"
@@ -57,9 +58,8 @@ nosuggest:
     str_compare_scope compare(scope, g_fuzzy_accent.get());
 
     // Call Lua to filter prompt
-    lua_getglobal(state, "clink");
-    lua_pushliteral(state, "_suggest");
-    lua_rawget(state, -2);
+    if (!lua_state::push_named_function(state, "clink._suggest"))
+        goto nosuggest;
 
     os::cwd_restorer cwd;
 
@@ -88,8 +88,10 @@ nosuggest:
 
         // These can't be bound to stack objects because they must stay valid
         // for the duration of the coroutine.
-        line_state_lua::make_new(state, make_line_state_copy(line), 0);
-        line_states_lua::make_new(state, lines);
+        // Copy the line states once and share the copy.
+        auto snapshot = std::make_shared<const command_line_snapshot>(lines);
+        line_state_lua::make_new(state, snapshot, uint32(lines.size() - 1));
+        line_states_lua::make_new(state, snapshot);
         matches_lua::make_new(state, toolkit);
         match_builder_lua::make_new(state, toolkit);
         lua_pushinteger(state, matches_generation_id);
@@ -516,6 +516,30 @@ TEST_CASE("Lua word classification")
         }
     }
 
+    SECTION("Many flags")
+    {
+        const char* script = "\
+            local flags = {}\
+            for i = 1, 500 do\
+                table.insert(flags, '--flag'..i)\
+            end\
+            many = clink.argmatcher('many'):addflags(flags):addarg('one', 'two')\
+        ";
+
+        REQUIRE_LUA_DO_STRING(lua, script);
+
+        tester.set_input("many --flag1 --flag500 --flag501 two");
+        tester.set_expected_classifications("offoa");
+        tester.run();
+
+        // Flags added after the list was first used are recognized.
+        REQUIRE_LUA_DO_STRING(lua, "many:addflags('--flag501')");
+
+        tester.set_input("many --flag501 two");
+        tester.set_expected_classifications("ofa");
+        tester.run();
+    }
+
     SECTION("Doskey")
     {
         SECTION("No space")
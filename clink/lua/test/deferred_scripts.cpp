@@ -0,0 +1,102 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "fs_fixture.h"
+
+#include <core/base.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+static void write_script(const char* file, const char* content)
+{
+    FILE* f = fopen(file, "wt");
+    REQUIRE(f);
+    fputs(content, f);
+    fclose(f);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua deferred scripts")
+{
+    fs_fixture fs;
+    lua_state lua;
+
+    SECTION("Record")
+    {
+        // Registering argmatchers only.
+        REQUIRE(lua.do_string("clink._begin_script_record()"));
+        REQUIRE(lua.do_string("local a = clink.argmatcher('Foo', 'bar'); a:addflags('-x')"));
+        REQUIRE(lua.do_string("clink.argmatcher('foo'):addflags('-y')"));
+        REQUIRE(lua.do_string("kinds, names = clink._end_script_record()"));
+        REQUIRE(lua.do_string("assert(kinds == '')"));
+        REQUIRE(lua.do_string("assert(#names == 2 and names[1] == 'foo' and names[2] == 'bar')"));
+
+        // Registering other things.
+        REQUIRE(lua.do_string("clink._begin_script_record()"));
+        REQUIRE(lua.do_string("clink.argmatcher('baz')"));
+        REQUIRE(lua.do_string("clink.onbeginedit(function() end)"));
+        REQUIRE(lua.do_string("clink.generator(99)"));
+        REQUIRE(lua.do_string("kinds, names = clink._end_script_record()"));
+        REQUIRE(lua.do_string("assert(kinds == 'clink.generator,clink.onbeginedit')"));
+        REQUIRE(lua.do_string("assert(#names == 1 and names[1] == 'baz')"));
+
+        // Defining globals.
+        REQUIRE(lua.do_string("clink._begin_script_record()"));
+        REQUIRE(lua.do_string("some_new_global = 1"));
+        REQUIRE(lua.do_string("kinds, names = clink._end_script_record()"));
+        REQUIRE(lua.do_string("assert(kinds == 'modified _G')"));
+    }
+
+    SECTION("Defer")
+    {
+        str<280> one(fs.get_root());
+        str<280> two(fs.get_root());
+        path::append(one, "one.lua");
+        path::append(two, "two.lua");
+
+        write_script(one.c_str(),
+            "deferred_order = (deferred_order or '')..'1'\n"
+            "clink.argmatcher('alpha', 'beta'):addflags('-a')\n");
+        write_script(two.c_str(),
+            "deferred_order = (deferred_order or '')..'2'\n"
+            "clink.argmatcher('beta'):addflags('-b')\n");
+
+        str<> s;
+        s.format("clink._defer_script([[%s]], 'alpha', 'beta')", one.c_str());
+        REQUIRE(lua.do_string(s.c_str()));
+        s.format("clink._defer_script([[%s]], 'beta')", two.c_str());
+        REQUIRE(lua.do_string(s.c_str()));
+        REQUIRE(lua.do_string("assert(deferred_order == nil)"));
+
+        // Looking up either command loads both scripts, in the original order.
+        REQUIRE(lua.do_string("clink.argmatcher('BETA')"));
+        REQUIRE(lua.do_string("assert(deferred_order == '12')"));
+
+        // The scripts are only loaded once.
+        REQUIRE(lua.do_string("clink.argmatcher('alpha')"));
+        REQUIRE(lua.do_string("assert(deferred_order == '12')"));
+    }
+
+    SECTION("Failure")
+    {
+        // Deferred scripts are loaded by the same native path as scripts at
+        // startup, so a broken script fails the same way instead of raising
+        // an error from the lookup that triggered it.
+        str<280> bad(fs.get_root());
+        path::append(bad, "bad.lua");
+        write_script(bad.c_str(), "clink.argmatcher('gamma'):addflags(\n");
+
+        str<> s;
+        s.format("clink._defer_script([[%s]], 'gamma')", bad.c_str());
+        REQUIRE(lua.do_string(s.c_str()));
+        REQUIRE(lua.do_string("clink.argmatcher('gamma'):addflags('-g')"));
+
+        s.format("assert(clink._load_deferred_script([[%s]]) == false)", bad.c_str());
+        REQUIRE(lua.do_string(s.c_str()));
+    }
+}
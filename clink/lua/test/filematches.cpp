@@ -0,0 +1,218 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "benchmark.h"
+#include "fs_fixture.h"
+#include "line_editor_tester.h"
+
+#include <core/str.h>
+#include <lua/lua_match_generator.h>
+#include <lua/lua_state.h>
+#include <lib/cmd_tokenisers.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+// The way clink.filematches() used to collect matches, before it had a native
+// implementation.  The native implementation must produce the same results.
+static const char* const c_lua_filematches = "\
+    function lua_filematches(root, flags) \
+        local matches = {} \
+        for _, i in ipairs(os.globfiles(path.join(root, '*'), true, flags)) do \
+            local m = path.join(root, i.name) \
+            table.insert(matches, { match = m, type = i.type }) \
+        end \
+        return matches \
+    end \
+    \
+    function native_filematches(root, flags) \
+        return os._globmatches(path.join(root, '*'), root, false, flags) \
+    end \
+    \
+    function same_matches(root, flags) \
+        local a = lua_filematches(root, flags) \
+        local b = native_filematches(root, flags) \
+        if #a ~= #b then \
+            return false \
+        end \
+        for i = 1, #a do \
+            if a[i].match ~= b[i].match or a[i].type ~= b[i].type then \
+                return false \
+            end \
+        end \
+        return true \
+    end \
+";
+
+//------------------------------------------------------------------------------
+static void make_files(uint32 count)
+{
+    str<32> name;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        name.format("f%07u.txt", i);
+        if (FILE* f = fopen(name.c_str(), "wt"))
+            fclose(f);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua file matches")
+{
+    static const char* fs[] = {
+        "file1",
+        "file2.txt",
+        "dir1/only",
+        "dir1/file1",
+        "dir2/.",
+        nullptr,
+    };
+
+    fs_fixture fixture(fs);
+    lua_state lua;
+
+    REQUIRE_LUA_DO_STRING(lua, c_lua_filematches);
+
+    SECTION("Same as Lua")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "assert(#native_filematches('') == 4)");
+        REQUIRE_LUA_DO_STRING(lua, "assert(same_matches(''))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(same_matches('dir1'))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(same_matches('dir1/'))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(same_matches('dir1\\\\'))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(same_matches('', { hidden=false }))");
+    }
+
+    SECTION("Dirs only")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local t = os._globmatches('*', '', true) \
+            assert(#t == 2) \
+            assert(t[1].match == 'dir1\\\\' and t[1].type == 'dir') \
+            assert(t[2].match == 'dir2\\\\' and t[2].type == 'dir')");
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua file matches in argmatchers")
+{
+    static const char* fs[] = {
+        "file1",
+        "file2.txt",
+        "dir1/only",
+        "dir1/file1",
+        "dir2/.",
+        nullptr,
+    };
+
+    fs_fixture fixture(fs);
+
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+
+    cmd_command_tokeniser command_tokeniser;
+    cmd_word_tokeniser word_tokeniser;
+
+    line_editor::desc desc(nullptr, nullptr, nullptr, nullptr);
+    desc.command_tokeniser = &command_tokeniser;
+    desc.word_tokeniser = &word_tokeniser;
+    line_editor_tester tester(desc, nullptr, nullptr);
+    tester.get_editor()->set_generator(lua_generator);
+
+    // The builtin functions stream matches into the builder with
+    // builder:_addglobmatches(), while wrapping them in another function goes
+    // through the Lua path.  Both must add the same matches with the same
+    // types, and honor the same arg options.
+    const char* script = "\
+        local function lua_filematches(word) return clink.filematches(word) end \
+        local function lua_dirmatches(word) return clink.dirmatches(word) end \
+        clink.argmatcher('native_files'):addarg({ clink.filematches, 'zz', 'aa' }) \
+        clink.argmatcher('lua_files'):addarg({ lua_filematches, 'zz', 'aa' }) \
+        clink.argmatcher('native_nosort'):addarg({ nosort=true, clink.filematches, 'zz', 'aa' }) \
+        clink.argmatcher('lua_nosort'):addarg({ nosort=true, lua_filematches, 'zz', 'aa' }) \
+        clink.argmatcher('native_dirs'):addarg({ clink.dirmatches }) \
+        clink.argmatcher('lua_dirs'):addarg({ lua_dirmatches }) \
+    ";
+
+    REQUIRE_LUA_DO_STRING(lua, script);
+
+    SECTION("Files")
+    {
+        for (const char* cmd : { "native_files", "lua_files" })
+        {
+            str<> input, output;
+            input.format("%s \x1b*", cmd);
+            output.format("%s aa dir1\\ dir2\\ file1 file2.txt zz ", cmd);
+            tester.set_input(input.c_str());
+            tester.set_expected_output(output.c_str());
+            tester.run();
+        }
+    }
+
+    SECTION("Nosort")
+    {
+        for (const char* cmd : { "native_nosort", "lua_nosort" })
+        {
+            str<> input, output;
+            input.format("%s \x1b*", cmd);
+            output.format("%s dir1\\ dir2\\ file1 file2.txt zz aa ", cmd);
+            tester.set_input(input.c_str());
+            tester.set_expected_output(output.c_str());
+            tester.run();
+        }
+    }
+
+    SECTION("Dirs")
+    {
+        for (const char* cmd : { "native_dirs", "lua_dirs" })
+        {
+            str<> input;
+            input.format("%s d", cmd);
+            tester.set_input(input.c_str());
+            tester.set_expected_matches("dir1\\", "dir2\\");
+            tester.run();
+
+            // Completing a dir match doesn't append a space.
+            str<> output;
+            input.format("%s dir1" DO_COMPLETE, cmd);
+            output.format("%s dir1\\", cmd);
+            tester.set_input(input.c_str());
+            tester.set_expected_output(output.c_str());
+            tester.run();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua file matches benchmark")
+{
+    if (!g_run_benchmarks)
+        return;
+
+    for (uint32 count = 1000; count <= 100000; count *= 10)
+    {
+        static const char* empty_fs[] = { nullptr };
+        fs_fixture fixture(empty_fs);
+        make_files(count);
+
+        lua_state lua;
+        REQUIRE_LUA_DO_STRING(lua, c_lua_filematches);
+
+        {
+            benchmark_timer timer("filematches: lua", count);
+            REQUIRE_LUA_DO_STRING(lua, "lua_filematches('')");
+        }
+
+        {
+            benchmark_timer timer("filematches: native", count);
+            REQUIRE_LUA_DO_STRING(lua, "native_filematches('')");
+        }
+
+        REQUIRE_LUA_DO_STRING(lua, "collectgarbage()");
+    }
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "line_state_lua.h"
+#include "line_states_lua.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <lib/cmd_tokenisers.h>
+#include <lib/word_collector.h>
+#include <lua/lua_state.h>
+
+#include <memory>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua line_state snapshot")
+{
+    cmd_command_tokeniser command_tokeniser;
+    cmd_word_tokeniser word_tokeniser;
+    word_collector collector(&command_tokeniser, &word_tokeniser, "\"");
+
+    str<> line("abc def & xyz qr");
+    const uint32 cursor = line.length();
+
+    words words;
+    commands commands;
+    collector.collect_words(line.c_str(), line.length(), cursor, words, collect_words_mode::whole_command, &commands);
+
+    command_line_states states;
+    states.set(line.c_str(), line.length(), cursor, words, collect_words_mode::whole_command, commands);
+
+    auto snapshot = std::make_shared<const command_line_snapshot>(states.get_linestates(line.c_str(), line.length()));
+    REQUIRE(snapshot->get_linestate().get_word_count() == 2);
+
+    lua_state lua;
+    lua_State* state = lua.get_state();
+    save_stack_top ss(state);
+
+    // Same as the async suggestions:  "line" and "lines" share the snapshot.
+    line_state_lua::make_new(state, snapshot, uint32(snapshot->get_linestates().size() - 1));
+    lua_setglobal(state, "line");
+    line_states_lua::make_new(state, snapshot);
+    lua_setglobal(state, "lines");
+
+    SECTION("Overwrite detaches")
+    {
+        REQUIRE(lua.do_string("other = line:_break_word(1, 1)"));
+        REQUIRE(lua.do_string("assert(other:getwordcount() == 3)"));
+        REQUIRE(lua.do_string("assert(line:_overwrite_from(other))"));
+
+        // Only the object that was overwritten changes.
+        REQUIRE(lua.do_string("assert(line:getwordcount() == 3)"));
+        REQUIRE(lua.do_string("assert(line:getword(1) == 'x')"));
+        REQUIRE(lua.do_string("assert(lines[#lines].line_state:getwordcount() == 2)"));
+        REQUIRE(lua.do_string("assert(lines[#lines].line_state:getword(1) == 'xyz')"));
+        REQUIRE(snapshot->get_linestate().get_word_count() == 2);
+    }
+}
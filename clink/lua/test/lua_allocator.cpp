@@ -0,0 +1,196 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "lua_allocator.h"
+
+#include <core/base.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static void* do_alloc(lua_allocator& a, size_t size)
+{
+    return lua_allocator::alloc(&a, nullptr, LUA_TSTRING, size);
+}
+
+//------------------------------------------------------------------------------
+static void* do_realloc(lua_allocator& a, void* ptr, size_t osize, size_t nsize)
+{
+    return lua_allocator::alloc(&a, ptr, osize, nsize);
+}
+
+//------------------------------------------------------------------------------
+static void do_free(lua_allocator& a, void* ptr, size_t size)
+{
+    REQUIRE(lua_allocator::alloc(&a, ptr, size, 0) == nullptr);
+}
+
+//------------------------------------------------------------------------------
+static void fill(void* ptr, size_t size, uint8 seed)
+{
+    uint8* p = static_cast<uint8*>(ptr);
+    for (size_t i = 0; i < size; ++i)
+        p[i] = uint8(seed + i);
+}
+
+//------------------------------------------------------------------------------
+static bool check(const void* ptr, size_t size, uint8 seed)
+{
+    const uint8* p = static_cast<const uint8*>(ptr);
+    for (size_t i = 0; i < size; ++i)
+        if (p[i] != uint8(seed + i))
+            return false;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static lua_allocator::stats get_stats(const lua_allocator& a)
+{
+    lua_allocator::stats stats;
+    a.get_stats(stats);
+    return stats;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua allocator")
+{
+    lua_allocator a;
+
+    SECTION("Size classes")
+    {
+        // Every size up to the largest pooled size class and a bit beyond,
+        // so both pooled and heap blocks are covered.
+        void* blocks[300];
+        for (size_t size = 1; size < sizeof_array(blocks); ++size)
+        {
+            blocks[size] = do_alloc(a, size);
+            REQUIRE(blocks[size]);
+            fill(blocks[size], size, uint8(size));
+        }
+
+        for (size_t size = 1; size < sizeof_array(blocks); ++size)
+            REQUIRE(check(blocks[size], size, uint8(size)));
+
+        for (size_t size = 1; size < sizeof_array(blocks); ++size)
+            do_free(a, blocks[size], size);
+
+        REQUIRE(get_stats(a).in_use == 0);
+    }
+
+    SECTION("Reuse")
+    {
+        // A freed block is reused by the next allocation in its size class,
+        // without reserving more pool memory.
+        void* p = do_alloc(a, 40);
+        const size_t pooled = get_stats(a).pooled;
+        REQUIRE(pooled > 0);
+        do_free(a, p, 40);
+
+        void* q = do_alloc(a, 33);
+        REQUIRE(q == p);
+        REQUIRE(get_stats(a).pooled == pooled);
+        do_free(a, q, 33);
+    }
+
+    SECTION("Realloc")
+    {
+        void* p = do_alloc(a, 10);
+        fill(p, 10, 1);
+
+        // Within a size class the block doesn't move.
+        REQUIRE(do_realloc(a, p, 10, 16) == p);
+
+        // Growing into a larger pooled class.
+        p = do_realloc(a, p, 16, 100);
+        REQUIRE(p);
+        REQUIRE(check(p, 10, 1));
+        fill(p, 100, 2);
+
+        // Growing onto the heap.
+        p = do_realloc(a, p, 100, 1000);
+        REQUIRE(p);
+        REQUIRE(check(p, 100, 2));
+        fill(p, 1000, 3);
+
+        // Resizing on the heap.
+        p = do_realloc(a, p, 1000, 5000);
+        REQUIRE(p);
+        REQUIRE(check(p, 1000, 3));
+        REQUIRE(get_stats(a).in_use == 5000);
+
+        // Shrinking back into a pooled class.
+        p = do_realloc(a, p, 5000, 20);
+        REQUIRE(p);
+        REQUIRE(check(p, 20, 3));
+        REQUIRE(get_stats(a).in_use == 20);
+
+        do_free(a, p, 20);
+        REQUIRE(get_stats(a).in_use == 0);
+    }
+
+    SECTION("Oversize")
+    {
+        // Heap blocks don't reserve pool memory, and freeing them returns
+        // them to the heap.
+        void* p = do_alloc(a, 64 * 1024);
+        REQUIRE(p);
+        fill(p, 64 * 1024, 4);
+        REQUIRE(get_stats(a).in_use == 64 * 1024);
+        REQUIRE(get_stats(a).pooled == 0);
+
+        do_free(a, p, 64 * 1024);
+        REQUIRE(get_stats(a).in_use == 0);
+        REQUIRE(get_stats(a).pooled == 0);
+    }
+
+    SECTION("Stats")
+    {
+        a.begin_edit();
+        void* p = do_alloc(a, 100);
+        void* q = do_alloc(a, 1000);
+        p = do_realloc(a, p, 100, 200);
+
+        // Growth counts as newly allocated bytes; the moved bytes don't.
+        lua_allocator::stats stats = get_stats(a);
+        REQUIRE(stats.in_use == 1200);
+        REQUIRE(stats.allocated == 1200);
+        REQUIRE(stats.edit_allocated == 1200);
+        REQUIRE(stats.prev_allocated == 0);
+
+        do_free(a, q, 1000);
+        a.begin_edit();
+        stats = get_stats(a);
+        REQUIRE(stats.in_use == 200);
+        REQUIRE(stats.allocated == 1200);
+        REQUIRE(stats.edit_allocated == 0);
+        REQUIRE(stats.prev_allocated == 1200);
+
+        do_free(a, p, 200);
+    }
+
+    SECTION("GC work")
+    {
+        REQUIRE(!a.has_gc_work());
+
+        // Enough allocation makes an idle collection worthwhile.
+        for (uint32 i = 0; i < 100 && !a.has_gc_work(); ++i)
+            do_free(a, do_alloc(a, 4096), 4096);
+        REQUIRE(a.has_gc_work());
+
+        // An unfinished cycle still has work; a finished one resets it.
+        a.on_gc_step(0.001, false);
+        REQUIRE(a.has_gc_work());
+        a.on_gc_step(0.002, true);
+        REQUIRE(!a.has_gc_work());
+
+        const lua_allocator::stats stats = get_stats(a);
+        REQUIRE(stats.gc_steps == 2);
+        REQUIRE(stats.gc_cycles == 1);
+        REQUIRE(stats.gc_max_pause == 0.002);
+    }
+}
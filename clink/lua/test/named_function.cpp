@@ -0,0 +1,122 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include <core/base.h>
+#include <core/str.h>
+#include <lua/lua_state.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static int32 call_named_function(lua_state& lua, const char* func_name, str_base* msg=nullptr)
+{
+    lua_State* state = lua.get_state();
+    save_stack_top ss(state);
+
+    if (!lua.push_named_function(state, func_name, msg))
+        return -1;
+
+    if (lua.pcall_silent(0, 1) != LUA_OK)
+        return -2;
+
+    return int32(lua_tointeger(state, -1));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua named functions")
+{
+    lua_state lua;
+
+    REQUIRE(lua.do_string("named = { sub = { f = function() return 1 end } }"));
+    REQUIRE(lua.do_string("function global_f() return 7 end"));
+
+    SECTION("Resolve")
+    {
+        REQUIRE(call_named_function(lua, "global_f") == 7);
+        REQUIRE(call_named_function(lua, "named.sub.f") == 1);
+        REQUIRE(call_named_function(lua, "named.sub.f") == 1);
+    }
+
+    SECTION("Stack")
+    {
+        // Parent tables are left on the stack below the function.
+        lua_State* state = lua.get_state();
+        save_stack_top ss(state);
+        const int32 top = lua_gettop(state);
+        REQUIRE(lua.push_named_function(state, "named.sub.f"));
+        REQUIRE(lua_gettop(state) == top + 3);
+        REQUIRE(lua_isfunction(state, -1));
+        REQUIRE(lua_istable(state, -2));
+        REQUIRE(lua_istable(state, -3));
+    }
+
+    SECTION("Reassign")
+    {
+        REQUIRE(call_named_function(lua, "named.sub.f") == 1);
+
+        REQUIRE(lua.do_string("named.sub.f = function() return 2 end"));
+        REQUIRE(call_named_function(lua, "named.sub.f") == 2);
+
+        REQUIRE(lua.do_string("named = { sub = { f = function() return 3 end } }"));
+        REQUIRE(call_named_function(lua, "named.sub.f") == 3);
+
+        REQUIRE(lua.do_string("global_f = function() return 8 end"));
+        REQUIRE(call_named_function(lua, "global_f") == 8);
+    }
+
+    SECTION("Errors")
+    {
+        str<> msg;
+
+        REQUIRE(lua.do_string("named.sub = nil"));
+        REQUIRE(call_named_function(lua, "named.sub.f", &msg) == -1);
+        REQUIRE(msg.equals("can't execute 'named.sub.f'; 'named.sub' is nil\n"));
+
+        REQUIRE(lua.do_string("named.sub = 5"));
+        REQUIRE(call_named_function(lua, "named.sub.f", &msg) == -1);
+        REQUIRE(msg.equals("can't execute 'named.sub.f'; 'named.sub' is not a table\n"));
+
+        REQUIRE(lua.do_string("named.sub = { f = 5 }"));
+        REQUIRE(call_named_function(lua, "named.sub.f", &msg) == -1);
+        REQUIRE(msg.equals("can't execute 'named.sub.f'; not a function\n"));
+
+        REQUIRE(lua.do_string("named.sub = { f = function() return 4 end }"));
+        REQUIRE(call_named_function(lua, "named.sub.f", &msg) == 4);
+    }
+
+    SECTION("Reload")
+    {
+        REQUIRE(call_named_function(lua, "named.sub.f") == 1);
+
+        str<> msg;
+        lua.initialise();
+        REQUIRE(call_named_function(lua, "named.sub.f", &msg) == -1);
+
+        REQUIRE(lua.do_string("named = { sub = { f = function() return 5 end } }"));
+        REQUIRE(call_named_function(lua, "named.sub.f") == 5);
+    }
+
+    SECTION("Switch states")
+    {
+        // Switching to another state releases the registry refs held for the
+        // first one, so switching back and forth doesn't grow the registry.
+        lua_State* state = lua.get_state();
+        REQUIRE(call_named_function(lua, "named.sub.f") == 1);
+        const size_t len = lua_rawlen(state, LUA_REGISTRYINDEX);
+
+        for (int32 i = 0; i < 3; ++i)
+        {
+            lua_state other;
+            REQUIRE(other.do_string("named = { sub = { f = function() return 6 end } }"));
+            REQUIRE(call_named_function(other, "named.sub.f") == 6);
+            REQUIRE(call_named_function(lua, "named.sub.f") == 1);
+        }
+
+        REQUIRE(lua_rawlen(state, LUA_REGISTRYINDEX) == len);
+    }
+}
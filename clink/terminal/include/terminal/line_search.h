@@ -0,0 +1,42 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "find_line.h"
+
+#include <core/str.h>
+
+#include <memory>
+#include <regex>
+
+//------------------------------------------------------------------------------
+// Searches one row of console text at a time for text and/or attributes.  It
+// does no console I/O, so it can run against synthetic rows; find_line() reads
+// the console and feeds rows to it.
+class line_searcher
+{
+public:
+                        line_searcher() = default;
+                        line_searcher(const line_searcher&) = delete;
+    bool                init(const char* text, find_line_mode mode);
+    void                init_attrs(const BYTE* attrs, int32 num_attrs, BYTE mask);
+
+    bool                has_text() const { return m_has_text; }
+    bool                has_attrs() const { return m_has_attrs; }
+    int32               find(const wchar_t* chars, int32 len, int32& found_len) const;
+    bool                match_attr(WORD attr) const { return m_attrs[BYTE(attr) & m_mask]; }
+
+private:
+    int32               find_literal(const wchar_t* chars, int32 len) const;
+
+    bool                m_has_text = false;
+    bool                m_has_attrs = false;
+    bool                m_fold = false;
+    wstr_moveable       m_needle;           // Folded when ignoring case.
+    uint16              m_skip[256];        // Horspool shifts, by low byte.
+    std::shared_ptr<const std::wregex> m_regex;
+    mutable wstr_moveable m_folded;
+    BYTE                m_mask = 0xff;
+    bool                m_attrs[256];
+};
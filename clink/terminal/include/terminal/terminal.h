@@ -26,4 +26,5 @@ const char*         find_key_name(const char* keyseq, int32& len, int32& eqclass
 //------------------------------------------------------------------------------
 void                set_verbose_input(int32 verbose); // 1 = inline, 2 = at top of screen
 void                interrupt_input();
+DWORD               get_last_input_tick(); // GetTickCount() when input was last received.
 void                reset_keyseq_to_name_map();
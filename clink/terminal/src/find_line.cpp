@@ -3,20 +3,24 @@
 
 #include "pch.h"
 #include "find_line.h"
+#include "line_search.h"
 #include "terminal_out.h" // for find_line_mode
 
 #include <core/base.h>
 #include <core/str.h>
-#include <core/str_transform.h>
 
 #include <assert.h>
 
-#include <regex>
+#include <memory>
+
+//------------------------------------------------------------------------------
+// Number of cells to read from the console per call.  Older consoles fail
+// reads larger than 64KB, and CHAR_INFO is 4 bytes.
+static const int32 c_block_cells = 12 * 1024;
 
 //------------------------------------------------------------------------------
 int32 find_line(HANDLE h, const CONSOLE_SCREEN_BUFFER_INFO& csbi,
               wchar_t* chars_buffer, int32 chars_capacity,
-              WORD* attrs_buffer, int32 attrs_capacity,
               int32 starting_line, int32 distance,
               const char* text, find_line_mode mode,
               const BYTE* attrs, int32 num_attrs, BYTE mask)
@@ -25,128 +29,100 @@ int32 find_line(HANDLE h, const CONSOLE_SCREEN_BUFFER_INFO& csbi,
     if (!(!text || chars_capacity >= csbi.dwSize.X))
         return -2;
 
-    assert(!attrs || num_attrs <= 0 || attrs_capacity >= csbi.dwSize.X);
-    if (!(!attrs || num_attrs <= 0 || attrs_capacity >= csbi.dwSize.X))
-        return -2;
+    line_searcher searcher;
+    if (!searcher.init(text, mode))
+        return -1;
+    searcher.init_attrs(attrs, num_attrs, mask);
+
+    // Read the console in blocks of rows, in the direction of the search.
+    const int32 width = csbi.dwSize.X;
+    const int32 block_rows = max<int32>(1, c_block_cells / max<int32>(1, width));
+    std::unique_ptr<CHAR_INFO[]> block;
+    std::unique_ptr<int32[]> columns;
+    int32 block_top = 0;
+    int32 block_count = 0;
 
-    wstr_moveable find;
-    wstr_moveable tmp;
-    std::unique_ptr<std::wregex> regex;
-    if (text && *text)
+    while (distance != 0)
     {
-        find = text;
+        if (starting_line < 0 || starting_line >= csbi.dwSize.Y)
+            return 0;
 
-        if (mode & find_line_mode::use_regex)
+        if (starting_line < block_top || starting_line >= block_top + block_count)
         {
-            std::regex_constants::syntax_option_type syntax = std::regex_constants::ECMAScript;
-            if (mode & find_line_mode::ignore_case)
-                syntax |= std::regex_constants::icase;
-
-            try
+            if (!block)
             {
-                regex = std::make_unique<std::wregex>(find.c_str(), syntax);
+                block = std::unique_ptr<CHAR_INFO[]>(new CHAR_INFO[block_rows * width]);
+                columns = std::unique_ptr<int32[]>(new int32[width + 1]);
             }
-            catch (std::regex_error ex)
-            {
+
+            const int32 rows = min<int32>(block_rows, abs(distance));
+            const int32 top = (distance > 0) ? starting_line : max<int32>(0, starting_line - rows + 1);
+            const int32 bottom = min<int32>(csbi.dwSize.Y - 1, top + rows - 1);
+
+            COORD size = { SHORT(width), SHORT(bottom + 1 - top) };
+            COORD origin = { 0, 0 };
+            SMALL_RECT rect = { 0, SHORT(top), SHORT(width - 1), SHORT(bottom) };
+            if (!ReadConsoleOutputW(h, block.get(), size, origin, &rect))
+                return -1;
+            if (rect.Top != top || rect.Bottom < rect.Top || rect.Right != width - 1)
+                return -1;
+
+            block_top = rect.Top;
+            block_count = rect.Bottom + 1 - rect.Top;
+            if (starting_line >= block_top + block_count)
                 return -1;
-            }
-        }
-        else
-        {
-            find = text;
-            if (mode & find_line_mode::ignore_case)
-            {
-                str_transform(find.c_str(), find.length(), tmp, transform_mode::lower);
-                find = std::move(tmp);
-            }
         }
-    }
 
-    int32 start_found = 0;
-    int32 len_found = csbi.dwSize.X;
-
-    while (distance != 0)
-    {
-        if (starting_line < 0 || starting_line >= csbi.dwSize.Y)
-            return 0;
+        const CHAR_INFO* row = block.get() + (starting_line - block_top) * width;
 
+        int32 col_begin = 0;
+        int32 col_end = width;
         bool found_text = true;
         if (text)
         {
-            COORD coord = { 0, SHORT(starting_line) };
-            DWORD len = 0;
-            if (!ReadConsoleOutputCharacterW(h, chars_buffer, csbi.dwSize.X, coord, &len))
-                return -1;
-            if (len != csbi.dwSize.X)
-                return -1;
+            // The second cell of a full width character repeats the
+            // character; skip it the same as ReadConsoleOutputCharacterW
+            // does.  Remember which column each character came from, to find
+            // its attributes.
+            int32 len = 0;
+            for (int32 col = 0; col < width; ++col)
+            {
+                if (row[col].Attributes & COMMON_LVB_TRAILING_BYTE)
+                    continue;
+                columns[len] = col;
+                chars_buffer[len++] = row[col].Char.UnicodeChar;
+            }
+            columns[len] = width;
 
             while (len > 0 && iswspace(chars_buffer[len - 1]))
                 len--;
             chars_buffer[len] = '\0';
 
-            const wchar_t* line_text = chars_buffer;
-            if (!regex && (mode & find_line_mode::ignore_case))
-            {
-                str_transform(chars_buffer, len, tmp, transform_mode::lower);
-                line_text = tmp.c_str();
-                len = tmp.length();
-            }
-
-            if (regex)
-            {
-                std::wcmatch matches;
-                try
-                {
-                    std::regex_search(line_text, line_text + len, matches, *regex, std::regex_constants::match_default);
-                }
-                catch (std::regex_error ex)
-                {
-                    return -2;
-                }
+            int32 len_found;
+            const int32 start_found = searcher.find(chars_buffer, len, len_found);
+            if (start_found == -2)
+                return -2;
 
-                found_text = matches.size() > 0;
-                if (found_text)
-                {
-                    start_found = int32(matches.position(0));
-                    len_found = int32(matches.length(0));
-                }
-            }
-            else
+            found_text = (start_found >= 0);
+            if (found_text)
             {
-                // Presume that str_transform preserved the alignment between
-                // text and attributes.
-                const wchar_t* found = wcsstr(chars_buffer, find.c_str());
-                found_text = !!found;
-                start_found = int32(found - chars_buffer);
-                len_found = find.length();
+                col_begin = columns[start_found];
+                col_end = columns[start_found + len_found];
             }
         }
 
         bool found_attr = true;
-        if (attrs && num_attrs)
+        if (found_text && searcher.has_attrs())
         {
             found_attr = false;
-
-            COORD coord = { SHORT(start_found), SHORT(starting_line) };
-            DWORD len = 0;
-            if (!ReadConsoleOutputAttribute(h, attrs_buffer, len_found, coord, &len))
-                return -2;
-            if (len != len_found)
-                return -2;
-
-            const BYTE* end_attrs = attrs + num_attrs;
-            for (const WORD* attr = attrs_buffer; len--; attr++)
+            for (int32 col = col_begin; col < col_end; ++col)
             {
-                for (const BYTE* find_attr = attrs; find_attr < end_attrs; find_attr++)
-                    if ((BYTE(*attr) & mask) == (*find_attr & mask))
-                    {
-                        found_attr = true;
-                        goto break_break;
-                    }
+                if (searcher.match_attr(row[col].Attributes))
+                {
+                    found_attr = true;
+                    break;
+                }
             }
-
-break_break:
-            ;
         }
 
         if (found_text && found_attr)
@@ -0,0 +1,217 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "line_search.h"
+
+#include <core/base.h>
+
+#include <assert.h>
+
+#include <list>
+#include <mutex>
+
+//------------------------------------------------------------------------------
+// Scripts tend to search for the same few patterns over and over (e.g. the
+// prompt, or error messages), and compiling a std::wregex is expensive.
+struct regex_cache_entry
+{
+    wstr_moveable       pattern;
+    bool                icase;
+    std::shared_ptr<const std::wregex> regex;
+};
+
+//------------------------------------------------------------------------------
+static const size_t c_max_cached_regex = 16;
+static std::mutex s_regex_mutex;
+static std::list<regex_cache_entry> s_regex_cache;
+
+//------------------------------------------------------------------------------
+static std::shared_ptr<const std::wregex> get_regex(const wchar_t* pattern, bool icase)
+{
+    std::lock_guard<std::mutex> lock(s_regex_mutex);
+
+    for (auto iter = s_regex_cache.begin(); iter != s_regex_cache.end(); ++iter)
+    {
+        if (iter->icase == icase && wcscmp(iter->pattern.c_str(), pattern) == 0)
+        {
+            // Most recently used goes first.
+            s_regex_cache.splice(s_regex_cache.begin(), s_regex_cache, iter);
+            return s_regex_cache.front().regex;
+        }
+    }
+
+    std::regex_constants::syntax_option_type syntax = std::regex_constants::ECMAScript|std::regex_constants::optimize;
+    if (icase)
+        syntax |= std::regex_constants::icase;
+
+    std::shared_ptr<const std::wregex> regex;
+    try
+    {
+        regex = std::make_shared<const std::wregex>(pattern, syntax);
+    }
+    catch (std::regex_error ex)
+    {
+        return nullptr;
+    }
+
+    regex_cache_entry entry;
+    entry.pattern = pattern;
+    entry.icase = icase;
+    entry.regex = regex;
+    s_regex_cache.emplace_front(std::move(entry));
+    if (s_regex_cache.size() > c_max_cached_regex)
+        s_regex_cache.pop_back();
+
+    return regex;
+}
+
+//------------------------------------------------------------------------------
+static bool has_regex_syntax(const wchar_t* pattern)
+{
+    return !!wcspbrk(pattern, L"\\^$.|?*+()[]{}");
+}
+
+//------------------------------------------------------------------------------
+static void fold_case(const wchar_t* in, int32 len, wstr_base& out)
+{
+    // CharLowerBuffW maps each code unit in place, so offsets in the folded
+    // text are the same as in the original text.
+    out.clear();
+    out.concat(in, len);
+    if (len)
+        CharLowerBuffW(out.data(), len);
+}
+
+
+
+//------------------------------------------------------------------------------
+bool line_searcher::init(const char* text, find_line_mode mode)
+{
+    m_has_text = false;
+    m_fold = false;
+    m_regex.reset();
+    m_needle.clear();
+
+    if (!text)
+        return true;
+
+    m_has_text = true;
+    m_needle = text;
+    if (m_needle.empty())
+        return true;
+
+    // Patterns without any regex syntax are searched for literally.
+    if ((mode & find_line_mode::use_regex) && has_regex_syntax(m_needle.c_str()))
+    {
+        m_regex = get_regex(m_needle.c_str(), !!(mode & find_line_mode::ignore_case));
+        return !!m_regex;
+    }
+
+    m_fold = !!(mode & find_line_mode::ignore_case);
+    if (m_fold)
+    {
+        wstr_moveable tmp;
+        fold_case(m_needle.c_str(), m_needle.length(), tmp);
+        m_needle = std::move(tmp);
+    }
+
+    // Horspool shift table.  Code units are bucketed by their low byte, so
+    // each bucket gets the smallest shift of any code unit in it.
+    const uint32 n = m_needle.length();
+    const uint16 shift_max = uint16(min<uint32>(n, 0xffff));
+    for (auto& skip : m_skip)
+        skip = shift_max;
+    for (uint32 i = 0; i + 1 < n; ++i)
+        m_skip[m_needle.c_str()[i] & 0xff] = uint16(min<uint32>(n - 1 - i, 0xffff));
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void line_searcher::init_attrs(const BYTE* attrs, int32 num_attrs, BYTE mask)
+{
+    m_has_attrs = (attrs && num_attrs > 0);
+    m_mask = mask;
+    memset(m_attrs, 0, sizeof(m_attrs));
+    if (m_has_attrs)
+    {
+        for (int32 i = 0; i < num_attrs; ++i)
+            m_attrs[attrs[i] & mask] = true;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns the offset of the first match in chars, or -1 if not found, or -2
+// if the regex search failed.
+int32 line_searcher::find(const wchar_t* chars, int32 len, int32& found_len) const
+{
+    found_len = 0;
+    if (!m_has_text || m_needle.empty())
+        return 0;
+
+    if (m_regex)
+    {
+        std::wcmatch matches;
+        try
+        {
+            if (!std::regex_search(chars, chars + len, matches, *m_regex, std::regex_constants::match_default))
+                return -1;
+        }
+        catch (std::regex_error ex)
+        {
+            return -2;
+        }
+
+        found_len = int32(matches.length(0));
+        return int32(matches.position(0));
+    }
+
+    if (m_fold)
+    {
+        fold_case(chars, len, m_folded);
+        chars = m_folded.c_str();
+    }
+
+    const int32 found = find_literal(chars, len);
+    if (found >= 0)
+        found_len = m_needle.length();
+    return found;
+}
+
+//------------------------------------------------------------------------------
+int32 line_searcher::find_literal(const wchar_t* chars, int32 len) const
+{
+    const wchar_t* const needle = m_needle.c_str();
+    const int32 n = m_needle.length();
+    if (n > len)
+        return -1;
+
+    // Short needles:  let wmemchr find candidates for the first code unit.
+    if (n < 3)
+    {
+        const wchar_t* p = chars;
+        const wchar_t* const last = chars + len - n;
+        while (p <= last)
+        {
+            p = wmemchr(p, needle[0], last - p + 1);
+            if (!p)
+                break;
+            if (n == 1 || p[1] == needle[1])
+                return int32(p - chars);
+            ++p;
+        }
+        return -1;
+    }
+
+    // Longer needles:  Horspool.
+    const wchar_t tail = needle[n - 1];
+    for (int32 pos = 0; pos <= len - n;)
+    {
+        const wchar_t c = chars[pos + n - 1];
+        if (c == tail && wmemcmp(chars + pos, needle, n - 1) == 0)
+            return pos;
+        pos += m_skip[c & 0xff];
+    }
+    return -1;
+}
@@ -1317,12 +1317,9 @@ int32 win_screen_buffer::find_line(int32 starting_line, int32 distance, const ch
 
     if (text && !ensure_chars_buffer(csbi.dwSize.X))
         return -2;
-    if (attrs && num_attrs > 0 && !ensure_attrs_buffer(csbi.dwSize.X))
-        return -2;
 
     return ::find_line(m_handle, csbi,
                        m_chars, m_chars_capacity,
-                       m_attrs, m_attrs_capacity,
                        starting_line, distance,
                        text, mode,
                        attrs, num_attrs, mask);
@@ -253,6 +253,13 @@ void interrupt_input()
         SetEvent(s_interrupt);
 }
 
+//------------------------------------------------------------------------------
+static DWORD s_last_input_tick = 0;
+DWORD get_last_input_tick()
+{
+    return s_last_input_tick;
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -1278,6 +1285,8 @@ void win_terminal_in::read_console(input_idle* callback, DWORD _timeout, bool pe
             return;
         }
 
+        s_last_input_tick = GetTickCount();
+
         if (peek)
         {
             if (peek_record(record))
@@ -0,0 +1,137 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "clatch.h" // (so that VSCode can parse the macros, since it parses the wrong pch.h file)
+
+#include "benchmark.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <terminal/line_search.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static int32 find(const line_searcher& searcher, const char* line, int32& found_len)
+{
+    wstr<> wline(line);
+    return searcher.find(wline.c_str(), wline.length(), found_len);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Line search")
+{
+    line_searcher searcher;
+    int32 len;
+
+    SECTION("Literal")
+    {
+        REQUIRE(searcher.init("needle", find_line_mode::none));
+        REQUIRE(find(searcher, "a needle in a haystack", len) == 2);
+        REQUIRE(len == 6);
+        REQUIRE(find(searcher, "needle", len) == 0);
+        REQUIRE(find(searcher, "needl", len) == -1);
+        REQUIRE(find(searcher, "A NEEDLE", len) == -1);
+
+        REQUIRE(searcher.init("x", find_line_mode::none));
+        REQUIRE(find(searcher, "abcx", len) == 3);
+        REQUIRE(find(searcher, "", len) == -1);
+
+        REQUIRE(searcher.init("xy", find_line_mode::none));
+        REQUIRE(find(searcher, "xxxy", len) == 2);
+        REQUIRE(find(searcher, "xxx", len) == -1);
+    }
+
+    SECTION("Ignore case")
+    {
+        REQUIRE(searcher.init("NeEdLe", find_line_mode::ignore_case));
+        REQUIRE(find(searcher, "A NEEDLE", len) == 2);
+        REQUIRE(len == 6);
+        REQUIRE(find(searcher, "a needle", len) == 2);
+        REQUIRE(find(searcher, "\xc3\x84 Needle", len) == 2); // Offsets are in UTF-16 code units.
+        REQUIRE(find(searcher, "needl", len) == -1);
+    }
+
+    SECTION("Regex")
+    {
+        REQUIRE(searcher.init("err(or)?\\s+\\d+", find_line_mode::use_regex));
+        REQUIRE(find(searcher, "an error 42 occurred", len) == 3);
+        REQUIRE(len == 8);
+        REQUIRE(find(searcher, "an ERROR 42 occurred", len) == -1);
+
+        REQUIRE(searcher.init("err(or)?\\s+\\d+", find_line_mode::use_regex|find_line_mode::ignore_case));
+        REQUIRE(find(searcher, "an ERROR 42 occurred", len) == 3);
+
+        // No regex syntax, so it's searched for literally.
+        REQUIRE(searcher.init("plain", find_line_mode::use_regex));
+        REQUIRE(find(searcher, "is plain", len) == 3);
+
+        REQUIRE(!searcher.init("bad(", find_line_mode::use_regex));
+    }
+
+    SECTION("Attributes")
+    {
+        const BYTE attrs[] = { 0x1e, 0x4f };
+        searcher.init_attrs(attrs, sizeof_array(attrs), 0x0f);
+        REQUIRE(searcher.has_attrs());
+        REQUIRE(searcher.match_attr(0x0e));
+        REQUIRE(searcher.match_attr(0x7f));
+        REQUIRE(!searcher.match_attr(0x10));
+
+        searcher.init_attrs(nullptr, 0, 0xff);
+        REQUIRE(!searcher.has_attrs());
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Line search benchmark")
+{
+    if (!g_run_benchmarks)
+        return;
+
+    // A synthetic 9999 line scrollback, with the match on the last line.
+    const int32 rows = 9999;
+    std::vector<wstr_moveable> grid;
+    grid.reserve(rows);
+    str<> line;
+    for (int32 i = 0; i < rows; ++i)
+    {
+        line.format("c:\\src\\project\\module%d> build --target=all --verbose 2>&1 | tee build%d.log", i % 97, i);
+        if (i == rows - 1)
+            line << "  fatal error C1083: cannot open include file";
+        grid.emplace_back(line.c_str());
+    }
+
+    struct testcase { const char* name; const char* text; find_line_mode mode; };
+    static const testcase tests[] = {
+        { "literal", "fatal error", find_line_mode::none },
+        { "ignore case", "FATAL ERROR", find_line_mode::ignore_case },
+        { "regex", "error C\\d+:", find_line_mode::use_regex },
+    };
+
+    const uint32 count = 10;
+    for (const auto& t : tests)
+    {
+        line_searcher searcher;
+        REQUIRE(searcher.init(t.text, t.mode));
+
+        str<> name;
+        name.format("find_line scan (%s)", t.name);
+        benchmark_timer timer(name.c_str(), count);
+        for (uint32 n = 0; n < count; ++n)
+        {
+            int32 found_row = -1;
+            for (int32 i = 0; i < rows; ++i)
+            {
+                int32 len;
+                if (searcher.find(grid[i].c_str(), grid[i].length(), len) >= 0)
+                {
+                    found_row = i;
+                    break;
+                }
+            }
+            REQUIRE(found_row == rows - 1);
+        }
+    }
+}
@@ -0,0 +1,23 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "benchmark.h"
+
+//------------------------------------------------------------------------------
+bool g_run_benchmarks = false;
+
+//------------------------------------------------------------------------------
+benchmark_timer::benchmark_timer(const char* name, uint32 count)
+: m_name(name)
+, m_count(count)
+{
+}
+
+//------------------------------------------------------------------------------
+benchmark_timer::~benchmark_timer()
+{
+    const double elapsed = m_clock.elapsed();
+    const double per_item = m_count ? elapsed * 1000000000.0 / m_count : 0.0;
+    printf("\n    %-32s %9u items %10.3f ms %9.1f ns/item", m_name, m_count, elapsed * 1000.0, per_item);
+}
@@ -0,0 +1,24 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/os.h>
+
+//------------------------------------------------------------------------------
+// Benchmarks only run when the test harness is given the -b flag, so that
+// normal test runs stay fast.
+extern bool g_run_benchmarks;
+
+//------------------------------------------------------------------------------
+class benchmark_timer
+{
+public:
+                    benchmark_timer(const char* name, uint32 count);
+                    ~benchmark_timer();
+    double          elapsed() const { return m_clock.elapsed(); }
+private:
+    const char*     m_name;
+    const uint32    m_count;
+    os::high_resolution_clock m_clock;
+};
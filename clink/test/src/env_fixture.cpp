@@ -4,6 +4,7 @@
 #include "pch.h"
 #include "env_fixture.h"
 
+#include <core/env_snapshot.h>
 #include <core/str.h>
 
 //------------------------------------------------------------------------------
@@ -21,6 +22,10 @@ env_fixture::env_fixture(const char** env)
         REQUIRE(SetEnvironmentVariable(env[0], env[1]) != FALSE);
         env += 2;
     }
+
+    // The environment was changed behind os::set_env()'s back, so make sure
+    // executable searches see the test environment.
+    env_snapshot::refresh();
 }
 
 //------------------------------------------------------------------------------
@@ -38,6 +43,8 @@ env_fixture::~env_fixture()
     }
 
     FreeEnvironmentStringsW(m_env_strings);
+
+    env_snapshot::refresh();
 }
 
 //------------------------------------------------------------------------------
@@ -3,6 +3,9 @@
 
 #include "pch.h"
 
+#include "benchmark.h"
+
+#include <core/exec_index.h>
 #include <core/str.h>
 #include <core/settings.h>
 #include <core/os.h>
@@ -90,11 +93,16 @@ int32 main(int32 argc, char** argv)
         {
             puts("Options:\n"
                  "  -?        Show this help.\n"
+                 "  -b        Run benchmarks.\n"
                  "  -d        Load Lua debugger.\n"
                  "  -dd       Force break on Lua errors.\n"
                  "  -t        Show individual test times.");
             return 1;
         }
+        else if (!strcmp(argv[0], "-b"))
+        {
+            g_run_benchmarks = true;
+        }
         else if (!strcmp(argv[0], "-d"))
         {
             d_flag++;
@@ -145,6 +153,7 @@ int32 main(int32 argc, char** argv)
     int32 result = (clatch::run(prefix, times) != true);
 
     shutdown_recognizer();
+    exec_index::shutdown();
     shutdown_task_manager(true/*final*/);
 
     DWORD elapsed = GetTickCount() - start;
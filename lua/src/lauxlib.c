@@ -1024,11 +1024,23 @@ static int panic (lua_State *L) {
 }
 
 
-LUALIB_API lua_State *luaL_newstate (void) {
-  lua_State *L = lua_newstate(l_alloc, NULL);
+/* begin_clink_change */
+LUALIB_API lua_State *luaL_newstatex (lua_Alloc f, void *ud) {
+  lua_State *L = lua_newstate(f, ud);
   if (L) lua_atpanic(L, &panic);
   return L;
 }
+/* end_clink_change */
+
+
+LUALIB_API lua_State *luaL_newstate (void) {
+/* begin_clink_change */
+  //lua_State *L = lua_newstate(l_alloc, NULL);
+  //if (L) lua_atpanic(L, &panic);
+  //return L;
+  return luaL_newstatex(l_alloc, NULL);
+/* end_clink_change */
+}
 
 
 LUALIB_API void luaL_checkversion_ (lua_State *L, lua_Number ver) {
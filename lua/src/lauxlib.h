@@ -88,6 +88,9 @@ LUALIB_API int (luaL_loadbufferx) (lua_State *L, const char *buff, size_t sz,
 LUALIB_API int (luaL_loadstring) (lua_State *L, const char *s);
 
 LUALIB_API lua_State *(luaL_newstate) (void);
+/* begin_clink_change */
+LUALIB_API lua_State *(luaL_newstatex) (lua_Alloc f, void *ud);
+/* end_clink_change */
 
 LUALIB_API int (luaL_len) (lua_State *L, int idx);
 
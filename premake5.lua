@@ -629,6 +629,7 @@ clink_exe("clink_test")
     includedirs("clink/lib/include/lib")
     includedirs("clink/lib/src")
     includedirs("clink/lua/include")
+    includedirs("clink/lua/src")
     includedirs("clink/process/include")
     includedirs("clink/terminal/include")
     includedirs("wildmatch/wildmatch")
@@ -299,7 +299,11 @@ int rl_visible_stats = 0;
 /* begin_clink_change */
 /* If non-zero, this is the address of a function to call when
    freeing a match list.  This can, for instance, allow a host to
-   free any data that it had associated with the match list. */
+   free any data that it had associated with the match list.  The
+   host may also free strings that it owns (e.g. strings packed into
+   a single arena allocation) and remove them from the list, as long
+   as the list stays NULL terminated; any strings that remain in the
+   list are freed individually afterwards. */
 rl_vcppfunc_t *rl_free_match_list_hook = (rl_vcppfunc_t *)NULL;
 /* end_clink_change */
 
@@ -2916,6 +2920,8 @@ _rl_free_match_list (char **matches)
     return;
 
 /* begin_clink_change */
+  /* The hook may release host-owned strings in one step and remove
+     them from the list, so only the remaining strings are freed. */
   if (rl_free_match_list_hook)
     rl_free_match_list_hook (matches);
 /* end_clink_change */
@@ -81,6 +81,70 @@ static int history_stifled;
 /* The current number of slots allocated to the input_history. */
 static int history_size;
 
+/* begin_clink_change */
+/* When the history is stifled, evicting the oldest entry advances the_history
+   within the allocation instead of moving every entry down one slot.  The
+   entries are only moved back to the start of the allocation when the window
+   reaches the end, so eviction is O(1) amortized and history_list() still
+   returns a contiguous NULL terminated array.  HISTORY_SIZE is the number of
+   slots from the_history to the end of the allocation. */
+static HIST_ENTRY **history_alloc = (HIST_ENTRY **)NULL;
+static int history_alloc_size;
+
+static void
+history_set_alloc (HIST_ENTRY **alloc, int size)
+{
+  history_alloc = alloc;
+  history_alloc_size = size;
+  the_history = alloc;
+  history_size = size;
+}
+
+/* Move the window back to the start of the allocation, and make sure there
+   are at least NEEDED slots. */
+static void
+history_realloc (int needed)
+{
+  int size;
+
+  if (the_history != history_alloc)
+    {
+      /* Copy includes trailing NULL. */
+      memmove (history_alloc, the_history, (history_length + 1) * sizeof (HIST_ENTRY *));
+      the_history = history_alloc;
+      history_size = history_alloc_size;
+    }
+
+  if (needed > history_alloc_size)
+    {
+      /* Grow geometrically so that loading a large history doesn't need
+	 thousands of reallocs. */
+      size = history_alloc_size + history_alloc_size / 2;
+      if (size < history_alloc_size + DEFAULT_HISTORY_GROW_SIZE)
+	size = history_alloc_size + DEFAULT_HISTORY_GROW_SIZE;
+      if (size < needed)
+	size = needed;
+      history_set_alloc ((HIST_ENTRY **)xrealloc (history_alloc, size * sizeof (HIST_ENTRY *)), size);
+    }
+}
+
+void
+history_reserve (int count)
+{
+  /* Room for the entries plus the trailing NULL. */
+  if (count <= 0 || (history_size != 0 && count + 1 <= history_size))
+    return;
+
+  if (history_size == 0)
+    {
+      history_set_alloc ((HIST_ENTRY **)xmalloc ((count + 1) * sizeof (HIST_ENTRY *)), count + 1);
+      the_history[0] = (HIST_ENTRY *)NULL;
+    }
+  else
+    history_realloc (count + 1);
+}
+/* end_clink_change */
+
 /* If HISTORY_STIFLED is non-zero, then this is the maximum number of
    entries to remember. */
 int history_max_entries;
@@ -109,6 +173,12 @@ history_get_history_state (void)
   HISTORY_STATE *state;
 
   state = (HISTORY_STATE *)xmalloc (sizeof (HISTORY_STATE));
+/* begin_clink_change */
+  /* The state owns the allocation, so the window must start at the
+     beginning of it. */
+  if (the_history != history_alloc)
+    history_realloc (0);
+/* end_clink_change */
   state->entries = the_history;
   state->offset = history_offset;
   state->length = history_length;
@@ -124,10 +194,15 @@ history_get_history_state (void)
 void
 history_set_history_state (HISTORY_STATE *state)
 {
-  the_history = state->entries;
+/* begin_clink_change */
+  //the_history = state->entries;
+  history_set_alloc (state->entries, state->size);
+/* end_clink_change */
   history_offset = state->offset;
   history_length = state->length;
-  history_size = state->size;
+/* begin_clink_change */
+  //history_size = state->size;
+/* end_clink_change */
   if (state->flags & HS_STIFLED)
     history_stifled = 1;
 /* begin_clink_change */
@@ -316,9 +391,25 @@ add_history (const char *string)
       if (the_history[0])
 	(void) free_history_entry (the_history[0]);
 
+/* begin_clink_change */
+#if 0
+/* end_clink_change */
       /* Copy the rest of the entries, moving down one slot.  Copy includes
 	 trailing NULL.  */
       memmove (the_history, the_history + 1, history_length * sizeof (HIST_ENTRY *));
+/* begin_clink_change */
+#else
+      /* Advance the window by one slot.  The slot after the trailing NULL
+	 must exist to receive the new trailing NULL; if it doesn't, first
+	 move the window back to the start of the allocation, growing it so
+	 the next move is at least HISTORY_LENGTH evictions away. */
+      the_history[0] = (HIST_ENTRY *)NULL;
+      if (history_length + 2 > history_size)
+	history_realloc (2 * (history_length + 1));
+      the_history++;
+      history_size--;
+#endif
+/* end_clink_change */
 
       new_length = history_length;
       history_base++;
@@ -333,16 +424,27 @@ add_history (const char *string)
 				: history_max_entries + 2;
 	  else
 	    history_size = DEFAULT_HISTORY_INITIAL_SIZE;
-	  the_history = (HIST_ENTRY **)xmalloc (history_size * sizeof (HIST_ENTRY *));
+/* begin_clink_change */
+	  //the_history = (HIST_ENTRY **)xmalloc (history_size * sizeof (HIST_ENTRY *));
+	  history_set_alloc ((HIST_ENTRY **)xmalloc (history_size * sizeof (HIST_ENTRY *)), history_size);
+/* end_clink_change */
 	  new_length = 1;
 	}
       else
 	{
 	  if (history_length == (history_size - 1))
 	    {
+/* begin_clink_change */
+#if 0
+/* end_clink_change */
 	      history_size += DEFAULT_HISTORY_GROW_SIZE;
 	      the_history = (HIST_ENTRY **)
 		xrealloc (the_history, history_size * sizeof (HIST_ENTRY *));
+/* begin_clink_change */
+#else
+	      history_realloc (history_length + 2);
+#endif
+/* end_clink_change */
 	    }
 	  new_length = history_length + 1;
 	}
@@ -652,6 +754,14 @@ clear_history (void)
       the_history[i] = (HIST_ENTRY *)NULL;
     }
 
+/* begin_clink_change */
+  if (history_alloc)
+    {
+      history_set_alloc (history_alloc, history_alloc_size);
+      the_history[0] = (HIST_ENTRY *)NULL;
+    }
+/* end_clink_change */
+
   history_offset = history_length = 0;
   history_base = 1;		/* reset history base to default */
 }
@@ -91,6 +91,12 @@ extern void add_history (const char *);
    STRING. */
 extern void add_history_time (const char *);
 
+/* begin_clink_change */
+/* Make room for at least COUNT entries, so that adding that many entries
+   doesn't need to grow the history list. */
+extern void history_reserve (int);
+/* end_clink_change */
+
 /* Remove an entry from the history list.  WHICH is the magic number that
    tells us which element to delete.  The elements are numbered from 0. */
 extern HIST_ENTRY *remove_history (int);
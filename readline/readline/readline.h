@@ -914,7 +914,11 @@ extern const char *rl_special_prefixes;
 /* begin_clink_change */
 /* If non-zero, this is the address of a function to call when
    freeing a match list.  This can, for instance, allow a host to
-   free any data that it had associated with the match list. */
+   free any data that it had associated with the match list.  The
+   host may also free strings that it owns (e.g. strings packed into
+   a single arena allocation) and remove them from the list, as long
+   as the list stays NULL terminated; any strings that remain in the
+   list are freed individually afterwards. */
 extern rl_vcppfunc_t *rl_free_match_list_hook;
 /* end_clink_change */
 